@@ -16,7 +16,9 @@ Board::~Board() {
 
 Board::Board(const Board &other) :
 	_width(other._width),
-	_height(other._height)
+	_height(other._height),
+	_hash(other._hash),
+	_hash_valid(other._hash_valid)
 {
 	auto size = _width * _height;
 	_pieces = new Piece[size];
@@ -28,7 +30,9 @@ Board::Board(const Board &other) :
 Board::Board(Board &&other) :
 	_width(other._width),
 	_height(other._height),
-	_pieces(other._pieces)
+	_pieces(other._pieces),
+	_hash(other._hash),
+	_hash_valid(other._hash_valid)
 {
 	other._pieces = nullptr;
 }
@@ -50,6 +54,8 @@ Board &Board::operator = (const Board &rhs) {
 	}
 
 	memcpy(_pieces, rhs._pieces, _width * _height * sizeof (Piece));
+	_hash = rhs._hash;
+	_hash_valid = rhs._hash_valid;
 
 	return *this;
 }
@@ -64,6 +70,8 @@ Board &Board::operator = (Board &&rhs) {
 	_width = rhs._width;
 	_height = rhs._height;
 	_pieces = rhs._pieces;
+	_hash = rhs._hash;
+	_hash_valid = rhs._hash_valid;
 	rhs._pieces = nullptr;
 
 	return *this;
@@ -148,9 +156,30 @@ Piece Board::piece(Tile tile) const {
 }
 
 Piece &Board::piece(Tile tile) {
+	// the caller may write through the reference
+	_hash_valid = false;
 	return _pieces[tile[1] * _width + tile[0]];
 }
 
+const Piece *Board::pieces() const {
+	return _pieces;
+}
+
+uint64 Board::hash_value() const {
+	if (_hash_valid)
+		return _hash;
+
+	uint64 hash = 0;
+	for (Coord y = 0; y < _height; ++y)
+	for (Coord x = 0; x < _width; ++x) {
+		Tile tile(x, y);
+		hash ^= zobrist_piece_tile(piece(tile), tile, _width);
+	}
+	_hash = hash;
+	_hash_valid = true;
+	return hash;
+}
+
 // OPERATORS
 
 bool Board::operator == (const Board &rhs) const {
@@ -160,8 +189,12 @@ bool Board::operator == (const Board &rhs) const {
 	if (_width != rhs._width) return false;
 	if (_height != rhs._height) return false;
 
+	// differing hashes prove inequality, but only use them when known
+	if (_hash_valid && rhs._hash_valid && _hash != rhs._hash)
+		return false;
+
 	// compare per piece
-	if (!memcmp(_pieces, rhs._pieces, _width * _height * sizeof (Piece)))
+	if (memcmp(_pieces, rhs._pieces, _width * _height * sizeof (Piece)))
 		return false;
 
 	return true;
@@ -171,13 +204,23 @@ bool Board::operator != (const Board &rhs) const {
 	return !operator == (rhs);
 }
 
+void Board::setPiece(Tile tile, Piece p) {
+	Piece &target = _pieces[tile[1] * _width + tile[0]];
+	if (_hash_valid) {
+		_hash ^= zobrist_piece_tile(target, tile, _width);
+		_hash ^= zobrist_piece_tile(p, tile, _width);
+	}
+	target = p;
+}
+
 void Board::removePiece(Tile tile) {
-	piece(tile) = Piece::NONE;
+	setPiece(tile, Piece::NONE);
 }
 
 void Board::movePiece(Tile src, Tile dst) {
-	piece(dst) = piece(src);
-	piece(src) = Piece::NONE;
+	Piece p = _pieces[src[1] * _width + src[0]];
+	setPiece(dst, p);
+	setPiece(src, Piece::NONE);
 }
 
 bool Board::isInBound(Tile tile) const {
@@ -42,11 +42,15 @@ public:
 	Coord height() const;
 
 	Piece piece(Tile tile) const;
-	Piece &piece(Tile tile);
+	Piece &piece(Tile tile); // drops the cached hash
+
+	/// the raw row-major piece array, width() * height() entries
+	const Piece *pieces() const;
 
 	bool isInBound(Tile tile) const;
 
-	uint32 hash_value() const;
+	/// zobrist hash over all pieces on the board, cached between calls
+	uint64 hash_value() const;
 
 	// OPERATORS
 	inline Piece operator [] (Tile tile) const { return piece(tile); }
@@ -58,6 +62,8 @@ public:
 	// OPERATIONS
 	void resize();
 
+	// these keep a cached hash up to date instead of dropping it
+	void setPiece(Tile tile, Piece piece);
 	void removePiece(Tile tile);
 	void movePiece(Tile src, Tile dst);
 
@@ -72,6 +78,10 @@ private:
 	Coord _width = BOARD_WIDTH_DEFAULT;
 	Coord _height = BOARD_HEIGHT_DEFAULT;
 	Piece* _pieces = nullptr;
+
+	// lazily computed zobrist hash of _pieces, valid while _hash_valid
+	mutable uint64 _hash = 0;
+	mutable bool _hash_valid = false;
 };
 
 #endif // BOARD_HPP
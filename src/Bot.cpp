@@ -31,3 +31,13 @@ void Bot::update(Action a) {
     _game.action(a);
 }
 
+
+void Bot::set_book(std::shared_ptr<const PolyglotBook> book) {
+    _book = book;
+}
+
+bool Bot::book_action(Action &action) {
+    if (!_book)
+        return false;
+    return _book->choose(_game.current_situation(), _book_random(), action);
+}
@@ -2,6 +2,10 @@
 #define BOT_HPP
 
 #include "Game.hpp"
+#include "PolyglotBook.hpp"
+
+#include <memory>
+#include <random>
 
 class Bot {
 public:
@@ -20,8 +24,16 @@ public:
     virtual void update(Action);
     virtual Action next_action() = 0;
 
+    /// an opening book to play from before searching, may be shared
+    void set_book(std::shared_ptr<const PolyglotBook>);
+
 protected:
+    /// picks a weighted random book move, false if out of book
+    bool book_action(Action &);
+
     Game _game;
+    std::shared_ptr<const PolyglotBook> _book;
+    std::mt19937 _book_random{std::random_device()()};
 };
 
 #endif // BOT_HPP
@@ -0,0 +1,134 @@
+#include "BotPool.hpp"
+
+#include <algorithm>
+
+/// the answer to a search that never ran
+static Action no_action(const Situation &start, size_t actions) {
+	Player player = start.active_player();
+	if (actions % 2)
+		player = player == PLAYER_WHITE ? PLAYER_BLACK : PLAYER_WHITE;
+	return {player, DO_NOTHING, Board::INVALID_TILE, Board::INVALID_TILE, TYPE_NONE};
+}
+
+BotPool::BotPool(int workers, std::function<void(SpeedyBot &)> setup) :
+	_tt(std::make_shared<TranspositionTable>())
+{
+	for (int i = 0; i < std::max(workers, 1); ++i) {
+		std::unique_ptr<Worker> worker(new Worker());
+		worker->bot.set_verbose(false);
+		worker->bot.set_transposition_table(_tt);
+		worker->bot.set_stop_flag(&worker->stop);
+		if (setup)
+			setup(worker->bot);
+		_workers.push_back(std::move(worker));
+	}
+	// started only now, so no worker sees a half built pool
+	for (auto &worker : _workers)
+		worker->thread = std::thread(&BotPool::work, this, std::ref(*worker));
+}
+
+BotPool::~BotPool() {
+	cancel();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_shutdown = true;
+	}
+	_signal.notify_all();
+	for (auto &worker : _workers)
+		worker->thread.join();
+}
+
+std::future<Action> BotPool::submit(const Situation &situation, const SearchLimits &limits, ProgressCallback progress) {
+	auto promise = std::make_shared<std::promise<Action>>();
+	submit(situation, limits, [promise](const Action &action) {
+		promise->set_value(action);
+	}, progress);
+	return promise->get_future();
+}
+
+std::future<Action> BotPool::submit(const Game &game, const SearchLimits &limits, ProgressCallback progress) {
+	auto promise = std::make_shared<std::promise<Action>>();
+	submit(game, limits, [promise](const Action &action) {
+		promise->set_value(action);
+	}, progress);
+	return promise->get_future();
+}
+
+void BotPool::submit(const Situation &situation, const SearchLimits &limits, ResultCallback done, ProgressCallback progress) {
+	std::unique_ptr<Job> job(new Job{situation, {}, limits, done, progress});
+	push(std::move(job));
+}
+
+void BotPool::submit(const Game &game, const SearchLimits &limits, ResultCallback done, ProgressCallback progress) {
+	std::unique_ptr<Job> job(new Job{game.situation_at(0), {}, limits, done, progress});
+	for (int i = 1; i <= game.current_index(); ++i)
+		job->actions.push_back(game.action_at(i));
+	push(std::move(job));
+}
+
+void BotPool::push(std::unique_ptr<Job> job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_queue.push_back(std::move(job));
+	}
+	_signal.notify_one();
+}
+
+void BotPool::cancel() {
+	std::deque<std::unique_ptr<Job>> cancelled;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		cancelled.swap(_queue);
+		for (auto &worker : _workers) {
+			if (worker->busy)
+				worker->stop = true;
+		}
+	}
+	for (auto &job : cancelled) {
+		if (job->done)
+			job->done(no_action(job->start, job->actions.size()));
+	}
+}
+
+size_t BotPool::pending() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t busy = std::count_if(_workers.begin(), _workers.end(), [](const std::unique_ptr<Worker> &worker) {
+		return worker->busy;
+	});
+	return _queue.size() + busy;
+}
+
+std::shared_ptr<TranspositionTable> BotPool::transposition_table() const {
+	return _tt;
+}
+
+void BotPool::work(Worker &worker) {
+	while (true) {
+		std::unique_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_signal.wait(lock, [this]() { return _shutdown || !_queue.empty(); });
+			if (_shutdown)
+				return;
+			job = std::move(_queue.front());
+			_queue.pop_front();
+			// under the lock, so a cancel either finds the job queued or busy
+			worker.busy = true;
+			worker.stop = false;
+		}
+
+		SpeedyBot &bot = worker.bot;
+		bot.reset(job->start);
+		for (auto &action : job->actions)
+			bot.update(action);
+		bot.set_limits(job->limits);
+		bot.set_info_callback(job->progress);
+		Action action = bot.next_action();
+		bot.set_info_callback(nullptr);
+		if (job->done)
+			job->done(action);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		worker.busy = false;
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef BOT_POOL_HPP
+#define BOT_POOL_HPP
+
+#include "SpeedyBot.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Searches moves in the background on a fixed set of worker threads.
+ *
+ * Every worker keeps a SpeedyBot for its whole life, so a search costs no
+ * thread creation, and all of them share one transposition table.  A
+ * search is submitted with the position, or the game leading to it so
+ * repetitions are seen, and its limits.  The result comes as a future or
+ * through a callback, and a progress callback reports every completed
+ * iteration.  Callbacks are called on the worker thread.
+ */
+class BotPool {
+public:
+	typedef std::function<void(const SearchInfo &)> ProgressCallback;
+	typedef std::function<void(const Action &)> ResultCallback;
+
+	/** Starts the workers.  setup is called once for every worker's bot,
+	 * e.g. to give it a book or tablebases.
+	 */
+	BotPool(int workers = 1, std::function<void(SpeedyBot &)> setup = nullptr);
+	/// cancels what is left and waits for the workers
+	~BotPool();
+	BotPool(const BotPool &) = delete;
+	BotPool &operator = (const BotPool &) = delete;
+
+	std::future<Action> submit(const Situation &, const SearchLimits & = SearchLimits(), ProgressCallback = nullptr);
+	std::future<Action> submit(const Game &, const SearchLimits & = SearchLimits(), ProgressCallback = nullptr);
+	void submit(const Situation &, const SearchLimits &, ResultCallback, ProgressCallback = nullptr);
+	void submit(const Game &, const SearchLimits &, ResultCallback, ProgressCallback = nullptr);
+
+	/** Ends all submitted searches soon.  Running ones report the best action
+	 * found so far, waiting ones a DO_NOTHING action.
+	 */
+	void cancel();
+
+	/// number of submitted searches that have not finished
+	size_t pending() const;
+
+	std::shared_ptr<TranspositionTable> transposition_table() const;
+
+private:
+	struct Job {
+		Situation start;
+		/// played on start to reach the position to search
+		std::vector<Action> actions;
+		SearchLimits limits;
+		ResultCallback done;
+		ProgressCallback progress;
+	};
+
+	struct Worker {
+		SpeedyBot bot;
+		std::atomic<bool> stop{false};
+		bool busy = false;
+		std::thread thread;
+	};
+
+	void push(std::unique_ptr<Job>);
+	void work(Worker &);
+
+	std::shared_ptr<TranspositionTable> _tt;
+	std::vector<std::unique_ptr<Worker>> _workers;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _signal;
+	std::deque<std::unique_ptr<Job>> _queue;
+	bool _shutdown = false;
+};
+
+#endif // BOT_POOL_HPP
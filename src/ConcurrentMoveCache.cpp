@@ -0,0 +1,71 @@
+#include "ConcurrentMoveCache.hpp"
+
+#include "Rules.hpp"
+
+using std::lock_guard;
+using std::mutex;
+
+ConcurrentMoveCache::ConcurrentMoveCache(size_t budget, int shards) {
+	if (shards < 1)
+		shards = 1;
+	for (int i = 0; i < shards; ++i)
+		_shards.emplace_back(new Shard(budget / shards));
+}
+
+void ConcurrentMoveCache::clear() {
+	for (auto &shard : _shards) {
+		lock_guard<mutex> lock(shard->mutex);
+		shard->cache.clear();
+	}
+}
+
+void ConcurrentMoveCache::set_budget(size_t bytes) {
+	for (auto &shard : _shards) {
+		lock_guard<mutex> lock(shard->mutex);
+		shard->cache.set_budget(bytes / _shards.size());
+	}
+}
+
+ConcurrentMoveCache::ActionVector ConcurrentMoveCache::legal_moves(const Position &pos) {
+	ActionVector av;
+	legal_moves(pos, av);
+	return av;
+}
+
+void ConcurrentMoveCache::legal_moves(const Position &pos, ActionVector &av) {
+	uint64 hash = pos.hash_value();
+	Shard &s = shard(hash);
+	{
+		lock_guard<mutex> lock(s.mutex);
+		if (s.cache.probe(pos, hash, av))
+			return;
+	}
+
+	// other threads may generate the same moves meanwhile, the last one wins
+	Rules rules;
+	av.clear();
+	rules.getAllLegalMoves(pos, av);
+
+	lock_guard<mutex> lock(s.mutex);
+	s.cache.store(hash, av);
+}
+
+MoveCache::Stats ConcurrentMoveCache::stats() const {
+	MoveCache::Stats total = {0, 0, 0, 0};
+	for (auto &shard : _shards) {
+		lock_guard<mutex> lock(shard->mutex);
+		const MoveCache::Stats &stats = shard->cache.stats();
+		total.hits += stats.hits;
+		total.misses += stats.misses;
+		total.evictions += stats.evictions;
+		total.oversized += stats.oversized;
+	}
+	return total;
+}
+
+ConcurrentMoveCache::Shard &ConcurrentMoveCache::shard(uint64 hash) {
+	// the lower bits already select the bucket inside the shard
+	return *_shards[(hash >> 32) % _shards.size()];
+}
+
+ConcurrentMoveCache ConcurrentMoveCache::global;
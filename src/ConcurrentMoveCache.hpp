@@ -0,0 +1,53 @@
+#ifndef CONCURRENT_MOVE_CACHE_HPP
+#define CONCURRENT_MOVE_CACHE_HPP
+
+#include "MoveCache.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** A MoveCache that can be shared between threads.
+ *
+ * The budget is split evenly over a number of shards, each of which is an
+ * independent MoveCache guarded by its own mutex.  A position always lives
+ * in the shard selected by the upper half of its hash.  Moves are handed
+ * out as copies, and missing moves are generated outside of any lock.
+ */
+class ConcurrentMoveCache {
+public:
+
+	typedef MoveCache::ActionVector ActionVector;
+
+	static const int DEFAULT_SHARDS = 16;
+
+	ConcurrentMoveCache(size_t budget = MoveCache::DEFAULT_BUDGET, int shards = DEFAULT_SHARDS);
+	~ConcurrentMoveCache() = default;
+	ConcurrentMoveCache(const ConcurrentMoveCache &) = delete;
+	ConcurrentMoveCache &operator = (const ConcurrentMoveCache &) = delete;
+
+	void clear();
+	void set_budget(size_t bytes);
+
+	ActionVector legal_moves(const Position &);
+	void legal_moves(const Position &, ActionVector &);
+
+	/// the counters of all shards added up
+	MoveCache::Stats stats() const;
+
+	static ConcurrentMoveCache global;
+
+private:
+	struct Shard {
+		Shard(size_t budget) : cache(budget) {}
+
+		mutable std::mutex mutex;
+		MoveCache cache;
+	};
+
+	Shard &shard(uint64 hash);
+
+	std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+#endif // CONCURRENT_MOVE_CACHE_HPP
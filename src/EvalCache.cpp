@@ -0,0 +1,55 @@
+#include "EvalCache.hpp"
+
+EvalCache::EvalCache(size_t size) {
+	resize(size);
+}
+
+void EvalCache::resize(size_t size) {
+	size_t slots = 1;
+	while (slots * 2 <= size)
+		slots *= 2;
+
+	_entries.assign(slots, Entry{0, 0.0f, false, false});
+	_entries.shrink_to_fit();
+	_mask = slots - 1;
+	reset_counters();
+}
+
+void EvalCache::clear() {
+	for (auto &entry : _entries)
+		entry.used = false;
+	reset_counters();
+}
+
+size_t EvalCache::size() const {
+	return _entries.size();
+}
+
+bool EvalCache::probe(uint64 hash, float &rating, bool &mated) {
+	++_probes;
+	const Entry &entry = _entries[hash & _mask];
+	if (!entry.used || entry.hash != hash)
+		return false;
+
+	++_hits;
+	rating = entry.rating;
+	mated = entry.mated;
+	return true;
+}
+
+void EvalCache::store(uint64 hash, float rating, bool mated) {
+	_entries[hash & _mask] = Entry{hash, rating, mated, true};
+}
+
+uint64 EvalCache::probes() const {
+	return _probes;
+}
+
+uint64 EvalCache::hits() const {
+	return _hits;
+}
+
+void EvalCache::reset_counters() {
+	_probes = 0;
+	_hits = 0;
+}
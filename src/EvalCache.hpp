@@ -0,0 +1,55 @@
+#ifndef EVAL_CACHE_HPP
+#define EVAL_CACHE_HPP
+
+#include "stdtypes.hpp"
+
+#include <vector>
+
+/** Remembers the static evaluation of recently rated positions.
+ *
+ * The cache is direct-mapped: every position hash maps to exactly one slot
+ * and a newer entry simply overwrites the old one.  The full hash is stored
+ * in the slot, so a probe only hits if the hashes match exactly.
+ */
+class EvalCache {
+public:
+
+	static const size_t DEFAULT_SIZE = 1 << 16;
+
+	EvalCache(size_t size = DEFAULT_SIZE);
+	~EvalCache() = default;
+	EvalCache(const EvalCache &) = delete;
+	EvalCache &operator = (const EvalCache &) = delete;
+
+	/** Changes the number of slots.  The size is rounded down to a power of
+	 * two, all entries are dropped and the counters are reset.
+	 */
+	void resize(size_t size);
+	void clear();
+	size_t size() const;
+
+	/** Looks up a rating.  If the stored position was checkmated, mated is
+	 * set and the caller has to add its own distance penalty.
+	 */
+	bool probe(uint64 hash, float &rating, bool &mated);
+	void store(uint64 hash, float rating, bool mated);
+
+	uint64 probes() const;
+	uint64 hits() const;
+	void reset_counters();
+
+private:
+	struct Entry {
+		uint64 hash;
+		float rating;
+		bool mated;
+		bool used;
+	};
+
+	std::vector<Entry> _entries;
+	size_t _mask = 0;
+	uint64 _probes = 0;
+	uint64 _hits = 0;
+};
+
+#endif // EVAL_CACHE_HPP
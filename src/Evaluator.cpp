@@ -0,0 +1,192 @@
+#include "Evaluator.hpp"
+
+#include "Rules.hpp"
+#include "eval_tables.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// piece codes used by the batch rating, 0 is an empty tile
+static int piece_code(Piece p) {
+	if (p.type == TYPE_NONE)
+		return 0;
+	return 1 + p.player * 6 + p.type;
+}
+
+// PARAMETERS
+
+EvalParams EvalParams::standard() {
+	EvalParams params;
+	for (int type = 0; type < 6; ++type) {
+		params.piece_values[type] = PIECE_VALUES[type];
+		for (int x = 0; x < 8; ++x)
+		for (int y = 0; y < 8; ++y)
+			params.piece_pos_ratings[type][x][y] = PIECE_POS_RATINGS[type][x][y];
+	}
+	return params;
+}
+
+// LIFECYCLE
+
+Evaluator::Evaluator() :
+	Evaluator(EvalParams::standard())
+{
+	// nothing
+}
+
+Evaluator::Evaluator(const EvalParams &params) :
+	_params(params)
+{
+	// the batch tables are signed from white's point of view and the
+	// placement ratings are already mirrored for black pieces
+	for (int code = 0; code < NUM_CODES; ++code) {
+		int type = (code - 1) % 6;
+		float sign = code <= 6 ? 1.0f : -1.0f;
+		_batch.material[code] = code == 0 ? 0.0f : sign * _params.piece_values[type];
+		_batch.is_piece[code] = code == 0 ? 0.0f : 1.0f;
+		for (int y = 0; y < 8; ++y)
+		for (int x = 0; x < 8; ++x) {
+			int relative_y = code <= 6 ? y : 7 - y;
+			float rating = _params.piece_pos_ratings[type][x][relative_y];
+			_batch.placement[y * 8 + x][code] = code == 0 ? 0.0f : sign * rating;
+		}
+	}
+}
+
+const EvalParams &Evaluator::params() const {
+	return _params;
+}
+
+// RATING
+
+float Evaluator::rate(const Position &position, int dist) const {
+	Rules rules;
+	if(rules.getAllLegalMoves(position).size() == 0) {
+		if(rules.isPlayerInCheck(position, position.active_player()))
+			return VERY_BAD + dist;
+		else
+			return 0;
+	}
+
+	return rate_material(position);
+}
+
+float Evaluator::rate_material(const Position &position) const {
+	float material = 0;
+	float posRating = 0;
+	int numPieces = 0;
+	for (Coord y = 0; y < position.height(); ++y)
+	for (Coord x = 0; x < position.width(); ++x) {
+		Piece p = position[Tile(x,y)];
+
+		if(p.type == TYPE_NONE)
+			continue;
+
+		float factor = 1.0;
+		if(p.player != position.active_player())
+			factor = -1.0;
+
+		int relative_y = y;
+		if(p.player == PLAYER_BLACK)
+			relative_y = position.height() - y - 1;
+
+		material += _params.piece_values[p.type] * factor;
+		posRating += _params.piece_pos_ratings[p.type][x][relative_y] * factor;
+		numPieces++;
+	}
+
+	return material + posRating / numPieces;
+}
+
+// BATCH RATING
+
+void Evaluator::rate_batch(const Position *positions, size_t count, float *ratings, int threads) const {
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	size_t max_threads = std::max<size_t>(1, count / MIN_BATCH_PER_THREAD);
+	threads = (int)std::min<size_t>(threads, max_threads);
+
+	if (threads == 1) {
+		rate_block(positions, count, ratings);
+		return;
+	}
+
+	// every thread gets a contiguous slice, rounded to whole blocks
+	size_t slice = (count + threads - 1) / threads;
+	slice = (slice + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+
+	std::vector<std::thread> workers;
+	for (size_t begin = slice; begin < count; begin += slice) {
+		size_t n = std::min(slice, count - begin);
+		workers.emplace_back([=] {
+			rate_block(positions + begin, n, ratings + begin);
+		});
+	}
+	rate_block(positions, std::min(slice, count), ratings);
+
+	for (auto &worker : workers)
+		worker.join();
+}
+
+void Evaluator::rate_block(const Position *positions, size_t count, float *ratings) const {
+	const BatchTables &t = _batch;
+
+	// structure of arrays: one row of piece codes per tile, one column per position
+	uint8 codes[64][BATCH_LANES];
+	float side[BATCH_LANES];
+	float material[BATCH_LANES];
+	float placement[BATCH_LANES];
+	float pieces[BATCH_LANES];
+
+	for (size_t first = 0; first < count; first += BATCH_LANES) {
+		size_t lanes = std::min<size_t>(BATCH_LANES, count - first);
+
+		// transpose the positions into the block, unused lanes stay empty
+		for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+			bool used = lane < lanes;
+			const Position *position = used ? &positions[first + lane] : nullptr;
+			bool standard = used && position->width() == 8 && position->height() == 8;
+			for (int i = 0; i < 64; ++i)
+				codes[i][lane] = standard ? piece_code((*position)[Tile(i % 8, i / 8)]) : 0;
+			side[lane] = used && position->active_player() == PLAYER_BLACK ? -1.0f : 1.0f;
+			material[lane] = 0.0f;
+			placement[lane] = 0.0f;
+			pieces[lane] = 0.0f;
+		}
+
+		// the hot loop works on all lanes at once and is left to the vectorizer
+		for (int i = 0; i < 64; ++i) {
+			const uint8 *row = codes[i];
+			const float *row_placement = t.placement[i];
+			for (int lane = 0; lane < BATCH_LANES; ++lane) {
+				int code = row[lane];
+				material[lane] += t.material[code];
+				placement[lane] += row_placement[code];
+				pieces[lane] += t.is_piece[code];
+			}
+		}
+
+		for (int lane = 0; lane < BATCH_LANES; ++lane) {
+			float n = pieces[lane] > 0.0f ? pieces[lane] : 1.0f;
+			material[lane] = side[lane] * (material[lane] + placement[lane] / n);
+		}
+
+		// checkmate and stalemate need the move generator, one position at a time
+		Rules rules;
+		for (size_t lane = 0; lane < lanes; ++lane) {
+			const Position &position = positions[first + lane];
+			float &rating = ratings[first + lane];
+			if (rules.getAllLegalMoves(position).size() == 0) {
+				if (rules.isPlayerInCheck(position, position.active_player()))
+					rating = VERY_BAD;
+				else
+					rating = 0;
+			} else if (position.width() != 8 || position.height() != 8) {
+				rating = rate_material(position);
+			} else {
+				rating = material[lane];
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include "Position.hpp"
+
+/** The tunable numbers of the evaluation.
+ */
+struct EvalParams {
+	/// material value, indexed by Type
+	float piece_values[6];
+	/// placement rating, indexed by [Type][x][y], y relative to the owner
+	float piece_pos_ratings[6][8][8];
+
+	/// the hand-tuned values from eval_tables.hpp
+	static EvalParams standard();
+};
+
+/** Static rating of positions without any search.
+ *
+ * All ratings are given from the view of the active player.  Positive
+ * numbers are good for the player to move.
+ */
+class Evaluator {
+public:
+
+	/// rating of a player that has been checkmated (distance not included)
+	static constexpr float VERY_BAD = -9999999.0f;
+
+	// LIFECYCLE
+	Evaluator();
+	Evaluator(const EvalParams &);
+
+	const EvalParams &params() const;
+
+	/** Rates a single position.  dist is added to the rating of checkmated
+	 * players, so that shorter mates are preferred.
+	 */
+	float rate(const Position &, int dist = 0) const;
+
+	/** Only the material and placement part of the rating, without checking
+	 * for checkmate or stalemate.
+	 */
+	float rate_material(const Position &) const;
+
+	/** Rates count positions and writes the results to ratings, which must
+	 * have room for count floats.  The results are identical to rate() with
+	 * a distance of zero.
+	 *
+	 * The positions are rated in blocks of BATCH_LANES, which are stored as
+	 * structure of arrays, so the inner loops run over positions rather than
+	 * over tiles.  Large batches are split across threads.  If threads is
+	 * zero, one thread per hardware core is used.
+	 */
+	void rate_batch(const Position *positions, size_t count, float *ratings, int threads = 0) const;
+
+	static const int BATCH_LANES = 16;
+
+	/// batches smaller than this are never split across threads
+	static const size_t MIN_BATCH_PER_THREAD = 256;
+
+private:
+	/// number of piece codes in the batch tables, 0 is an empty tile
+	static const int NUM_CODES = 13;
+
+	/// lookup tables for the batch rating, indexed by piece code
+	struct BatchTables {
+		float material[NUM_CODES];
+		float placement[64][NUM_CODES];
+		float is_piece[NUM_CODES];
+	};
+
+	void rate_block(const Position *positions, size_t count, float *ratings) const;
+
+	EvalParams _params;
+	BatchTables _batch;
+};
+
+#endif // EVALUATOR_HPP
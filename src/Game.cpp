@@ -13,45 +13,126 @@ Game::Game(const Situation &situation) {
 // ACCESS
 
 const Situation &Game::current_situation() const {
-	return _history.back().situation;
+	return _current;
 }
 
 int Game::position_repetition_counter(const Position &position) const {
-	auto iter = _position_repetition.find(position);
-	if (iter == _position_repetition.end())
-		return 0;
-	else
-		return iter->second;
+	uint64 hash = position.hash_value();
+	int counter = 0;
+	for (int i = current_index(); i >= 0; --i) {
+		if (_history[i].hash == hash && is_position_at(i, position))
+			++counter;
+	}
+	return counter;
 }
 
 int Game::position_repetition_counter() const {
-	return position_repetition_counter(current_situation());
+	// positions before the last pawn move or capture can't be repeated
+	uint64 hash = _history.back().hash;
+	int counter = 0;
+	for (int i = current_index(); i >= 0; --i) {
+		const HistoryEntry &entry = _history[i];
+		if (entry.hash == hash && is_position_at(i, _current))
+			++counter;
+		if (entry.moved && entry.state.half_move_counter == 0)
+			break;
+	}
+	return counter;
+}
+
+int Game::history_size() const {
+	return (int)_history.size();
+}
+
+int Game::current_index() const {
+	return (int)_history.size() - 1;
+}
+
+Situation Game::situation_at(int index) const {
+	Situation situation;
+	situation_at(index, situation);
+	return situation;
 }
 
-const std::list<HistoryEntry> &Game::history() const {
-	return _history;
+void Game::situation_at(int index, Situation &situation) const {
+	if (index == current_index()) {
+		situation = _current;
+		return;
+	}
+
+	// replay at most SNAPSHOT_INTERVAL - 1 deltas from the last snapshot
+	int first = index / SNAPSHOT_INTERVAL * SNAPSHOT_INTERVAL;
+	situation = _snapshots[index / SNAPSHOT_INTERVAL];
+	for (int i = first + 1; i <= index; ++i) {
+		const HistoryEntry &entry = _history[i];
+		if (entry.moved)
+			situation.apply(entry.delta);
+		situation.restore(entry.state);
+	}
+}
+
+const Action &Game::action_at(int index) const {
+	return _history[index].action;
+}
+
+void Game::repetition_hashes(std::vector<uint64> &hashes) const {
+	int first = current_index();
+	while (first > 0) {
+		const HistoryEntry &entry = _history[first];
+		if (entry.moved && entry.state.half_move_counter == 0)
+			break;
+		--first;
+	}
+
+	for (int i = first; i <= current_index(); ++i) {
+		if (i == first || _history[i].moved)
+			hashes.push_back(_history[i].hash);
+	}
 }
 
 // OPERATION
 
 void Game::action(const Action &a, Delta *delta) {
-	Situation situation = current_situation();
-	situation.action(a, delta);
+	HistoryEntry entry{};
+	entry.action = a;
+	entry.moved = _current.action(a, &entry.delta);
+	entry.state = _current.state();
+	entry.hash = _current.hash_value();
+	if (delta)
+		*delta = entry.delta;
+
 	// add to history
-	_history.push_back({situation, a, (int)_history.size()});
-	// increment position repetition counter
-	++_position_repetition[situation];
+	_history.push_back(entry);
+	if (current_index() % SNAPSHOT_INTERVAL == 0)
+		push_snapshot();
 }
 
 void Game::seek(int number) {
-	int current = _history.back().index;
-	for (int i = current; i > number; --i)
-		pop();
+	if (number >= current_index())
+		return;
+
+	// short distances are undone step by step, longer ones from a snapshot
+	if (current_index() - number < SNAPSHOT_INTERVAL) {
+		while (current_index() > number)
+			pop();
+		return;
+	}
+
+	situation_at(number, _current);
+	_history.resize(number + 1);
+	_snapshot_count = number / SNAPSHOT_INTERVAL + 1;
 }
 
 void Game::pop() {
-	--_position_repetition[current_situation()];
+	if (current_index() % SNAPSHOT_INTERVAL == 0)
+		--_snapshot_count;
+
+	// undo the last action in place
+	const HistoryEntry &entry = _history.back();
+	if (entry.moved)
+		_current.apply(entry.delta);
 	_history.pop_back();
+	_current.restore(_history.back().state);
 }
 
 void Game::reset() {
@@ -61,9 +142,34 @@ void Game::reset() {
 
 void Game::reset(const Situation &situation) {
 	_history.clear();
-	_position_repetition.clear();
+	_snapshot_count = 0;
+	_current = situation;
+
 	const Tile invalid(situation.INVALID_TILE);
-	Action action = {PLAYER_NONE, DO_NOTHING, invalid, invalid};
-	_history.push_back(HistoryEntry{situation, action, 0});
-	++_position_repetition[situation];
+	HistoryEntry entry{};
+	entry.action = {PLAYER_NONE, DO_NOTHING, invalid, invalid, TYPE_NONE, NO_ANNOUNCEMENT};
+	entry.moved = false;
+	entry.state = situation.state();
+	entry.hash = situation.hash_value();
+	_history.push_back(entry);
+	push_snapshot();
+}
+
+// PRIVATE
+
+void Game::push_snapshot() {
+	// copying into an old slot reuses its board
+	if (_snapshot_count < (int)_snapshots.size())
+		_snapshots[_snapshot_count] = _current;
+	else
+		_snapshots.push_back(_current);
+	++_snapshot_count;
+}
+
+bool Game::is_position_at(int index, const Position &position) const {
+	if (index == current_index())
+		return static_cast<const Position &>(_current) == position;
+
+	situation_at(index, _scratch);
+	return static_cast<const Position &>(_scratch) == position;
 }
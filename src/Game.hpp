@@ -2,26 +2,27 @@
 #define GAME_HPP
 
 #include "Situation.hpp"
-#include "compare.hpp"
 
-#include <map>
-#include <unordered_map>
-#include <list>
+#include <vector>
 
 struct HistoryEntry {
-	/// The current position
-	Situation situation;
 	/// The action that lead to this position
 	Action action;
-	/// the numerical index of the current position, 0 being the initial pos
-	int index;
+	/// the changes made by the action, applying them again reverts them
+	Delta delta;
+	/// false if the action did not touch the board (e.g. announcements)
+	bool moved;
+	/// the remaining fields of the situation after the action
+	SituationState state;
+	/// Position::hash_value of the position after the action
+	uint64 hash;
 };
 
 class Game {
 public:
 
-	typedef std::list<HistoryEntry>::iterator HistoryIter;
-	typedef std::list<HistoryEntry>::const_iterator HistoryConstIter;
+	/// every this many plies a full copy of the situation is kept
+	static const int SNAPSHOT_INTERVAL = 32;
 
 	// LIFECYYCLE
 	Game(const Game &) = delete;
@@ -34,7 +35,26 @@ public:
 	int position_repetition_counter(const Position &) const;
 	int position_repetition_counter() const;
 
-	const std::list<HistoryEntry> &history() const;
+	/// number of positions in the history, including the initial one
+	int history_size() const;
+	/// index of the current position, 0 being the initial position
+	int current_index() const;
+
+	/** Reconstructs the situation at a given index from the closest earlier
+	 * snapshot.  The second form reuses the board of the given situation.
+	 */
+	Situation situation_at(int index) const;
+	void situation_at(int index, Situation &) const;
+
+	/// the action that lead to the position at index
+	const Action &action_at(int index) const;
+
+	/** Appends the hashes of all positions since the last pawn move or
+	 * capture, oldest first and ending with the current position.  Entries
+	 * that did not move a piece are skipped, so consecutive hashes belong
+	 * to alternating players.
+	 */
+	void repetition_hashes(std::vector<uint64> &) const;
 
 	// OPERATION
 	void action(const Action &action, Delta *delta = nullptr);
@@ -45,11 +65,21 @@ public:
 	void reset(const Situation &);
 
 private:
-	/// contains all past positions and corresponding moves
-	std::list<HistoryEntry> _history;
-	/// track the number of times each position has occured
-	std::map<Position, int, PositionCompare> _position_repetition;
-	//std::unordered_map<Position, int, PositionHash> _position_repetition;
+	void push_snapshot();
+
+	/// exact comparison of the position at index with the given one
+	bool is_position_at(int index, const Position &) const;
+
+	/// the situation after the last action
+	Situation _current;
+	/// one entry per position, the first one holds the initial position
+	std::vector<HistoryEntry> _history;
+	/// the situation at every multiple of SNAPSHOT_INTERVAL, slots beyond
+	/// _snapshot_count are kept so their boards can be reused
+	std::vector<Situation> _snapshots;
+	int _snapshot_count = 0;
+	/// scratch space for rebuilding past positions
+	mutable Situation _scratch;
 };
 
 #endif // GAME_HPP
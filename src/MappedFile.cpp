@@ -0,0 +1,123 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const char *path, Access access) {
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, access == RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_size = (size_t)size.QuadPart;
+	_open = true;
+	if (_size == 0)
+		return true;
+
+	_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping)
+		_data = (const char *)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!_data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file)
+		CloseHandle(_file);
+	_data = nullptr;
+	_mapping = nullptr;
+	_file = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+#else
+
+bool MappedFile::open(const char *path, Access access) {
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	_size = (size_t)st.st_size;
+	if (_size > 0) {
+		void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			_size = 0;
+			return false;
+		}
+		madvise(data, _size, access == RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+		_data = (const char *)data;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	_open = true;
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data)
+		munmap((void *)_data, _size);
+	_data = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+#endif
+
+bool MappedFile::is_open() const {
+	return _open;
+}
+
+const char *MappedFile::data() const {
+	return _data;
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+const char *MappedFile::begin() const {
+	return _data;
+}
+
+const char *MappedFile::end() const {
+	return _data + _size;
+}
@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include "stdtypes.hpp"
+
+/** A read-only view of a whole file, mapped into memory.
+ *
+ * Pages are loaded by the operating system as they are touched, so large
+ * files can be processed at disk speed without reading them into buffers
+ * first.  The access pattern is passed on as a hint for read-ahead.
+ */
+class MappedFile {
+public:
+	enum Access {
+		SEQUENTIAL,
+		RANDOM,
+	};
+
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator = (const MappedFile &) = delete;
+
+	/// maps the file, returns false if it can't be opened or mapped
+	bool open(const char *path, Access access = SEQUENTIAL);
+	void close();
+
+	bool is_open() const;
+
+	/// nullptr for empty files
+	const char *data() const;
+	size_t size() const;
+
+	const char *begin() const;
+	const char *end() const;
+
+private:
+	const char *_data = nullptr;
+	size_t _size = 0;
+	bool _open = false;
+#if defined(_WIN32)
+	void *_file = nullptr;
+	void *_mapping = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_HPP
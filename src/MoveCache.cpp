@@ -2,27 +2,152 @@
 
 #include "Rules.hpp"
 
-#include <memory>
-
-using std::move;
+MoveCache::MoveCache(size_t budget) {
+	set_budget(budget);
+}
 
 void MoveCache::clear() {
-	_cache.clear();
+	for (auto &slot : _slots) {
+		slot.used = false;
+		slot.referenced = false;
+	}
+	for (auto &hand : _hands)
+		hand = 0;
+	reset_stats();
 }
 
-const MoveCache::ActionVector &MoveCache::legal_moves(const Position &pos) {
-    Rules rules;
+void MoveCache::set_budget(size_t bytes) {
+	size_t bucket_size = WAYS * sizeof (Slot) + sizeof (uint8);
+	size_t buckets = 1;
+	while (buckets * 2 * bucket_size <= bytes)
+		buckets *= 2;
+
+	_slots.assign(buckets * WAYS, Slot());
+	_slots.shrink_to_fit();
+	_hands.assign(buckets, 0);
+	_hands.shrink_to_fit();
+	_bucket_mask = buckets - 1;
+	_budget = bytes;
+	clear();
+}
+
+size_t MoveCache::budget() const {
+	return _budget;
+}
+
+size_t MoveCache::capacity() const {
+	return _slots.size();
+}
 
-	auto iter = _cache.find(pos);
-	if (iter == _cache.end()) {
-		ActionVector av;
-		rules.getAllLegalMoves(pos, av);
-		auto result = _cache.emplace(pos, av);
+MoveCache::ActionVector MoveCache::legal_moves(const Position &pos) {
+	ActionVector av;
+	legal_moves(pos, av);
+	return av;
+}
+
+void MoveCache::legal_moves(const Position &pos, ActionVector &av) {
+	uint64 hash = pos.hash_value();
+	if (probe(pos, hash, av))
+		return;
+
+	Rules rules;
+	av.clear();
+	rules.getAllLegalMoves(pos, av);
+	store(hash, av);
+}
+
+bool MoveCache::probe(const Position &pos, uint64 hash, ActionVector &av) {
+	Slot *slot = find(hash);
+	if (!slot) {
+		++_stats.misses;
+		return false;
+	}
+
+	++_stats.hits;
+	slot->referenced = true;
+	av.clear();
+	for (int i = 0; i < slot->count; ++i)
+		av.push_back(unpack(pos, slot->moves[i]));
+	return true;
+}
 
-		return result.first->second;
-	} else {
-		return iter->second;
+void MoveCache::store(uint64 hash, const ActionVector &av) {
+	if (av.size() > (size_t)MAX_MOVES) {
+		++_stats.oversized;
+		return;
 	}
+
+	Slot *slot = find(hash);
+	if (!slot) {
+		size_t bucket = hash & _bucket_mask;
+		Slot *ways = &_slots[bucket * WAYS];
+
+		// prefer a free slot, otherwise run the clock hand
+		for (int i = 0; i < WAYS && !slot; ++i)
+			if (!ways[i].used)
+				slot = &ways[i];
+		uint8 &hand = _hands[bucket];
+		while (!slot) {
+			Slot &candidate = ways[hand];
+			hand = (hand + 1) % WAYS;
+			if (candidate.referenced) {
+				candidate.referenced = false;
+			} else {
+				slot = &candidate;
+				++_stats.evictions;
+			}
+		}
+	}
+
+	slot->hash = hash;
+	slot->used = true;
+	slot->referenced = false;
+	slot->count = (uint8)av.size();
+	for (size_t i = 0; i < av.size(); ++i)
+		slot->moves[i] = pack(av[i]);
+}
+
+const MoveCache::Stats &MoveCache::stats() const {
+	return _stats;
+}
+
+void MoveCache::reset_stats() {
+	_stats = Stats{0, 0, 0, 0};
+}
+
+/* bits  0 -  5: source tile (y * 8 + x)
+ * bits  6 - 11: destination tile
+ * bits 12 - 13: move type, counted from MOVE_PIECE
+ * bits 14 - 15: promotion type, counted from TYPE_QUEEN
+ * Whether a move is a promotion at all follows from the position.
+ */
+uint16 MoveCache::pack(const Action &a) {
+	uint16 src = a.src[1] * 8 + a.src[0];
+	uint16 dst = a.dst[1] * 8 + a.dst[0];
+	uint16 type = a.type - MOVE_PIECE;
+	uint16 promotion = a.promotion == TYPE_NONE ? 0 : a.promotion - TYPE_QUEEN;
+	return src | dst << 6 | type << 12 | promotion << 14;
+}
+
+Action MoveCache::unpack(const Position &pos, uint16 packed) {
+	Tile src(Coord(packed & 7), Coord(packed >> 3 & 7));
+	Tile dst(Coord(packed >> 6 & 7), Coord(packed >> 9 & 7));
+	MoveType type = static_cast<MoveType>(MOVE_PIECE + (packed >> 12 & 3));
+
+	Type promotion = TYPE_NONE;
+	bool last_row = dst[1] == 0 || dst[1] == pos.height() - 1;
+	if (pos[src].type == TYPE_PAWN && last_row)
+		promotion = static_cast<Type>(TYPE_QUEEN + (packed >> 14 & 3));
+
+	return {pos.active_player(), type, src, dst, promotion, NO_ANNOUNCEMENT};
+}
+
+MoveCache::Slot *MoveCache::find(uint64 hash) {
+	Slot *ways = &_slots[(hash & _bucket_mask) * WAYS];
+	for (int i = 0; i < WAYS; ++i)
+		if (ways[i].used && ways[i].hash == hash)
+			return &ways[i];
+	return nullptr;
 }
 
 MoveCache MoveCache::global;
@@ -3,28 +3,85 @@
 
 #include "Position.hpp"
 #include "Action.hpp"
-#include "compare.hpp"
 
 #include <vector>
-#include <map>
 
+/** Remembers the legal moves of positions within a fixed memory budget.
+ *
+ * Entries are keyed by Position::hash_value and grouped into buckets of
+ * WAYS slots.  When a bucket is full, a CLOCK sweep over the bucket evicts
+ * the first slot that has not been used since the hand last passed it.
+ * Moves are stored packed into 16 bits each, positions with more than
+ * MAX_MOVES legal moves are not cached.  Only 8x8 boards are supported.
+ */
 class MoveCache {
 public:
 
 	typedef std::vector<Action> ActionVector;
 
-	MoveCache() = default;
+	static const size_t DEFAULT_BUDGET = 16 << 20;
+	static const int WAYS = 4;
+	static const int MAX_MOVES = 80;
+
+	struct Stats {
+		uint64 hits;
+		uint64 misses;
+		uint64 evictions;
+		/// misses that could not be stored because of too many moves
+		uint64 oversized;
+	};
+
+	MoveCache(size_t budget = DEFAULT_BUDGET);
 	~MoveCache() = default;
 	MoveCache(const MoveCache &) = delete;
 	MoveCache &operator = (const MoveCache &) = delete;
 
 	void clear();
-	const ActionVector &legal_moves(const Position &);
+
+	/** Changes the memory budget in bytes, which drops all entries.  At least
+	 * one bucket is always allocated.
+	 */
+	void set_budget(size_t bytes);
+	size_t budget() const;
+	/// number of positions that fit into the cache
+	size_t capacity() const;
+
+	/// the legal moves of a position, generated and stored on a miss
+	ActionVector legal_moves(const Position &);
+	void legal_moves(const Position &, ActionVector &);
+
+	/** Looks up the moves of a position without generating them.  hash must
+	 * be the hash_value of the position.
+	 */
+	bool probe(const Position &, uint64 hash, ActionVector &);
+	void store(uint64 hash, const ActionVector &);
+
+	const Stats &stats() const;
+	void reset_stats();
+
+	/// pack a legal action on an 8x8 board into 16 bits and back
+	static uint16 pack(const Action &);
+	static Action unpack(const Position &, uint16);
 
 	static MoveCache global;
 
 private:
-	std::map<Position, ActionVector, PositionCompare> _cache;
+	struct Slot {
+		uint64 hash;
+		uint8 count;
+		bool used;
+		bool referenced;
+		uint16 moves[MAX_MOVES];
+	};
+
+	Slot *find(uint64 hash);
+
+	std::vector<Slot> _slots;
+	/// position of the CLOCK hand in every bucket
+	std::vector<uint8> _hands;
+	size_t _bucket_mask = 0;
+	size_t _budget = 0;
+	Stats _stats;
 };
 
 #endif // MOVE_CACHE_HPP
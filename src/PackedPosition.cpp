@@ -0,0 +1,74 @@
+#include "PackedPosition.hpp"
+
+#include <cstring>
+
+bool PackedPosition::pack(const Situation &situation, int full_move) {
+	if (situation.width() != 8 || situation.height() != 8)
+		return false;
+
+	occupancy = 0;
+	memset(pieces, 0, sizeof pieces);
+	const Piece *board = situation.pieces();
+	int count = 0;
+	for (int i = 0; i < 64; ++i) {
+		Piece piece = board[i];
+		if (piece.type == TYPE_NONE)
+			continue;
+		if (count == 32)
+			return false;
+		uint8 code = piece.player * 6 + piece.type;
+		pieces[count / 2] |= count % 2 ? code << 4 : code;
+		occupancy |= (uint64)1 << i;
+		++count;
+	}
+
+	flags = situation.active_player() == PLAYER_BLACK ? FLAG_BLACK_TO_MOVE : 0;
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		if (situation.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)))
+			flags |= 1 << (FLAG_CASTLING_SHIFT + p * 2 + c);
+	}
+
+	en_passant_file = situation.en_passant_file();
+	int half_moves = situation.half_move_counter();
+	half_move_counter = half_moves > 255 ? 255 : half_moves;
+	result = RESULT_NONE;
+	score = SCORE_NONE;
+	full_move_number = full_move;
+	return true;
+}
+
+bool PackedPosition::unpack(Situation &situation) const {
+	if (situation.width() != 8 || situation.height() != 8)
+		static_cast<Board &>(situation) = Board();
+
+	int count = 0;
+	for (int i = 0; i < 64; ++i) {
+		Piece &piece = situation[Tile(i % 8, i / 8)];
+		if (!(occupancy & ((uint64)1 << i))) {
+			piece = Piece::NONE;
+			continue;
+		}
+		if (count == 32)
+			return false;
+		uint8 code = pieces[count / 2];
+		code = count % 2 ? code >> 4 : code & 0x0F;
+		if (code >= 12)
+			return false;
+		piece = Piece{static_cast<Player>(code / 6), static_cast<Type>(code % 6)};
+		++count;
+	}
+
+	situation.active_player() = flags & FLAG_BLACK_TO_MOVE ? PLAYER_BLACK : PLAYER_WHITE;
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		bool right = flags & (1 << (FLAG_CASTLING_SHIFT + p * 2 + c));
+		situation.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)) = right;
+	}
+
+	if (en_passant_file < -1 || en_passant_file >= 8)
+		return false;
+	situation.en_passant_file() = en_passant_file;
+	situation.restore(SituationState{half_move_counter, false, false, PLAYER_NONE});
+	return true;
+}
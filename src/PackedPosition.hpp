@@ -0,0 +1,52 @@
+#ifndef PACKED_POSITION_HPP
+#define PACKED_POSITION_HPP
+
+#include "Situation.hpp"
+
+/** A situation on an 8x8 board packed into 32 bytes, for datasets.
+ *
+ * Bit i of occupancy is set if there is a piece on tile (i % 8, i / 8).
+ * The pieces on those tiles follow in the same order, one nibble each,
+ * lower nibble first; a nibble holds player * 6 + type.  Positions with
+ * more than 32 pieces can't be packed.  The score and result are optional
+ * labels, both from white's point of view.
+ *
+ * Records are stored as they are in memory and are meant to be read on
+ * little-endian machines.
+ */
+struct PackedPosition {
+	static const int8 RESULT_NONE = -128;
+	static const int16 SCORE_NONE = -32768;
+
+	static const uint8 FLAG_BLACK_TO_MOVE = 0x01;
+	/// castling rights start at this bit, in the order of Delta::castling_xor
+	static const int FLAG_CASTLING_SHIFT = 1;
+
+	uint64 occupancy;
+	uint8 pieces[16];
+	uint8 flags;
+	/// -1 if there is no en passant chance
+	int8 en_passant_file;
+	/// clamped to 255
+	uint8 half_move_counter;
+	/// 1 for a white win, 0 for a draw, -1 for a black win, or RESULT_NONE
+	int8 result;
+	/// in centipawns, or SCORE_NONE
+	int16 score;
+	uint16 full_move_number;
+
+	/** Fills in all fields but the labels, which are set to RESULT_NONE and
+	 * SCORE_NONE.  Returns false if the board is not 8x8 or has more than
+	 * 32 pieces.
+	 */
+	bool pack(const Situation &, int full_move_number = 1);
+
+	/** Restores a situation.  Returns false if the record holds invalid
+	 * pieces, in which case the situation is left in an unspecified state.
+	 */
+	bool unpack(Situation &) const;
+};
+
+static_assert(sizeof (PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+#endif // PACKED_POSITION_HPP
@@ -0,0 +1,336 @@
+#include "PgnReader.hpp"
+
+#include "fen.hpp"
+#include "san.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+/// characters that end a move or result token
+static bool is_delimiter(char c) {
+	switch (c) {
+	case ' ': case '\t': case '\r': case '\n':
+	case '{': case '}': case '(': case ')': case ';': case '[': case ']': case '$':
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool token_is(const char *s, const char *e, const char *token) {
+	size_t length = strlen(token);
+	return (size_t)(e - s) == length && !memcmp(s, token, length);
+}
+
+PgnReader::PgnReader(const char *begin, const char *end, int line) :
+	_s(begin),
+	_end(end),
+	_line(line),
+	_line_begin(begin)
+{
+	fen_parse(FEN_STANDARD, _standard);
+}
+
+int PgnReader::line() const {
+	return _line;
+}
+
+bool PgnReader::next(PgnGame &game, PgnError &error) {
+	error = PgnError{0, 0, nullptr};
+
+	skip_space();
+	if (_s == _end)
+		return false;
+
+	game.line = _line;
+	game.start = _standard;
+	game.start_full_move = 1;
+	game.actions.clear();
+	game.result = PGN_RESULT_UNKNOWN;
+
+	// tag section
+	while (_s < _end && *_s == '[') {
+		read_tag(game, error);
+		skip_space();
+	}
+
+	// movetext, after an error the rest of the game is only skipped
+	_current = game.start;
+	Action action;
+	while (true) {
+		skip_space();
+		if (_s == _end) {
+			fail(error, _s, "missing result");
+			return true;
+		}
+
+		char c = *_s;
+		if (c == '[' && _s == _line_begin) {
+			// the tags of the next game
+			fail(error, _s, "missing result");
+			return true;
+		}
+		if (c == '{') {
+			skip_comment(error);
+			continue;
+		}
+		if (c == ';') {
+			skip_line();
+			continue;
+		}
+		if (c == '(') {
+			skip_variation(error);
+			continue;
+		}
+		if (c == '$') {
+			++_s;
+			while (_s < _end && is_digit(*_s))
+				++_s;
+			continue;
+		}
+		if (is_delimiter(c)) {
+			fail(error, _s, "unexpected character");
+			++_s;
+			continue;
+		}
+
+		const char *e = token_end();
+
+		// game termination
+		PgnResult result = PGN_RESULT_UNKNOWN;
+		bool is_result = true;
+		if (token_is(_s, e, "1-0"))
+			result = PGN_WHITE_WINS;
+		else if (token_is(_s, e, "0-1"))
+			result = PGN_BLACK_WINS;
+		else if (token_is(_s, e, "1/2-1/2"))
+			result = PGN_DRAW;
+		else if (!token_is(_s, e, "*"))
+			is_result = false;
+		if (is_result) {
+			game.result = result;
+			_s = e;
+			return true;
+		}
+
+		// move numbers, possibly glued to the move ("1.e4")
+		if (is_digit(c)) {
+			const char *t = _s;
+			while (t < e && is_digit(*t))
+				++t;
+			if (t < e && *t == '.') {
+				while (t < e && *t == '.')
+					++t;
+			} else {
+				fail(error, _s, "unexpected number");
+				t = e;
+			}
+			_s = t;
+			continue;
+		}
+
+		if (error.message || token_is(_s, e, "e.p.")) {
+			_s = e;
+			continue;
+		}
+
+		const char *message = san_parse(_current, _s, e, action);
+		if (message) {
+			fail(error, _s, message);
+		} else {
+			_current.action(action);
+			game.actions.push_back(action);
+		}
+		_s = e;
+	}
+}
+
+const char *PgnReader::find_game(const char *begin, const char *from, const char *end) {
+	// start at the beginning of a line
+	const char *s = from;
+	if (s > begin && s[-1] != '\n') {
+		s = (const char *)memchr(s, '\n', end - s);
+		if (!s)
+			return end;
+		++s;
+	}
+
+	while (s < end) {
+		if (*s == '[') {
+			bool after_tag = false;
+			if (s > begin) {
+				const char *previous = s - 1;
+				while (previous > begin && previous[-1] != '\n')
+					--previous;
+				after_tag = *previous == '[';
+			}
+			if (!after_tag)
+				return s;
+		}
+		s = (const char *)memchr(s, '\n', end - s);
+		if (!s)
+			return end;
+		++s;
+	}
+	return end;
+}
+
+void PgnReader::split(const char *begin, const char *end, size_t count, std::vector<const char *> &cuts) {
+	cuts.clear();
+	cuts.push_back(begin);
+	size_t size = end - begin;
+	for (size_t i = 1; i < count && cuts.back() < end; ++i) {
+		const char *from = std::max(begin + size / count * i, cuts.back() + 1);
+		cuts.push_back(find_game(begin, from, end));
+	}
+	if (cuts.back() < end)
+		cuts.push_back(end);
+	if (cuts.size() == 1)
+		cuts.push_back(end);
+}
+
+bool PgnReader::read_tag(PgnGame &game, PgnError &error) {
+	const char *eol = (const char *)memchr(_s, '\n', _end - _s);
+	if (!eol)
+		eol = _end;
+
+	// [Name "value"]
+	const char *s = _s + 1;
+	while (s < eol && (*s == ' ' || *s == '\t'))
+		++s;
+	const char *name = s;
+	while (s < eol && !is_delimiter(*s) && *s != '"')
+		++s;
+	const char *name_end = s;
+	while (s < eol && (*s == ' ' || *s == '\t'))
+		++s;
+	if (name == name_end || s == eol || *s != '"') {
+		fail(error, s, "malformed tag");
+		skip_line();
+		return false;
+	}
+	const char *value = ++s;
+	while (s < eol && *s != '"') {
+		if (*s == '\\' && s + 1 < eol)
+			++s;
+		++s;
+	}
+	const char *value_end = s;
+	if (s == eol || (const char *)memchr(s, ']', eol - s) == nullptr) {
+		fail(error, s, "malformed tag");
+		skip_line();
+		return false;
+	}
+
+	if (token_is(name, name_end, "FEN")) {
+		const char *rest = fen_parse(value, value_end, game.start, &game.start_full_move);
+		while (rest && rest < value_end && (*rest == ' ' || *rest == '\t'))
+			++rest;
+		if (rest != value_end) {
+			fail(error, value, "invalid FEN");
+			skip_line();
+			return false;
+		}
+	}
+
+	skip_line();
+	return true;
+}
+
+void PgnReader::fail(PgnError &error, const char *where, const char *message) {
+	// only the first error of a game is reported
+	if (error.message)
+		return;
+	error.line = _line;
+	error.column = (int)(where - _line_begin) + 1;
+	error.message = message;
+}
+
+void PgnReader::skip_line() {
+	const char *eol = (const char *)memchr(_s, '\n', _end - _s);
+	if (!eol) {
+		_s = _end;
+		return;
+	}
+	_s = eol + 1;
+	_line_begin = _s;
+	++_line;
+}
+
+void PgnReader::skip_space() {
+	while (_s < _end) {
+		char c = *_s;
+		if (c == '\n') {
+			++_s;
+			_line_begin = _s;
+			++_line;
+		} else if (c == ' ' || c == '\t' || c == '\r') {
+			++_s;
+		} else if (c == '%' && _s == _line_begin) {
+			// escaped line
+			skip_line();
+		} else {
+			break;
+		}
+	}
+}
+
+bool PgnReader::skip_comment(PgnError &error) {
+	const char *begin = _s;
+	int line = _line;
+	const char *line_begin = _line_begin;
+	for (++_s; _s < _end && *_s != '}'; ++_s) {
+		if (*_s == '\n') {
+			_line_begin = _s + 1;
+			++_line;
+		}
+	}
+	if (_s == _end) {
+		if (!error.message)
+			error = PgnError{line, (int)(begin - line_begin) + 1, "unterminated comment"};
+		return false;
+	}
+	++_s;
+	return true;
+}
+
+bool PgnReader::skip_variation(PgnError &error) {
+	const char *begin = _s;
+	int line = _line;
+	const char *line_begin = _line_begin;
+	int depth = 0;
+	while (_s < _end) {
+		char c = *_s;
+		if (c == '{') {
+			if (!skip_comment(error))
+				return false;
+			continue;
+		}
+		if (c == '\n') {
+			_line_begin = _s + 1;
+			++_line;
+		} else if (c == '(') {
+			++depth;
+		} else if (c == ')') {
+			if (--depth == 0) {
+				++_s;
+				return true;
+			}
+		}
+		++_s;
+	}
+	if (!error.message)
+		error = PgnError{line, (int)(begin - line_begin) + 1, "unterminated variation"};
+	return false;
+}
+
+const char *PgnReader::token_end() const {
+	const char *e = _s;
+	while (e < _end && !is_delimiter(*e))
+		++e;
+	return e;
+}
@@ -0,0 +1,87 @@
+#ifndef PGN_READER_HPP
+#define PGN_READER_HPP
+
+#include "Situation.hpp"
+
+#include <vector>
+
+enum PgnResult : int8 {
+	PGN_RESULT_UNKNOWN, // "*"
+	PGN_WHITE_WINS,     // "1-0"
+	PGN_BLACK_WINS,     // "0-1"
+	PGN_DRAW,           // "1/2-1/2"
+};
+
+/** One game as read from a PGN file.  Reading into the same object again
+ * reuses its memory.
+ */
+struct PgnGame {
+	/// line of the first tag or move of the game
+	int line;
+	/// the position before the first move, from the FEN tag if there is one
+	Situation start;
+	int start_full_move;
+	/// the moves of the main line, variations are skipped
+	std::vector<Action> actions;
+	PgnResult result;
+};
+
+struct PgnError {
+	int line;
+	int column;
+	/// a static string, nullptr if there was no error
+	const char *message;
+};
+
+/** Reads games one after another from PGN text in memory.
+ *
+ * Tags other than FEN are skipped, as are comments, variations, NAGs and
+ * move numbers.  Every move is resolved with san_parse and played on the
+ * board, so a game that reads without error is legal.  Line numbers are
+ * counted from the line given to the constructor, which lets several
+ * readers work on parts of the same file.
+ */
+class PgnReader {
+public:
+	PgnReader(const char *begin, const char *end, int line = 1);
+
+	/** Reads the next game.  Returns false when there are no more games.
+	 * A malformed or illegal game is still returned, with error.message set
+	 * and the moves up to the error; the reader then skips to the next game.
+	 */
+	bool next(PgnGame &, PgnError &);
+
+	/// the current line, after all games have been read the number of lines
+	int line() const;
+
+	/** Finds the beginning of the first game that starts at or after from:
+	 * a tag line that does not follow another tag line.  Returns end if
+	 * there is none.  Used to split files for parallel reading.
+	 */
+	static const char *find_game(const char *begin, const char *from, const char *end);
+
+	/** Splits text into at most count parts of about equal size at game
+	 * boundaries.  Part i is [cuts[i], cuts[i + 1]).
+	 */
+	static void split(const char *begin, const char *end, size_t count, std::vector<const char *> &cuts);
+
+private:
+	bool read_tag(PgnGame &, PgnError &);
+	void fail(PgnError &, const char *where, const char *message);
+	void skip_line();
+	void skip_space();
+	bool skip_comment(PgnError &);
+	bool skip_variation(PgnError &);
+	const char *token_end() const;
+
+	const char *_s;
+	const char *_end;
+	int _line;
+	const char *_line_begin;
+
+	/// the starting position of a standard game, and the board moves are played on
+	Situation _standard;
+	Situation _current;
+};
+
+#endif // PGN_READER_HPP
@@ -0,0 +1,237 @@
+#include "PolyglotBook.hpp"
+
+#include "Rules.hpp"
+#include "Situation.hpp"
+#include "fen.hpp"
+#include "polyglot_keys.hpp"
+
+#include <cstdio>
+
+static_assert(sizeof POLYGLOT_RANDOM64 / sizeof POLYGLOT_RANDOM64[0] == PolyglotBook::NUM_KEYS,
+		"one random number per piece and square, castling right, en passant file and turn");
+
+static const int KEY_CASTLING = 768;
+static const int KEY_EN_PASSANT = 772;
+static const int KEY_TURN = 780;
+
+// the black piece of each type, the white one follows directly; by Type
+static const int PIECE_KIND[6] = {10, 8, 6, 4, 2, 0};
+
+// promotion piece in bits 12 to 14 of a move, by Type
+static const int PROMOTION_CODE[6] = {0, 4, 3, 2, 1, 0};
+static const Type PROMOTION_TYPE[5] = {TYPE_NONE, TYPE_KNIGHT, TYPE_BISHOP, TYPE_ROOK, TYPE_QUEEN};
+
+// positions and keys from the description of the format
+static const struct {
+	const char *fen;
+	uint64 key;
+} KEY_TESTS[] = {
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9cULL},
+	{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196ULL},
+	{"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0ULL},
+	{"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4ULL},
+	{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78ULL},
+	{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1ULL},
+	{"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9ULL},
+	{"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637ULL},
+	{"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560ULL},
+};
+
+static uint64 read_be(const uint8 *s, int bytes) {
+	uint64 value = 0;
+	for (int i = 0; i < bytes; ++i)
+		value = value << 8 | s[i];
+	return value;
+}
+
+static uint64 standard_key(const Position &position) {
+	const uint64 *keys = POLYGLOT_RANDOM64;
+	uint64 key = 0;
+	const Piece *pieces = position.pieces();
+	for (int i = 0; i < 64; ++i) {
+		Piece piece = pieces[i];
+		if (piece.type == TYPE_NONE)
+			continue;
+		int kind = PIECE_KIND[piece.type] + (piece.player == PLAYER_WHITE ? 1 : 0);
+		key ^= keys[64 * kind + i];
+	}
+
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		if (position.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)))
+			key ^= keys[KEY_CASTLING + p * 2 + c];
+	}
+
+	// Position only keeps en passant files where a capture is possible,
+	// which is exactly when Polyglot includes them
+	if (position.en_passant_file() >= 0)
+		key ^= keys[KEY_EN_PASSANT + position.en_passant_file()];
+
+	if (position.active_player() == PLAYER_WHITE)
+		key ^= keys[KEY_TURN];
+
+	return key;
+}
+
+// BOOK
+
+bool PolyglotBook::open(const char *path) {
+	close();
+	if (!keys_valid())
+		return false;
+	if (!_file.open(path, MappedFile::RANDOM))
+		return false;
+	if (_file.size() % ENTRY_SIZE != 0) {
+		close();
+		return false;
+	}
+	_data = reinterpret_cast<const uint8 *>(_file.data());
+	_size = _file.size() / ENTRY_SIZE;
+	return true;
+}
+
+void PolyglotBook::close() {
+	_file.close();
+	_data = nullptr;
+	_size = 0;
+}
+
+bool PolyglotBook::is_open() const {
+	return _file.is_open();
+}
+
+size_t PolyglotBook::size() const {
+	return _size;
+}
+
+PolyglotEntry PolyglotBook::entry(size_t index) const {
+	const uint8 *s = _data + index * ENTRY_SIZE;
+	return PolyglotEntry{
+		read_be(s, 8),
+		(uint16)read_be(s + 8, 2),
+		(uint16)read_be(s + 10, 2),
+		(uint32)read_be(s + 12, 4),
+	};
+}
+
+size_t PolyglotBook::find(uint64 key) const {
+	size_t low = 0, high = _size;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (read_be(_data + middle * ENTRY_SIZE, 8) < key)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (low < _size && read_be(_data + low * ENTRY_SIZE, 8) == key)
+		return low;
+	return _size;
+}
+
+void PolyglotBook::entries(const Position &position, std::vector<PolyglotEntry> &out) const {
+	uint64 k = key(position);
+	Action action;
+	for (size_t i = find(k); i < _size; ++i) {
+		PolyglotEntry e = entry(i);
+		if (e.key != k)
+			break;
+		if (decode_move(position, e.move, action))
+			out.push_back(e);
+	}
+}
+
+bool PolyglotBook::choose(const Position &position, uint32 random, Action &action) const {
+	PolyglotEntry candidates[64];
+	int count = 0;
+	uint32 total = 0;
+
+	uint64 k = key(position);
+	for (size_t i = find(k); i < _size && count < 64; ++i) {
+		PolyglotEntry e = entry(i);
+		if (e.key != k)
+			break;
+		if (e.weight == 0 || !decode_move(position, e.move, action))
+			continue;
+		candidates[count++] = e;
+		total += e.weight;
+	}
+	if (total == 0)
+		return false;
+
+	uint32 pick = random % total;
+	for (int i = 0; i < count; ++i) {
+		if (pick < candidates[i].weight)
+			return decode_move(position, candidates[i].move, action);
+		pick -= candidates[i].weight;
+	}
+	return false;
+}
+
+// KEYS AND MOVES
+
+static bool check_keys() {
+	Situation situation;
+	for (auto &test : KEY_TESTS) {
+		if (!fen_parse(test.fen, situation) || standard_key(situation) != test.key) {
+			fprintf(stderr, "polyglot key of %s is %016llx, expected %016llx\n", test.fen,
+					(unsigned long long)standard_key(situation), (unsigned long long)test.key);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PolyglotBook::keys_valid() {
+	static const bool valid = check_keys();
+	return valid;
+}
+
+uint64 PolyglotBook::key(const Position &position) {
+	return standard_key(position);
+}
+
+uint16 PolyglotBook::encode_move(const Position &position, const Action &action) {
+	Tile dst = action.dst;
+	if (action.type == CASTLING) {
+		// the king moves onto its own rook
+		Rules rules;
+		CastlingType side = dst[0] > action.src[0] ? KINGSIDE : QUEENSIDE;
+		dst = rules.getRookStartingSquare(position, action.player, side);
+	}
+	int promotion = action.promotion == TYPE_NONE ? 0 : PROMOTION_CODE[action.promotion];
+	return dst[0] | dst[1] << 3 | action.src[0] << 6 | action.src[1] << 9 | promotion << 12;
+}
+
+bool PolyglotBook::decode_move(const Position &position, uint16 move, Action &action) {
+	if (position.width() != 8 || position.height() != 8)
+		return false;
+
+	Tile dst(move & 7, (move >> 3) & 7);
+	Tile src((move >> 6) & 7, (move >> 9) & 7);
+	int promotion = (move >> 12) & 7;
+	if (promotion > 4)
+		return false;
+
+	Rules rules;
+	Player player = position.active_player();
+	Piece piece = position[src];
+	if (piece.player != player)
+		return false;
+
+	// castling is written as the king taking its own rook
+	bool castling = piece.type == TYPE_KING
+			&& src == rules.getKingStartingSquare(position, player)
+			&& position[dst] == Piece{player, TYPE_ROOK}
+			&& (dst[0] == 0 || dst[0] == 7);
+	if (castling) {
+		dst = src + Tile(dst[0] > src[0] ? +2 : -2, 0);
+		action = Action{player, CASTLING, src, dst, TYPE_NONE, NO_ANNOUNCEMENT};
+	} else {
+		Type type = PROMOTION_TYPE[promotion];
+		action = rules.examineMove(position, src, dst, type == TYPE_NONE ? TYPE_QUEEN : type);
+		action.announcement = NO_ANNOUNCEMENT;
+		if (type != TYPE_NONE && action.promotion != type)
+			return false;
+	}
+	return rules.isActionLegal(position, action);
+}
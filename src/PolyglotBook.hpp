@@ -0,0 +1,79 @@
+#ifndef POLYGLOT_BOOK_HPP
+#define POLYGLOT_BOOK_HPP
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+#include <vector>
+
+/// one book entry, decoded from the big-endian file format
+struct PolyglotEntry {
+	uint64 key;
+	uint16 move;
+	uint16 weight;
+	uint32 learn;
+};
+
+/** An opening book in the Polyglot .bin format.
+ *
+ * The file is a sorted array of 16 byte entries.  It is memory mapped and
+ * searched with a binary search on the key, so probing costs a handful of
+ * page touches and no parsing.
+ *
+ * Position keys are the standard Polyglot ones, see polyglot_keys.hpp, so
+ * books made by other programs can be read and the ones of bookbuild are
+ * readable by them.
+ */
+class PolyglotBook {
+public:
+	static const int NUM_KEYS = 781;
+	static const size_t ENTRY_SIZE = 16;
+
+	PolyglotBook() = default;
+	PolyglotBook(const PolyglotBook &) = delete;
+	PolyglotBook &operator = (const PolyglotBook &) = delete;
+
+	/** Maps a book.  Returns false if the file can't be mapped, its size
+	 * is not a multiple of ENTRY_SIZE or keys_valid fails.
+	 */
+	bool open(const char *path);
+	void close();
+	bool is_open() const;
+
+	/// number of entries
+	size_t size() const;
+	PolyglotEntry entry(size_t index) const;
+
+	/// index of the first entry with the given key, or size() if there is none
+	size_t find(uint64 key) const;
+
+	/// appends all entries of a position whose moves are legal
+	void entries(const Position &, std::vector<PolyglotEntry> &) const;
+
+	/** Picks one of the book moves of a position, with a probability
+	 * proportional to its weight.  random is any uniformly distributed
+	 * number.  Returns false if the position is not in the book.
+	 */
+	bool choose(const Position &, uint32 random, Action &) const;
+
+	// KEYS AND MOVES
+
+	/** Checks the keys of the positions in the format description, once
+	 * per process.  Prints the first mismatch to stderr.
+	 */
+	static bool keys_valid();
+
+	static uint64 key(const Position &);
+
+	/// encodes a legal action, castling is written as the king taking its rook
+	static uint16 encode_move(const Position &, const Action &);
+	/// decodes a book move, returns false if it is not legal in the position
+	static bool decode_move(const Position &, uint16 move, Action &);
+
+private:
+	MappedFile _file;
+	const uint8 *_data = nullptr;
+	size_t _size = 0;
+};
+
+#endif // POLYGLOT_BOOK_HPP
@@ -40,9 +40,7 @@ Position::Position(const Board &board, Player p, CastlingInit castling_init) :
 // OPERATORS
 
 bool Position::operator == (const Position &other) const {
-	if (Board::operator != (other))
-		return false;
-
+	// cheap state first, the board compare is the expensive part
 	if (_active_player != other._active_player)
 		return false;
 	if (_en_passant_file != other._en_passant_file)
@@ -56,6 +54,9 @@ bool Position::operator == (const Position &other) const {
 	if (_can_castle[1][1] != other._can_castle[1][1])
 		return false;
 
+	if (Board::operator != (other))
+		return false;
+
 	return true;
 }
 
@@ -89,17 +90,35 @@ bool &Position::can_castle(Player player, CastlingType type) {
 	return _can_castle[player][type];
 }
 
+uint64 Position::hash_value() const {
+	uint64 hash = Board::hash_value();
+	if (_active_player == PLAYER_BLACK)
+		hash ^= zobrist_player();
+	if (_en_passant_file >= 0)
+		hash ^= zobrist_file(_en_passant_file);
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		if (_can_castle[p][c])
+			hash ^= zobrist_castling(static_cast<Player>(p), static_cast<CastlingType>(c));
+	}
+	return hash;
+}
+
 // OPERATIONS
 
 void Position::action(const Action &a, Delta *delta) {
 	const Player opponent = static_cast<Player>(1 - _active_player);
 
+	// read through a const view and write through setPiece/movePiece, so
+	// the cached board hash is updated incrementally instead of dropped
+	const Board &board = *this;
+
 	if (delta) {
 		delta->castling_xor = 0;
 	}
 
 	// check for king moves
-	if (piece(a.src).type == TYPE_KING) {
+	if (board.piece(a.src).type == TYPE_KING) {
 		if (delta) {
 			int shift = a.player == PLAYER_WHITE ? 0 : 2;
 			bool kingside = _can_castle[a.player][KINGSIDE];
@@ -114,12 +133,12 @@ void Position::action(const Action &a, Delta *delta) {
 	// set the en passant chance
 	Coord old_en_passant_file = _en_passant_file;
 	_en_passant_file = -1;
-	if (piece(a.src).type == TYPE_PAWN && (a.dst - a.src).norm2() == 4) {
+	if (board.piece(a.src).type == TYPE_PAWN && (a.dst - a.src).norm2() == 4) {
 		Tile left = a.dst + Tile(-1, 0);
 		Tile right = a.dst + Tile(1, 0);
 		Piece p = Piece{opponent, TYPE_PAWN};
-		bool pawnLeft = isInBound(left) && piece(left) == p;
-		bool pawnRight = isInBound(right) && piece(right) == p;
+		bool pawnLeft = isInBound(left) && board.piece(left) == p;
+		bool pawnRight = isInBound(right) && board.piece(right) == p;
 		if(pawnLeft || pawnRight) {
 			_en_passant_file = a.dst[0];
 		}
@@ -144,7 +163,7 @@ void Position::action(const Action &a, Delta *delta) {
 	}
 
 	if (delta) {
-		delta->tiles[0] = TileDelta{a.src, piece(a.src) ^ Piece::NONE};
+		delta->tiles[0] = TileDelta{a.src, board.piece(a.src) ^ Piece::NONE};
 	}
 
 	// actually move the piece
@@ -153,12 +172,12 @@ void Position::action(const Action &a, Delta *delta) {
 		removePiece(a.src);
 		Piece new_piece = Piece{a.player, a.promotion};
 		if (delta)
-			delta->tiles[1] = TileDelta{a.dst, piece(a.dst) ^ new_piece};
-		piece(a.dst) = new_piece;
+			delta->tiles[1] = TileDelta{a.dst, board.piece(a.dst) ^ new_piece};
+		setPiece(a.dst, new_piece);
 	} else {
 		// all other moves
 		if (delta) {
-			delta->tiles[1] = TileDelta{a.dst, piece(a.src) ^ piece(a.dst)};
+			delta->tiles[1] = TileDelta{a.dst, board.piece(a.src) ^ board.piece(a.dst)};
 		}
 		movePiece(a.src, a.dst);
 	}
@@ -171,8 +190,8 @@ void Position::action(const Action &a, Delta *delta) {
 		Tile rook_dst = a.src + Tile(sx, 0);
 		movePiece(rook_src, rook_dst);
 		if (delta) {
-			delta->tiles[2] = TileDelta{rook_src, piece(rook_dst) ^ Piece::NONE};
-			delta->tiles[3] = TileDelta{rook_dst, piece(rook_dst) ^ Piece::NONE};
+			delta->tiles[2] = TileDelta{rook_src, board.piece(rook_dst) ^ Piece::NONE};
+			delta->tiles[3] = TileDelta{rook_dst, board.piece(rook_dst) ^ Piece::NONE};
 		}
 	}
 
@@ -180,7 +199,7 @@ void Position::action(const Action &a, Delta *delta) {
 	else if (a.type == EN_PASSANT) {
 		Tile en_passant_tile = Tile(a.dst[0], a.src[1]);
 		if (delta) {
-			delta->tiles[2] = TileDelta{en_passant_tile, piece(en_passant_tile) ^ Piece::NONE};
+			delta->tiles[2] = TileDelta{en_passant_tile, board.piece(en_passant_tile) ^ Piece::NONE};
 		}
 		removePiece(en_passant_tile);
 		if (delta)
@@ -197,10 +216,12 @@ void Position::action(const Action &a, Delta *delta) {
 }
 
 void Position::apply(Delta delta) {
-	int i = 0;
-	Tile tile;
-	while (isInBound(tile = delta.tiles[i].tile)) {
-        piece(tile) ^= delta.tiles[i++].piece_xor;
+	const Board &board = *this;
+	for (int i = 0; i < 4; ++i) {
+		Tile tile = delta.tiles[i].tile;
+		if (!isInBound(tile))
+			break;
+		setPiece(tile, board.piece(tile) ^ delta.tiles[i].piece_xor);
 	}
 
 	bool *can_castle = &_can_castle[0][0];
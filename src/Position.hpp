@@ -42,6 +42,9 @@ public:
 	bool can_castle(Player, CastlingType) const;
 	bool &can_castle(Player, CastlingType);
 
+	/// zobrist hash over the board, the active player, castling and en passant
+	uint64 hash_value() const;
+
 	// OPERATIONS
 	void action(const Action &action, Delta *delta = nullptr);
 
@@ -0,0 +1,67 @@
+#include "PositionDataset.hpp"
+
+#include <cstring>
+
+const char PositionDataset::MAGIC[8] = {'C', 'H', 'S', 'P', 'O', 'S', '\r', '\n'};
+
+bool PositionDataset::open(const char *path, MappedFile::Access access) {
+	close();
+	if (!_file.open(path, access))
+		return false;
+
+	const size_t header_size = sizeof (PositionDatasetHeader);
+	size_t size = _file.size();
+	if (size < header_size || (size - header_size) % sizeof (PackedPosition) != 0) {
+		close();
+		return false;
+	}
+
+	PositionDatasetHeader header;
+	memcpy(&header, _file.data(), header_size);
+	if (memcmp(header.magic, MAGIC, sizeof MAGIC) != 0
+			|| header.version != VERSION
+			|| header.record_size != sizeof (PackedPosition)) {
+		close();
+		return false;
+	}
+
+	// the mapping is page aligned and the header is one record long
+	_records = reinterpret_cast<const PackedPosition *>(_file.data() + header_size);
+	_size = (size - header_size) / sizeof (PackedPosition);
+	return true;
+}
+
+void PositionDataset::close() {
+	_file.close();
+	_records = nullptr;
+	_size = 0;
+}
+
+bool PositionDataset::is_open() const {
+	return _file.is_open() && _records;
+}
+
+size_t PositionDataset::size() const {
+	return _size;
+}
+
+const PackedPosition &PositionDataset::operator [] (size_t index) const {
+	return _records[index];
+}
+
+const PackedPosition *PositionDataset::begin() const {
+	return _records;
+}
+
+const PackedPosition *PositionDataset::end() const {
+	return _records + _size;
+}
+
+PositionDatasetHeader PositionDataset::header() {
+	PositionDatasetHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, MAGIC, sizeof MAGIC);
+	header.version = VERSION;
+	header.record_size = sizeof (PackedPosition);
+	return header;
+}
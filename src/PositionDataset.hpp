@@ -0,0 +1,56 @@
+#ifndef POSITION_DATASET_HPP
+#define POSITION_DATASET_HPP
+
+#include "MappedFile.hpp"
+#include "PackedPosition.hpp"
+
+/// the first 32 bytes of a dataset file, the records follow directly
+struct PositionDatasetHeader {
+	char magic[8];
+	uint32 version;
+	uint32 record_size;
+	uint8 reserved[16];
+};
+
+static_assert(sizeof (PositionDatasetHeader) == sizeof (PackedPosition), "records must stay aligned");
+
+/** Read-only access to a file of PackedPosition records.
+ *
+ * The file is memory mapped and records are served straight out of the
+ * mapping, so opening a dataset of any size is instant and nothing is
+ * copied.  Only the pages that are touched are ever read from disk.
+ */
+class PositionDataset {
+public:
+	static const char MAGIC[8];
+	static const uint32 VERSION = 1;
+
+	PositionDataset() = default;
+	PositionDataset(const PositionDataset &) = delete;
+	PositionDataset &operator = (const PositionDataset &) = delete;
+
+	/** Maps a dataset.  Returns false if the file can't be mapped, has no
+	 * valid header or its size is not a whole number of records.
+	 */
+	bool open(const char *path, MappedFile::Access access = MappedFile::RANDOM);
+	void close();
+
+	bool is_open() const;
+
+	/// number of records
+	size_t size() const;
+
+	const PackedPosition &operator [] (size_t index) const;
+	const PackedPosition *begin() const;
+	const PackedPosition *end() const;
+
+	/// fills in a header for a new file
+	static PositionDatasetHeader header();
+
+private:
+	MappedFile _file;
+	const PackedPosition *_records = nullptr;
+	size_t _size = 0;
+};
+
+#endif // POSITION_DATASET_HPP
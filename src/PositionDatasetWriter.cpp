@@ -0,0 +1,51 @@
+#include "PositionDatasetWriter.hpp"
+
+PositionDatasetWriter::~PositionDatasetWriter() {
+	close();
+}
+
+bool PositionDatasetWriter::open(const char *path) {
+	close();
+	_file = fopen(path, "wb");
+	if (!_file)
+		return false;
+
+	_buffer = new char[BUFFER_SIZE];
+	setvbuf(_file, _buffer, _IOFBF, BUFFER_SIZE);
+	_size = 0;
+	_failed = false;
+
+	PositionDatasetHeader header = PositionDataset::header();
+	_failed = fwrite(&header, sizeof header, 1, _file) != 1;
+	return !_failed;
+}
+
+bool PositionDatasetWriter::close() {
+	if (!_file)
+		return !_failed;
+	if (fclose(_file) != 0)
+		_failed = true;
+	_file = nullptr;
+	delete[] _buffer;
+	_buffer = nullptr;
+	return !_failed;
+}
+
+bool PositionDatasetWriter::write(const PackedPosition &record) {
+	return write(&record, 1);
+}
+
+bool PositionDatasetWriter::write(const PackedPosition *records, size_t count) {
+	if (!_file || _failed)
+		return false;
+	if (fwrite(records, sizeof (PackedPosition), count, _file) != count) {
+		_failed = true;
+		return false;
+	}
+	_size += count;
+	return true;
+}
+
+size_t PositionDatasetWriter::size() const {
+	return _size;
+}
@@ -0,0 +1,38 @@
+#ifndef POSITION_DATASET_WRITER_HPP
+#define POSITION_DATASET_WRITER_HPP
+
+#include "PositionDataset.hpp"
+
+#include <cstdio>
+
+/** Creates a dataset file that PositionDataset can map.  Records are
+ * appended through a large buffer, so writing is limited by the disk.
+ */
+class PositionDatasetWriter {
+public:
+	PositionDatasetWriter() = default;
+	~PositionDatasetWriter();
+	PositionDatasetWriter(const PositionDatasetWriter &) = delete;
+	PositionDatasetWriter &operator = (const PositionDatasetWriter &) = delete;
+
+	/// creates or truncates the file and writes the header
+	bool open(const char *path);
+	/// flushes and closes the file, returns false if any write failed
+	bool close();
+
+	bool write(const PackedPosition &);
+	bool write(const PackedPosition *, size_t count);
+
+	/// number of records written since open
+	size_t size() const;
+
+private:
+	static const size_t BUFFER_SIZE = 1 << 20;
+
+	FILE *_file = nullptr;
+	char *_buffer = nullptr;
+	size_t _size = 0;
+	bool _failed = false;
+};
+
+#endif // POSITION_DATASET_WRITER_HPP
@@ -52,6 +52,10 @@ void RandomBot::update(Action a) {
 }
 */
 
+void RandomBot::set_verbose(bool verbose) {
+	_verbose = verbose;
+}
+
 Action RandomBot::next_action() {
 	Rules rules;
 	std::vector<Action> actions = rules.getAllLegalMoves(_game);
@@ -60,6 +64,8 @@ Action RandomBot::next_action() {
 				DO_NOTHING, Board::INVALID_TILE, Board::INVALID_TILE, TYPE_NONE};
 	std::uniform_int_distribution<> dist(0, actions.size() - 1);
 	int index = dist(_random);
+	if (!_verbose)
+		return actions[index];
 	printf("bot is choosing from %u moves... %d!\n", (uint) actions.size(), index);
 	for (auto iter = actions.begin(); iter != actions.end(); ++iter) {
 		if (iter != actions.begin()) {
@@ -17,8 +17,12 @@ public:
     //virtual void update(Action) override;
     virtual Action next_action() override;
 
+    /// print the legal moves and the choice to stdout, on by default
+    void set_verbose(bool);
+
 private:
     std::mt19937 _random;
+    bool _verbose = true;
 };
 
 #endif // RANDOM_BOT_HPP
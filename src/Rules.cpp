@@ -22,7 +22,7 @@ Action Rules::examineMove(const Position &position, Tile src, Tile dst, Type pro
 
 	// promotion
 	Type promo_type;
-	Coord end_row = player == PLAYER_WHITE ? position.width() - 1 : 0;
+	Coord end_row = player == PLAYER_WHITE ? position.height() - 1 : 0;
 	if (position[src].type == TYPE_PAWN && dst[1] == end_row)
 		promo_type = promo_type_hint;
 	else
@@ -171,7 +171,7 @@ bool Rules::isRegularMoveLegal(const Position &position, Action a) {
 	}
 
 	// check for promotions
-	Coord end_row = a.player == PLAYER_WHITE ? position.width() - 1 : 0;
+	Coord end_row = a.player == PLAYER_WHITE ? position.height() - 1 : 0;
 	if (position[a.src].type == TYPE_PAWN && a.dst[1] == end_row) {
 		switch (a.promotion) {
 			case TYPE_NONE:
@@ -224,18 +224,16 @@ Tile Rules::getRookStartingSquare(const Board &board, Player player, CastlingTyp
 }
 
 bool Rules::isPlayerInCheck(const Board &board, Player player) {
-	// find players king
+	// find players king, straight through the piece array
 	Tile king = Board::INVALID_TILE;
-	for (Coord y = 0; y < board.height(); ++y)
-		for (Coord x = 0; x < board.width(); ++x) {
-			Tile tile = Tile(x, y);
-			Piece piece = board[tile];
-			if (piece.type == TYPE_KING && piece.player == player) {
-				king = tile;
-				goto BREAK_FROM_NESTED_LOOP;
-			}
+	const Piece *pieces = board.pieces();
+	const Piece own_king = Piece{player, TYPE_KING};
+	for (int i = 0, size = board.width() * board.height(); i < size; ++i) {
+		if (pieces[i] == own_king) {
+			king = Tile(i % board.width(), i / board.width());
+			break;
 		}
-	BREAK_FROM_NESTED_LOOP:;
+	}
 
 	Player opponent = player == PLAYER_WHITE ? PLAYER_BLACK : PLAYER_WHITE;
 	return doesPlayerAttackSquare(board, king, opponent);
@@ -434,7 +432,7 @@ std::vector<Action> &Rules::getAllLegalMoves(const Position &position, std::vect
     Player player = position.active_player();
 
     Coord forward = player == PLAYER_WHITE ? +1 : -1;
-    Coord pawn_end_row = player == PLAYER_WHITE ? position.height() : 0;
+    Coord pawn_end_row = player == PLAYER_WHITE ? position.height() - 1 : 0;
     Coord pawn_home_row = pawn_end_row - 6 * forward;
 
 	for (Coord y = 0; y < position.height(); ++y)
@@ -453,7 +451,8 @@ std::vector<Action> &Rules::getAllLegalMoves(const Position &position, std::vect
             static const Coord sx[] = {-1, -1, -1,  0,  0, +1, +1, +1, +2, -2};
             static const Coord sy[] = {-1,  0, +1, -1, +1, -1,  0, +1,  0,  0};
 
-            for (int i = 0; i < 8; ++i) {
+            // the last two are castlings
+            for (int i = 0; i < 10; ++i) {
                 Tile dst = src + Tile(sx[i], sy[i]);
                 if (!position.isInBound(dst))
                     continue;
@@ -571,6 +570,6 @@ std::vector<Action> &Rules::getAllLegalMoves(const Position &position, std::vect
 
 std::vector<Action> Rules::getAllLegalMoves(const Position &position, int flags) {
     std::vector<Action> actions;
-    getAllLegalMoves(position, actions);
+    getAllLegalMoves(position, actions, flags);
     return actions;
 }
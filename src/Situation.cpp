@@ -34,13 +34,25 @@ Player &Situation::winner() {
 	return _winner;
 }
 
+SituationState Situation::state() const {
+	return SituationState{_half_move_counter, _has_remis_offer, _has_game_ended, _winner};
+}
+
+void Situation::restore(const SituationState &state) {
+	_half_move_counter = state.half_move_counter;
+	_has_remis_offer = state.has_remis_offer;
+	_has_game_ended = state.has_game_ended;
+	_winner = state.winner;
+}
+
 // OPERATIONS
 
-void Situation::action(const Action &a, Delta *delta) {
+bool Situation::action(const Action &a, Delta *delta) {
 	if (_has_game_ended)
-		return;
+		return false;
 
-	bool is_pawn = piece(a.src).type == TYPE_PAWN;
+	const Board &board = *this;
+	bool is_pawn = board.piece(a.src).type == TYPE_PAWN;
 	bool is_capture = a.type == CAPTURE_PIECE || a.type == EN_PASSANT;
 
 	if (a.type != DO_NOTHING) {
@@ -73,4 +85,6 @@ void Situation::action(const Action &a, Delta *delta) {
 		_has_game_ended = true;
 		break;
 	} // switch announcement
+
+	return a.type != DO_NOTHING;
 }
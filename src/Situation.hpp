@@ -3,6 +3,14 @@
 
 #include "Position.hpp"
 
+/// the fields of a Situation that are not covered by a Delta
+struct SituationState {
+	int half_move_counter;
+	bool has_remis_offer;
+	bool has_game_ended;
+	Player winner;
+};
+
 class Situation :
 	public Position
 {
@@ -24,8 +32,16 @@ public:
 	Player winner() const;
 	Player &winner();
 
+	SituationState state() const;
+	void restore(const SituationState &);
+
 	// OPERATIONS
-	void action(const Action &, Delta *delta = nullptr);
+	/** Performs an action.  Returns false if the position was left untouched
+	 * (announcements, or the game has already ended), in which case delta is
+	 * not filled in.  To undo an action, apply the delta if there is one and
+	 * restore the previous state.
+	 */
+	bool action(const Action &, Delta *delta = nullptr);
 
 private:
 	int _half_move_counter = 0;
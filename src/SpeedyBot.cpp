@@ -2,73 +2,51 @@
 
 #include "Rules.hpp"
 #include "Position.hpp"
+#include "Evaluator.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <time.h>
 #include <cfloat>
 
 static float PLUS_INFINITY = 99999999.0f;
 static float MINUS_INFINITY = -99999999.0f;
-static float VERY_BAD = -9999999.0f;
-
-static float PIECE_VALUES[6] = { 0, 9, 5, 3, 3, 1 };
-static float PIECE_POS_RATINGS[6][8][8] = {
-		{
-				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{1.0, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{0.3, 0.5, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{0.7, 0.5, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{0.3, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{1.0, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
-		}, {
-				{0.0, 0.1, 0.2, 0.3, 0.4, 0.4, 0.3, 0.2},
-				{0.1, 0.2, 0.3, 0.4, 0.5, 0.4, 0.3, 0.2},
-				{0.2, 0.3, 0.4, 0.6, 0.8, 0.7, 0.3, 0.2},
-				{0.3, 0.4, 0.5, 0.9, 1.0, 0.8, 0.5, 0.2},
-				{0.3, 0.4, 0.5, 0.9, 1.0, 0.8, 0.5, 0.2},
-				{0.2, 0.3, 0.4, 0.6, 0.8, 0.7, 0.3, 0.2},
-				{0.1, 0.2, 0.3, 0.4, 0.5, 0.4, 0.3, 0.2},
-				{0.0, 0.1, 0.2, 0.3, 0.4, 0.4, 0.3, 0.2},
-		}, {
-				{0.4, 0.2, 0.3, 0.4, 0.4, 0.3, 0.3, 0.3},
-				{0.2, 0.2, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
-				{0.6, 0.3, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
-				{1.0, 0.9, 0.5, 0.5, 0.4, 0.3, 0.3, 0.3},
-				{1.0, 0.9, 0.5, 0.5, 0.4, 0.3, 0.3, 0.3},
-				{0.6, 0.3, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
-				{0.2, 0.2, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
-				{0.4, 0.2, 0.3, 0.4, 0.4, 0.3, 0.3, 0.3},
-		}, {
-				{0.0, 0.1, 0.3, 0.4, 0.3, 0.2, 0.1, 0.0},
-				{0.0, 0.2, 0.3, 0.5, 0.4, 0.3, 0.2, 0.0},
-				{0.1, 0.2, 0.4, 0.8, 0.6, 0.4, 0.2, 0.1},
-				{0.1, 0.3, 0.7, 1.0, 0.8, 0.5, 0.3, 0.1},
-				{0.1, 0.3, 0.7, 1.0, 0.8, 0.5, 0.3, 0.1},
-				{0.1, 0.2, 0.4, 0.8, 0.6, 0.4, 0.2, 0.1},
-				{0.0, 0.2, 0.3, 0.5, 0.4, 0.3, 0.2, 0.0},
-				{0.0, 0.1, 0.3, 0.4, 0.3, 0.2, 0.1, 0.0},
-		}, {
-				{0.0, 0.0, 0.1, 0.1, 0.1, 0.1, 0.0, 0.0},
-				{0.0, 0.1, 0.2, 0.3, 0.3, 0.2, 0.1, 0.0},
-				{0.1, 0.2, 0.4, 0.5, 0.5, 0.4, 0.2, 0.1},
-				{0.1, 0.3, 0.7, 1.0, 1.0, 0.7, 0.3, 0.1},
-				{0.1, 0.3, 0.7, 1.0, 1.0, 0.7, 0.3, 0.1},
-				{0.1, 0.2, 0.4, 0.5, 0.5, 0.4, 0.2, 0.1},
-				{0.0, 0.1, 0.2, 0.3, 0.3, 0.2, 0.1, 0.0},
-				{0.0, 0.0, 0.1, 0.1, 0.1, 0.1, 0.0, 0.0},
-		}, {
-				{0.0, 0.2, 0.2, 0.3, 0.3, 0.7, 3.0, 0.0},
-				{0.0, 0.2, 0.2, 0.3, 0.4, 0.8, 4.0, 0.0},
-				{0.0, 0.2, 0.2, 0.3, 0.6, 1.0, 4.0, 0.0},
-				{0.0, 0.0, 0.3, 0.6, 0.7, 1.0, 4.0, 0.0},
-				{0.0, 0.0, 0.3, 0.6, 0.7, 1.0, 4.0, 0.0},
-				{0.0, 0.2, 0.2, 0.3, 0.6, 1.0, 4.0, 0.0},
-				{0.0, 0.2, 0.2, 0.3, 0.4, 0.8, 4.0, 0.0},
-				{0.0, 0.2, 0.2, 0.3, 0.3, 0.7, 3.0, 0.0},
-		}
-};
+static float VERY_BAD = Evaluator::VERY_BAD;
+// Syzygy wins have no distance to mate, they rate below the mates found
+static const float SYZYGY_WIN = -Evaluator::VERY_BAD / 2;
+// ratings beyond this depend on the distance to the root
+static float DECIDED = -Evaluator::VERY_BAD / 4;
+
+/// ratings of mates and tablebase wins are stored relative to the node
+static float to_table(float rating, int dist) {
+	return rating > DECIDED ? rating + dist : rating < -DECIDED ? rating - dist : rating;
+}
+
+static float from_table(float rating, int dist) {
+	return rating > DECIDED ? rating - dist : rating < -DECIDED ? rating + dist : rating;
+}
+
+float SearchStats::eval_cache_hit_rate() const {
+	if (evaluations == 0)
+		return 0.0f;
+	return (float)eval_cache_hits / evaluations;
+}
+
+uint64 SearchStats::total_nodes() const {
+	return nodes + evaluations;
+}
+
+ReportedScore ReportedScore::from_rating(float rating) {
+	// mates are rated VERY_BAD plus their distance in plies
+	const float mate = -VERY_BAD - 1000;
+	if (rating >= mate)
+		return ReportedScore{true, ((int)(-VERY_BAD - rating) + 1) / 2};
+	if (rating <= -mate)
+		return ReportedScore{true, -((int)(rating - VERY_BAD) / 2)};
+	long cp = std::lround(rating * 100);
+	return ReportedScore{false, (int)std::min(std::max(cp, -20000L), 20000L)};
+}
 
 SpeedyBot::SpeedyBot() :
 	Bot(), _max_depth(3)
@@ -96,78 +74,359 @@ void SpeedyBot::update(Action a) {
 }
 */
 
+void SpeedyBot::set_eval_cache_size(size_t size) {
+	_eval_cache.resize(size);
+}
+
+const SearchStats &SpeedyBot::stats() const {
+	return _stats;
+}
+
+void SpeedyBot::set_limits(const SearchLimits &limits) {
+	_limits = limits;
+}
+
+void SpeedyBot::set_info_callback(std::function<void(const SearchInfo &)> callback) {
+	_info_callback = callback;
+}
+
+void SpeedyBot::set_verbose(bool verbose) {
+	_verbose = verbose;
+}
+
+void SpeedyBot::set_multipv(int lines) {
+	_multipv = std::max(lines, 1);
+}
+
+const std::vector<RootLine> &SpeedyBot::lines() const {
+	return _lines;
+}
+
+void SpeedyBot::set_stop_flag(const std::atomic<bool> *flag) {
+	_stop_flag = flag;
+}
+
+void SpeedyBot::set_transposition_table(std::shared_ptr<TranspositionTable> table) {
+	_tt = table;
+}
+
+void SpeedyBot::clear_caches() {
+	_tt->clear();
+	_eval_cache.clear();
+}
+
+void SpeedyBot::set_tablebase(std::shared_ptr<const Tablebase> tablebase) {
+	_tablebase = tablebase;
+}
+
+void SpeedyBot::set_syzygy(std::shared_ptr<const SyzygyTablebase> syzygy) {
+	_syzygy = syzygy;
+}
+
+void SpeedyBot::set_syzygy_probing(bool enabled) {
+	_syzygy_probing = enabled;
+}
+
+void SpeedyBot::report_unsearched(const Action &action, float rating) {
+	_lines.assign(1, RootLine{action, rating, std::vector<Action>(1, action)});
+	if (_info_callback) {
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+		_info_callback(SearchInfo{1, rating, action, _stats.total_nodes(), seconds, _lines[0].pv, _lines});
+	}
+}
+
 Action SpeedyBot::next_action() {
 	Action action;
-	Position position = _game.current_situation();
-	float bestRating = rate_game(_max_depth, MINUS_INFINITY, PLUS_INFINITY, 0, position, &action);
+	_lines.clear();
+	_stats = SearchStats();
+	_start = std::chrono::steady_clock::now();
+	if (book_action(action)) {
+		if (_verbose)
+			printf("book move\n");
+		// the book knows no rating
+		report_unsearched(action, 0);
+		return action;
+	}
+
+	const Situation &situation = _game.current_situation();
+	Position position = situation;
+	_path.clear();
+	_game.repetition_hashes(_path);
+	_can_stop = false;
+	_stopped = false;
+	_has_previous_best = false;
+	_root_actions.clear();
 
-	printf("bestRating: %.2f\n", bestRating);
+	// decided endings are played from the tables, drawn ones searched
+	// among the drawing actions only
+	if (_syzygy && _syzygy_probing && _syzygy->max_pieces() > 0) {
+		Rules rules;
+		std::vector<Action> actions = rules.getAllLegalMoves(position, Rules::EVERY_PROMOTION);
+		SyzygyWdl wdl;
+		if (_syzygy->filter_root(position, situation.half_move_counter(), actions, wdl)) {
+			++_stats.tablebase_hits;
+			if (wdl != WDL_DRAW || actions.size() == 1) {
+				if (_verbose)
+					printf("tablebase move\n");
+				report_unsearched(actions.front(), wdl == WDL_WIN ? SYZYGY_WIN : wdl == WDL_LOSS ? -SYZYGY_WIN : 0);
+				return actions.front();
+			}
+			_root_actions = actions;
+		}
+	}
+
+	size_t line_count = 1;
+	if (_multipv > 1) {
+		Rules rules;
+		line_count = std::min((size_t)_multipv, _root_actions.empty()
+				? rules.getAllLegalMoves(position).size() : _root_actions.size());
+	}
+
+	// iterative deepening, the best actions of each iteration are searched
+	// first in the next one
+	int max_plies = _limits.depth > 0 ? _limits.depth : _max_depth + 1;
+	float bestRating = 0;
+	std::vector<RootLine> lines;
+	for (int plies = 1; plies <= max_plies; ++plies) {
+		lines.clear();
+		_root_excluded.clear();
+		for (size_t k = 0; k < line_count; ++k) {
+			_has_previous_best = k < _lines.size();
+			if (_has_previous_best)
+				_previous_best = _lines[k].action;
+			Action best;
+			float rating = rate_game(plies - 1, MINUS_INFINITY, PLUS_INFINITY, 0,
+					situation.half_move_counter(), position, &best);
+			if (_stopped)
+				break;
+			lines.push_back(RootLine{best, rating, _pv[0]});
+			_root_excluded.push_back(best);
+		}
+		_root_excluded.clear();
+		if (_stopped)
+			break;
+
+		// a later search may see more than an earlier one
+		std::stable_sort(lines.begin(), lines.end(), [](const RootLine &a, const RootLine &b) {
+			return a.score > b.score;
+		});
+		_lines = lines;
+		action = _lines[0].action;
+		bestRating = _lines[0].score;
+		_can_stop = true;
+		if (_info_callback) {
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+			_info_callback(SearchInfo{plies, bestRating, action, _stats.total_nodes(), seconds, _lines[0].pv, _lines});
+		}
+		if (out_of_budget())
+			break;
+	}
+
+	if (_verbose) {
+		printf("bestRating: %.2f\n", bestRating);
+		printf("nodes: %llu, evaluations: %llu, eval cache hits: %.1f%%, draws: %llu, tablebase hits: %llu, tt hits: %llu\n",
+				(unsigned long long)_stats.nodes,
+				(unsigned long long)_stats.evaluations,
+				100.0f * _stats.eval_cache_hit_rate(),
+				(unsigned long long)_stats.draws,
+				(unsigned long long)_stats.tablebase_hits,
+				(unsigned long long)_stats.tt_hits);
+	}
 
 	return action;
 }
 
-float SpeedyBot::rate_game(int depth, float alpha, float beta, int dist, Position &position, Action *outAction) {
+bool SpeedyBot::out_of_budget() {
+	if (_stop_flag && _stop_flag->load(std::memory_order_relaxed))
+		return true;
+	if (_limits.nodes > 0 && _stats.total_nodes() >= _limits.nodes)
+		return true;
+	if (_limits.movetime > 0) {
+		auto elapsed = std::chrono::steady_clock::now() - _start;
+		return elapsed >= std::chrono::milliseconds(_limits.movetime);
+	}
+	return false;
+}
+
+bool SpeedyBot::is_repetition(uint64 hash, int half_move_counter) const {
+	// only positions with the same player to move, and none before the last
+	// pawn move or capture, can be repeated
+	int size = (int)_path.size();
+	for (int back = 2; back <= half_move_counter && back <= size; back += 2) {
+		if (_path[size - back] == hash)
+			return true;
+	}
+	return false;
+}
+
+bool SpeedyBot::is_checkmate(const Position &position) const {
 	Rules rules;
-	std::vector<Action> actions = rules.getAllLegalMoves(position);
+	return rules.isPlayerInCheck(position, position.active_player())
+			&& rules.getAllLegalMoves(position).empty();
+}
+
+float SpeedyBot::rate_game(int depth, float alpha, float beta, int dist, int half_moves, Position &position, Action *outAction) {
+	++_stats.nodes;
+	if ((int)_pv.size() < dist + 2)
+		_pv.resize(dist + 2);
+	_pv[dist].clear();
+
+	// reading the clock is cheap next to generating the moves
+	if (_stopped || (_can_stop && out_of_budget())) {
+		_stopped = true;
+		return 0;
+	}
+
+	float exact;
+	if (!outAction && (rate_tablebase(dist, position, exact) || rate_syzygy(dist, half_moves, position, exact)))
+		return exact;
+
+	// an earlier search, or another thread, may have rated this already;
+	// a node fails high or is exact, as the search window only has beta
+	uint64 node_hash = position.hash_value();
+	TranspositionTable::Entry entry;
+	bool found = _tt && _tt->probe(node_hash, entry);
+	if (found) {
+		++_stats.tt_hits;
+		float rating = from_table(entry.rating, dist);
+		if (!outAction && entry.depth >= depth
+				&& (entry.bound == TranspositionTable::BOUND_EXACT || rating >= beta)) {
+			return rating;
+		}
+	}
+
+	Rules rules;
+	std::vector<Action> actions = outAction && !_root_actions.empty()
+			? _root_actions : rules.getAllLegalMoves(position);
 	if(actions.size() == 0) {
 		if(rules.isPlayerInCheck(position, position.active_player()))
 			return VERY_BAD + dist;
 		else
 			return 0;
 	}
+	bool excluding = outAction && !_root_excluded.empty();
+	if (excluding) {
+		actions.erase(std::remove_if(actions.begin(), actions.end(), [this](const Action &action) {
+			return std::find(_root_excluded.begin(), _root_excluded.end(), action) != _root_excluded.end();
+		}), actions.end());
+	}
+	if (outAction && _has_previous_best) {
+		auto previous = std::find(actions.begin(), actions.end(), _previous_best);
+		if (previous != actions.end())
+			std::iter_swap(actions.begin(), previous);
+	} else if (found) {
+		for (auto iter = actions.begin(); iter != actions.end(); ++iter) {
+			if (TranspositionTable::matches(entry, *iter)) {
+				std::iter_swap(actions.begin(), iter);
+				break;
+			}
+		}
+	}
+	// read pieces through a const view, writing would drop the cached hash
+	const Board &board = position;
 	float bestRating = MINUS_INFINITY;
+	Action bestAction = actions.front();
 	for (auto iter = actions.begin(); iter != actions.end(); ++iter) {
+		bool is_pawn = board[iter->src].type == TYPE_PAWN;
+		bool is_capture = iter->type == CAPTURE_PIECE || iter->type == EN_PASSANT;
+		int next_half_moves = is_pawn || is_capture ? 0 : half_moves + 1;
+
 		Delta delta;
 		position.action(*iter, &delta);
+		uint64 hash = position.hash_value();
 		float rating;
-		if (depth == 0)
-			rating = -rate_game_flat(dist, position);
-		else
-			rating = -rate_game(depth - 1, -beta, -bestRating, dist + 1, position);
+		bool searched = false;
+		// a mate on the hundredth half move still wins, the fifty-move rule
+		// only draws a position the mover is not mated in
+		if (is_repetition(hash, next_half_moves) || (next_half_moves >= 100 && !is_checkmate(position))) {
+			// a draw can be claimed here, no need to look any further
+			++_stats.draws;
+			rating = 0;
+		} else if (depth == 0) {
+			rating = -rate_game_flat(dist + 1, next_half_moves, position);
+		} else {
+			_path.push_back(hash);
+			rating = -rate_game(depth - 1, -beta, -bestRating, dist + 1, next_half_moves, position);
+			_path.pop_back();
+			searched = true;
+		}
 		position.apply(delta);
 		if (rating > bestRating) {
 			bestRating = rating;
+			bestAction = *iter;
+			_pv[dist].assign(1, *iter);
+			if (searched)
+				_pv[dist].insert(_pv[dist].end(), _pv[dist + 1].begin(), _pv[dist + 1].end());
 			if(outAction)
 				*outAction = *iter;
 			if(rating >= beta)
-				return bestRating;
+				break;
 		}
 	}
 
+	// a root without some of its actions must not be remembered
+	if (_tt && !_stopped && !excluding) {
+		auto bound = bestRating >= beta ? TranspositionTable::BOUND_LOWER : TranspositionTable::BOUND_EXACT;
+		_tt->store(node_hash, TranspositionTable::entry(to_table(bestRating, dist), depth, bound, bestAction));
+	}
 	return bestRating;
 }
 
-float SpeedyBot::rate_game_flat(int dist, const Position &position) {
-	float material = 0;
-	float posRating = 0;
-	int numPieces = 0;
-	for (Coord y = 0; y < position.height(); ++y)
-	for (Coord x = 0; x < position.width(); ++x) {
-		Piece p = position[Tile(x,y)];
+float SpeedyBot::rate_game_flat(int dist, int half_moves, const Position &position) {
+	++_stats.evaluations;
 
-		if(p.type == TYPE_NONE)
-			continue;
+	float exact;
+	if (rate_tablebase(dist, position, exact) || rate_syzygy(dist, half_moves, position, exact))
+		return exact;
 
-		float factor = 1.0;
-		if(p.player != position.active_player())
-			factor = -1.0;
+	// transpositions are common among the leaves, so try the cache first
+	uint64 hash = position.hash_value();
+	float cached;
+	bool mated;
+	if (_eval_cache.probe(hash, cached, mated)) {
+		++_stats.eval_cache_hits;
+		return mated ? cached + dist : cached;
+	}
 
-		int relative_y = y;
-		if(p.player == PLAYER_BLACK)
-			relative_y = position.height() - y - 1;
+	float rating = _evaluator.rate(position);
+	bool is_mated = rating == VERY_BAD;
+	_eval_cache.store(hash, rating, is_mated);
+	return is_mated ? rating + dist : rating;
+}
 
-		material += PIECE_VALUES[p.type] * factor;
-		posRating += PIECE_POS_RATINGS[p.type][x][relative_y] * factor;
-		numPieces++;
-	}
+bool SpeedyBot::rate_tablebase(int dist, const Position &position, float &rating) {
+	if (!_tablebase || _tablebase->max_pieces() == 0)
+		return false;
+	TablebaseValue value;
+	if (!_tablebase->probe(position, value))
+		return false;
 
-	Rules rules;
-	if(rules.getAllLegalMoves(position).size() == 0) {
-		if(rules.isPlayerInCheck(position, position.active_player()))
-			return VERY_BAD + dist;
-		else
-			return 0;
-	}
+	// mates are rated like the ones found by the search, nearer is better
+	++_stats.tablebase_hits;
+	if (value.result == TB_WIN)
+		rating = -(VERY_BAD + dist + value.plies);
+	else if (value.result == TB_LOSS)
+		rating = VERY_BAD + dist + value.plies;
+	else
+		rating = 0;
+	return true;
+}
+
+bool SpeedyBot::rate_syzygy(int dist, int half_moves, const Position &position, float &rating) {
+	// the tables assume that the fifty-move counter was just reset
+	if (!_syzygy || !_syzygy_probing || half_moves != 0)
+		return false;
+	SyzygyWdl wdl;
+	if (!_syzygy->probe_wdl(position, wdl))
+		return false;
 
-	return material + posRating / numPieces;
+	// cursed wins and blessed losses are draws by the fifty-move rule
+	++_stats.tablebase_hits;
+	if (wdl == WDL_WIN)
+		rating = SYZYGY_WIN - dist;
+	else if (wdl == WDL_LOSS)
+		rating = -SYZYGY_WIN + dist;
+	else
+		rating = 0;
+	return true;
 }
@@ -2,8 +2,85 @@
 #define SPEEDY_BOT_HPP
 
 #include "Bot.hpp"
+#include "EvalCache.hpp"
+#include "Evaluator.hpp"
+#include "SyzygyTablebase.hpp"
+#include "Tablebase.hpp"
+#include "TranspositionTable.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <random>
+#include <vector>
+
+/** Counters collected during a single call to next_action
+ */
+struct SearchStats {
+	/// number of positions visited by rate_game
+	uint64 nodes = 0;
+	/// number of leaf positions rated by rate_game_flat
+	uint64 evaluations = 0;
+	/// number of leaf ratings that were taken from the evaluation cache
+	uint64 eval_cache_hits = 0;
+	/// number of lines cut off as repetition or fifty-move draws
+	uint64 draws = 0;
+	/// number of positions whose exact value came from a tablebase
+	uint64 tablebase_hits = 0;
+	/// number of positions found in the transposition table
+	uint64 tt_hits = 0;
+
+	float eval_cache_hit_rate() const;
+	/// positions visited or rated, what node limits are compared against
+	uint64 total_nodes() const;
+};
+
+/** Bounds for a single call to next_action, zero means no bound
+ */
+struct SearchLimits {
+	/// deepest iteration in plies, 0 uses the depth given to the constructor
+	int depth = 0;
+	/// stop after about this many nodes, see SearchStats::total_nodes
+	uint64 nodes = 0;
+	/// stop after about this many milliseconds
+	int movetime = 0;
+};
+
+/** A root action with its rating and the expected line of play
+ */
+struct RootLine {
+	Action action;
+	float score;
+	/// starting with action
+	std::vector<Action> pv;
+};
+
+/** The result of one completed iteration of next_action
+ */
+struct SearchInfo {
+	/// in plies
+	int depth;
+	float score;
+	Action action;
+	/// SearchStats::total_nodes so far
+	uint64 nodes;
+	double seconds;
+	/// the expected line of play, starting with action
+	std::vector<Action> pv;
+	/// the best root actions, best first, see SpeedyBot::set_multipv
+	std::vector<RootLine> lines;
+};
+
+/** A rating the way engines report it: a mate in moves, negative if the
+ * side to move gets mated, or centipawns bounded to +-20000
+ */
+struct ReportedScore {
+	bool mate;
+	/// moves to mate or centipawns
+	int value;
+
+	static ReportedScore from_rating(float rating);
+};
 
 class SpeedyBot :
     public Bot
@@ -16,11 +93,110 @@ public:
 	//virtual void update(Action) override;
 	virtual Action next_action() override;
 
+	/// number of slots in the evaluation cache, rounded down to a power of two
+	void set_eval_cache_size(size_t);
+
+	const SearchStats &stats() const;
+
+	/** Searches deeper and deeper until the depth of the limits is done or
+	 * their node or time bound is hit.  An iteration cut short by a bound is
+	 * discarded, but the first one always completes.
+	 */
+	void set_limits(const SearchLimits &);
+	/** Called after every completed iteration, and once at depth 1 for a
+	 * book or tablebase move played without a search.
+	 */
+	void set_info_callback(std::function<void(const SearchInfo &)>);
+	/// print the result of every search to stdout, on by default
+	void set_verbose(bool);
+	/** Searches the given number of best root actions instead of only the
+	 * best one, 1 by default.  Each further one is found by searching the
+	 * root again without the ones found before, which mostly runs on the
+	 * ratings the earlier searches left in the transposition table.
+	 */
+	void set_multipv(int);
+	/// the lines of the last next_action, best first, only the move for book and tablebase moves
+	const std::vector<RootLine> &lines() const;
+
+	/** A flag that ends the search soon after it is set, like a bound of
+	 * the limits.  It is owned by the caller and never reset by the bot.
+	 */
+	void set_stop_flag(const std::atomic<bool> *);
+
+	/** Results of searched positions, kept between calls to next_action.
+	 * Bots searching the same game may share one.  Each bot starts with a
+	 * table of the default size.
+	 */
+	void set_transposition_table(std::shared_ptr<TranspositionTable>);
+	/** Forgets everything learnt in earlier searches: clears the
+	 * transposition table, even a shared one, and the evaluation cache.
+	 */
+	void clear_caches();
+
+	/// endgame tables to take exact values from below the root, may be shared
+	void set_tablebase(std::shared_ptr<const Tablebase>);
+	/// Syzygy tables, may be shared, only probed with set_syzygy_probing
+	void set_syzygy(std::shared_ptr<const SyzygyTablebase>);
+	/** Lets the Syzygy tables decide, off by default.  Below the root they
+	 * then rate positions right after a capture or pawn move.  A root they
+	 * cover is played from the tables without a search unless it is a draw,
+	 * and a draw is searched among the drawing actions only.  The decoder
+	 * has not yet been checked against real table files.
+	 */
+	void set_syzygy_probing(bool);
+
 private:
-	float rate_game(int, float, float, int, Position &, Action * = 0);
-	float rate_game_flat(int, const Position &);
+	/// true once a node or time bound of _limits is exceeded or the stop
+	/// flag is set
+	bool out_of_budget();
+
+	float rate_game(int, float, float, int, int, Position &, Action * = 0);
+	float rate_game_flat(int, int, const Position &);
+	/// the exact rating of a position from the tablebase, if it has one
+	bool rate_tablebase(int dist, const Position &, float &rating);
+	/// the rating of a win, draw or loss from the Syzygy tables, if they have it
+	bool rate_syzygy(int dist, int half_moves, const Position &, float &rating);
+	/// makes action the only line and reports it to the info callback
+	void report_unsearched(const Action &, float rating);
+
+	/// true if the position with the given hash repeats one on _path
+	bool is_repetition(uint64 hash, int half_move_counter) const;
+	/// true if the player to move is mated
+	bool is_checkmate(const Position &) const;
 
 	int _max_depth;
+	SearchLimits _limits;
+	std::function<void(const SearchInfo &)> _info_callback;
+	bool _verbose = true;
+	const std::atomic<bool> *_stop_flag = nullptr;
+
+	std::chrono::steady_clock::time_point _start;
+	/// set once the current iteration may be cut short
+	bool _can_stop = false;
+	bool _stopped = false;
+	/// the best root action of the previous iteration, searched first
+	Action _previous_best;
+	bool _has_previous_best = false;
+
+	Evaluator _evaluator;
+	EvalCache _eval_cache;
+	std::shared_ptr<TranspositionTable> _tt = std::make_shared<TranspositionTable>();
+	std::shared_ptr<const Tablebase> _tablebase;
+	std::shared_ptr<const SyzygyTablebase> _syzygy;
+	bool _syzygy_probing = false;
+	/// the root actions left by the Syzygy tables, empty to search all
+	std::vector<Action> _root_actions;
+	int _multipv = 1;
+	/// root actions already found in the current iteration, skipped by the root
+	std::vector<Action> _root_excluded;
+	std::vector<RootLine> _lines;
+	SearchStats _stats;
+
+	/// hashes of the positions from the last irreversible move down to the
+	/// node currently searched, seeded from the game history
+	std::vector<uint64> _path;
+	/// the best line found below the node at each distance from the root
+	std::vector<std::vector<Action>> _pv;
 };
 
 #endif // SPEEDY_BOT_HPP
@@ -0,0 +1,1007 @@
+#include "SyzygyTablebase.hpp"
+
+#include "Rules.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+/* The file format is the one of Ronald de Man's generator, and the decoding
+ * follows his probing code as adapted by Stockfish.  Every file holds one
+ * table per player to move that the file stores, and with pawns one per
+ * file of the leading pawn.  A table is a sequence of blocks of canonical
+ * Huffman codes, each of which expands into a run of values through a
+ * tree of symbol pairs.  A sparse index points to the block of every
+ * span'th value.
+ */
+
+static const uint8 WDL_MAGIC[4] = {0x71, 0xe8, 0x23, 0x5d};
+static const uint8 DTZ_MAGIC[4] = {0xd7, 0x66, 0x0c, 0xa5};
+
+// flags of the first byte of a file
+static const int FILE_SPLIT = 1;
+static const int FILE_HAS_PAWNS = 2;
+
+// flags of a table, the first two are only used by DTZ tables
+static const int TABLE_PLAYER = 1;
+static const int TABLE_MAPPED = 2;
+static const int TABLE_WIN_PLIES = 4;
+static const int TABLE_LOSS_PLIES = 8;
+static const int TABLE_WIDE = 16;
+static const int TABLE_SINGLE_VALUE = 128;
+
+// a symbol of the Huffman codes, 12 bits are used
+typedef uint16 Sym;
+
+// upper case names of the types, indexed by Type
+static const char PIECE_CHARS[] = "KQRBNP";
+
+#if defined(_WIN32)
+static const char PATH_SEPARATOR = ';';
+#else
+static const char PATH_SEPARATOR = ':';
+#endif
+
+// READING
+
+static uint16 read16(const uint8 *p) {
+	return p[0] | p[1] << 8;
+}
+
+static uint32 read32(const uint8 *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32)p[3] << 24;
+}
+
+static uint32 read32_be(const uint8 *p) {
+	return (uint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint64 read64_be(const uint8 *p) {
+	return (uint64)read32_be(p) << 32 | read32_be(p + 4);
+}
+
+// SQUARES
+
+static int file_of(int square) {
+	return square & 7;
+}
+
+static int rank_of(int square) {
+	return square >> 3;
+}
+
+/// 0 on the diagonal a1-h8, negative below it
+static int off_diagonal(int square) {
+	return rank_of(square) - file_of(square);
+}
+
+/** Tables for encoding the squares of the leading pieces and pawns, and
+ * the binomial coefficients for the other groups.
+ */
+struct SyzygyIndexing {
+	/// the squares below the diagonal a1-h8 to 0..27
+	int map_b1h1h7[64] = {};
+	/// the triangle a1-d1-d4 to 0..9, the diagonal last
+	int map_a1d1d4[64] = {};
+	/// the 462 legal places of two kings with the first in the triangle
+	int map_kk[10][64] = {};
+	/// ways to choose k of n squares, [k][n]
+	uint64 binomial[6][64] = {};
+	/// a2-h7 to 0..47, the highest is the leading pawn
+	int map_pawns[64] = {};
+	/// [number of leading pawns][square of the leading one]
+	int lead_pawn_index[6][64] = {};
+	/// [number of leading pawns][file]
+	int lead_pawns_size[6][4] = {};
+
+	SyzygyIndexing();
+};
+
+SyzygyIndexing::SyzygyIndexing() {
+	int code = 0;
+	for (int s = 0; s < 64; ++s) {
+		if (off_diagonal(s) < 0)
+			map_b1h1h7[s] = code++;
+	}
+
+	std::vector<int> diagonal;
+	code = 0;
+	for (int s = 0; s <= 27; ++s) {
+		if (off_diagonal(s) < 0 && file_of(s) <= 3)
+			map_a1d1d4[s] = code++;
+		else if (off_diagonal(s) == 0 && file_of(s) <= 3)
+			diagonal.push_back(s);
+	}
+	for (int s : diagonal)
+		map_a1d1d4[s] = code++;
+
+	// with the first king on the diagonal, the second is not above it, and
+	// both on the diagonal come last
+	std::vector<std::pair<int, int>> both_on_diagonal;
+	code = 0;
+	for (int i = 0; i < 10; ++i)
+	for (int s1 = 0; s1 <= 27; ++s1) {
+		// b1 is the square mapped to 0
+		if (map_a1d1d4[s1] != i || (i == 0 && s1 != 1))
+			continue;
+		for (int s2 = 0; s2 < 64; ++s2) {
+			int dx = std::abs(file_of(s1) - file_of(s2));
+			int dy = std::abs(rank_of(s1) - rank_of(s2));
+			if (std::max(dx, dy) <= 1)
+				continue;
+			if (off_diagonal(s1) == 0 && off_diagonal(s2) > 0)
+				continue;
+			if (off_diagonal(s1) == 0 && off_diagonal(s2) == 0)
+				both_on_diagonal.push_back(std::make_pair(i, s2));
+			else
+				map_kk[i][s2] = code++;
+		}
+	}
+	for (auto &kings : both_on_diagonal)
+		map_kk[kings.first][kings.second] = code++;
+
+	binomial[0][0] = 1;
+	for (int n = 1; n < 64; ++n)
+	for (int k = 0; k < 6 && k <= n; ++k)
+		binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+
+	// nearer to the edge and lower ranks come first, a file and its mirror
+	// alternate
+	int available = 47;
+	for (int lead = 1; lead <= 5; ++lead)
+	for (int f = 0; f < 4; ++f) {
+		int index = 0;
+		for (int r = 1; r <= 6; ++r) {
+			int s = r * 8 + f;
+			if (lead == 1) {
+				map_pawns[s] = available--;
+				map_pawns[s ^ 7] = available--;
+			}
+			lead_pawn_index[lead][s] = index;
+			index += (int)binomial[lead - 1][map_pawns[s]];
+		}
+		lead_pawns_size[lead][f] = index;
+	}
+}
+
+static const SyzygyIndexing &indexing() {
+	static const SyzygyIndexing tables;
+	return tables;
+}
+
+// TABLES
+
+/** One table of a file, for a player to move and a file of the leading
+ * pawn.  The pointers point into the mapped file.
+ */
+struct SyzygyPairs {
+	uint8 flags = 0;
+	uint64 block_size = 0;
+	/// the sparse index has an entry every span values
+	uint64 span = 0;
+	uint32 blocks = 0;
+	int max_sym_len = 0;
+	/// the value itself for TABLE_SINGLE_VALUE
+	int min_sym_len = 0;
+	/// the lowest symbol of every code length, little endian uint16
+	const uint8 *lowest_sym = nullptr;
+	/// two 12 bit symbols per symbol, in 3 bytes
+	const uint8 *btree = nullptr;
+	/// the number of values in each block - 1, little endian uint16
+	const uint8 *block_length = nullptr;
+	uint32 block_length_size = 0;
+	/// 4 bytes block and 2 bytes offset per entry
+	const uint8 *sparse_index = nullptr;
+	uint64 sparse_index_size = 0;
+	const uint8 *data = nullptr;
+
+	/// the lowest code of every length, padded to 64 bits
+	std::vector<uint64> base64;
+	/// the number of values each symbol expands to - 1
+	std::vector<uint8> symlen;
+
+	/// the pieces in the order of the encoding, as codes of the files
+	uint8 pieces[SYZYGY_MAX_PIECES] = {};
+	/// the pieces are encoded in groups, the lengths are zero terminated
+	int group_length[SYZYGY_MAX_PIECES + 1] = {};
+	uint64 group_index[SYZYGY_MAX_PIECES + 1] = {};
+	/// where the values of each result start in the DTZ map
+	uint16 map_index[4] = {};
+
+	Sym left(int sym) const;
+	Sym right(int sym) const;
+};
+
+struct SyzygyTable {
+	MappedFile wdl_file;
+	MappedFile dtz_file;
+	bool has_dtz = false;
+
+	/// the material as named by the file, and with the colours swapped
+	uint64 key = 0;
+	uint64 key2 = 0;
+	int piece_count = 0;
+	bool has_pawns = false;
+	/// some piece other than a king is the only one of its kind
+	bool has_unique_pieces = false;
+	/// the pawns of the leading colour, the one with fewer, first
+	int pawn_count[2] = {0, 0};
+
+	SyzygyPairs wdl[2][4];
+	SyzygyPairs dtz[4];
+	const uint8 *dtz_map = nullptr;
+
+	SyzygyPairs &pairs(bool is_dtz, int player, int file) {
+		int f = has_pawns ? file : 0;
+		return is_dtz ? dtz[f] : wdl[key != key2 ? player : 0][f];
+	}
+	const SyzygyPairs &pairs(bool is_dtz, int player, int file) const {
+		return const_cast<SyzygyTable *>(this)->pairs(is_dtz, player, file);
+	}
+};
+
+Sym SyzygyPairs::left(int sym) const {
+	const uint8 *lr = btree + 3 * sym;
+	return (lr[1] & 0xf) << 8 | lr[0];
+}
+
+Sym SyzygyPairs::right(int sym) const {
+	const uint8 *lr = btree + 3 * sym;
+	return lr[2] << 4 | lr[1] >> 4;
+}
+
+/// the piece codes of the files: 1 to 6 for pawn to king, black + 8
+static uint8 piece_code(Piece piece) {
+	return (piece.player == PLAYER_BLACK ? 8 : 0) + 6 - piece.type;
+}
+
+static uint64 material_key(const int counts[2][6]) {
+	uint64 key = 0;
+	for (int p = 0; p < 2; ++p)
+	for (int t = 0; t < 6; ++t)
+		key |= (uint64)counts[p][t] << (4 * (p * 6 + t));
+	return key;
+}
+
+static void set_groups(const SyzygyTable &table, SyzygyPairs &d, const int order[2], int file) {
+	const SyzygyIndexing &ix = indexing();
+
+	// the leading group holds the pawns of the leading colour, or the
+	// first three unique pieces, or else the kings
+	int n = 0;
+	int first_length = table.has_pawns ? 0 : table.has_unique_pieces ? 3 : 2;
+	d.group_length[n] = 1;
+	for (int i = 1; i < table.piece_count; ++i) {
+		if (--first_length > 0 || d.pieces[i] == d.pieces[i - 1])
+			d.group_length[n]++;
+		else
+			d.group_length[++n] = 1;
+	}
+	d.group_length[++n] = 0;
+
+	// the groups are encoded as digits of a mixed radix number, in the
+	// order stored in the file
+	bool both_pawns = table.has_pawns && table.pawn_count[1] > 0;
+	int next = both_pawns ? 2 : 1;
+	int free_squares = 64 - d.group_length[0] - (both_pawns ? d.group_length[1] : 0);
+	uint64 index = 1;
+	for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+		if (k == order[0]) {
+			d.group_index[0] = index;
+			index *= table.has_pawns ? ix.lead_pawns_size[d.group_length[0]][file]
+					: table.has_unique_pieces ? 31332 : 462;
+		} else if (k == order[1]) {
+			d.group_index[1] = index;
+			index *= ix.binomial[d.group_length[1]][48 - d.group_length[0]];
+		} else {
+			d.group_index[next] = index;
+			index *= ix.binomial[d.group_length[next]][free_squares];
+			free_squares -= d.group_length[next++];
+		}
+	}
+	d.group_index[n] = index;
+}
+
+static uint8 set_symlen(SyzygyPairs &d, int sym, std::vector<bool> &visited) {
+	visited[sym] = true;
+	int right = d.right(sym);
+	if (right == 0xfff)
+		return 0;
+	int left = d.left(sym);
+	if (left >= (int)d.symlen.size() || right >= (int)d.symlen.size())
+		return 0;
+	if (!visited[left])
+		d.symlen[left] = set_symlen(d, left, visited);
+	if (!visited[right])
+		d.symlen[right] = set_symlen(d, right, visited);
+	return d.symlen[left] + d.symlen[right] + 1;
+}
+
+static const uint8 *set_sizes(SyzygyPairs &d, const uint8 *data) {
+	d.flags = *data++;
+	if (d.flags & TABLE_SINGLE_VALUE) {
+		d.min_sym_len = *data++;
+		return data;
+	}
+
+	int groups = 0;
+	while (d.group_length[groups])
+		++groups;
+	uint64 size = d.group_index[groups];
+	d.block_size = 1ull << *data++;
+	d.span = 1ull << *data++;
+	d.sparse_index_size = (size + d.span - 1) / d.span;
+	int padding = *data++;
+	d.blocks = read32(data);
+	data += 4;
+	// padded so that the sparse index never points past the end
+	d.block_length_size = d.blocks + padding;
+	d.max_sym_len = *data++;
+	d.min_sym_len = *data++;
+	d.lowest_sym = data;
+	if (d.min_sym_len < 1 || d.max_sym_len < d.min_sym_len || d.max_sym_len > 32)
+		return nullptr;
+
+	// longer codes have lower values, so the base of every length is
+	// derived from the next longer one
+	int lengths = d.max_sym_len - d.min_sym_len + 1;
+	d.base64.assign(lengths, 0);
+	for (int i = lengths - 2; i >= 0; --i)
+		d.base64[i] = (d.base64[i + 1] + read16(d.lowest_sym + 2 * i) - read16(d.lowest_sym + 2 * (i + 1))) / 2;
+	for (int i = 0; i < lengths; ++i)
+		d.base64[i] <<= 64 - i - d.min_sym_len;
+	data += 2 * lengths;
+
+	d.symlen.assign(read16(data), 0);
+	data += 2;
+	d.btree = data;
+	std::vector<bool> visited(d.symlen.size());
+	for (size_t sym = 0; sym < d.symlen.size(); ++sym) {
+		if (!visited[sym])
+			d.symlen[sym] = set_symlen(d, (int)sym, visited);
+	}
+	return data + 3 * d.symlen.size() + (d.symlen.size() & 1);
+}
+
+static const uint8 *set_dtz_map(SyzygyTable &table, const uint8 *data, const uint8 *base, int files) {
+	table.dtz_map = data;
+	for (int f = 0; f < files; ++f) {
+		SyzygyPairs &d = table.dtz[f];
+		if (!(d.flags & TABLE_MAPPED))
+			continue;
+		// four lists of values, one per result, each after its length
+		if (d.flags & TABLE_WIDE) {
+			data += (data - base) & 1;
+			for (int i = 0; i < 4; ++i) {
+				d.map_index[i] = (uint16)((data - table.dtz_map) / 2 + 1);
+				data += 2 * read16(data) + 2;
+			}
+		} else {
+			for (int i = 0; i < 4; ++i) {
+				d.map_index[i] = (uint16)(data - table.dtz_map + 1);
+				data += *data + 1;
+			}
+		}
+	}
+	return data + ((data - base) & 1);
+}
+
+/// reads the layout of the tables of a mapped file
+static bool setup(SyzygyTable &table, bool is_dtz) {
+	const MappedFile &file = is_dtz ? table.dtz_file : table.wdl_file;
+	const uint8 *base = reinterpret_cast<const uint8 *>(file.data());
+	const uint8 *end = base + file.size();
+	if (file.size() < 16 || memcmp(base, is_dtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0)
+		return false;
+	const uint8 *data = base + 4;
+	bool split = table.key != table.key2;
+	if (((*data & FILE_HAS_PAWNS) != 0) != table.has_pawns || ((*data & FILE_SPLIT) != 0) != split)
+		return false;
+	++data;
+
+	int sides = !is_dtz && split ? 2 : 1;
+	int files = table.has_pawns ? 4 : 1;
+	bool both_pawns = table.has_pawns && table.pawn_count[1] > 0;
+	for (int f = 0; f < files; ++f) {
+		// each player's nibble tells the position of the leading group
+		// among the groups, and of the other pawns
+		int order[2][2] = {
+			{data[0] & 0xf, both_pawns ? data[1] & 0xf : 0xf},
+			{data[0] >> 4, both_pawns ? data[1] >> 4 : 0xf},
+		};
+		data += 1 + both_pawns;
+		for (int k = 0; k < table.piece_count; ++k, ++data)
+		for (int i = 0; i < sides; ++i)
+			table.pairs(is_dtz, i, f).pieces[k] = i ? *data >> 4 : *data & 0xf;
+		for (int i = 0; i < sides; ++i)
+			set_groups(table, table.pairs(is_dtz, i, f), order[i], f);
+	}
+	data += (data - base) & 1;
+
+	for (int f = 0; f < files; ++f)
+	for (int i = 0; i < sides; ++i) {
+		data = set_sizes(table.pairs(is_dtz, i, f), data);
+		if (!data || data > end)
+			return false;
+	}
+	if (is_dtz)
+		data = set_dtz_map(table, data, base, files);
+
+	for (int f = 0; f < files; ++f)
+	for (int i = 0; i < sides; ++i) {
+		SyzygyPairs &d = table.pairs(is_dtz, i, f);
+		d.sparse_index = data;
+		data += 6 * d.sparse_index_size;
+	}
+	for (int f = 0; f < files; ++f)
+	for (int i = 0; i < sides; ++i) {
+		SyzygyPairs &d = table.pairs(is_dtz, i, f);
+		d.block_length = data;
+		data += 2 * (uint64)d.block_length_size;
+	}
+	for (int f = 0; f < files; ++f)
+	for (int i = 0; i < sides; ++i) {
+		SyzygyPairs &d = table.pairs(is_dtz, i, f);
+		data = base + (((data - base) + 63) & ~63);
+		d.data = data;
+		data += d.blocks * d.block_size;
+	}
+	return data <= end;
+}
+
+/// the value at an index of a table
+static int decompress(const SyzygyPairs &d, uint64 index) {
+	if (d.flags & TABLE_SINGLE_VALUE)
+		return d.min_sym_len;
+
+	// the sparse index gives the block and offset of the value in the middle
+	// of the span, from there the block lengths lead to the right block
+	uint64 k = index / d.span;
+	uint32 block = read32(d.sparse_index + 6 * k);
+	int offset = read16(d.sparse_index + 6 * k + 4);
+	offset += (int)(index % d.span) - (int)(d.span / 2);
+	while (offset < 0)
+		offset += read16(d.block_length + 2 * --block) + 1;
+	while (offset > read16(d.block_length + 2 * block))
+		offset -= read16(d.block_length + 2 * block++) + 1;
+
+	// walk the Huffman codes of the block until the symbol that expands to
+	// the run containing the offset
+	const uint8 *ptr = d.data + (uint64)block * d.block_size;
+	uint64 buffer = read64_be(ptr);
+	ptr += 8;
+	int buffer_size = 64;
+	int sym;
+	while (true) {
+		int length = 0;
+		while (buffer < d.base64[length])
+			++length;
+		sym = (int)((buffer - d.base64[length]) >> (64 - length - d.min_sym_len));
+		sym += read16(d.lowest_sym + 2 * length);
+		if (offset < d.symlen[sym] + 1)
+			break;
+		offset -= d.symlen[sym] + 1;
+		length += d.min_sym_len;
+		buffer <<= length;
+		buffer_size -= length;
+		if (buffer_size <= 32) {
+			buffer_size += 32;
+			buffer |= (uint64)read32_be(ptr) << (64 - buffer_size);
+			ptr += 4;
+		}
+	}
+
+	// pairs of symbols are adjacent in the run, so descend to the leaf
+	while (d.symlen[sym]) {
+		int left = d.left(sym);
+		if (offset < d.symlen[left] + 1) {
+			sym = left;
+		} else {
+			offset -= d.symlen[left] + 1;
+			sym = d.right(sym);
+		}
+	}
+	return d.left(sym);
+}
+
+/// converts the stored value of a DTZ table to plies
+static int map_dtz(const SyzygyTable &table, int file, int value, int wdl) {
+	static const int WDL_MAP[] = {1, 3, 0, 2, 0};
+	const SyzygyPairs &d = table.pairs(true, 0, file);
+	if (d.flags & TABLE_MAPPED) {
+		int index = d.map_index[WDL_MAP[wdl + 2]] + value;
+		value = d.flags & TABLE_WIDE ? read16(table.dtz_map + 2 * index) : table.dtz_map[index];
+	}
+
+	// some tables store moves instead of plies
+	if ((wdl == WDL_WIN && !(d.flags & TABLE_WIN_PLIES))
+			|| (wdl == WDL_LOSS && !(d.flags & TABLE_LOSS_PLIES))
+			|| wdl == WDL_CURSED_WIN
+			|| wdl == WDL_BLESSED_LOSS) {
+		value *= 2;
+	}
+	return value + 1;
+}
+
+// HELPERS
+
+static int sign(int value) {
+	return (value > 0) - (value < 0);
+}
+
+static bool is_capture(const Action &action) {
+	return action.type == CAPTURE_PIECE || action.type == EN_PASSANT;
+}
+
+/// the distance to zeroing of the position before a zeroing move with the result
+static int dtz_before_zeroing(int wdl) {
+	return wdl == WDL_WIN ? 1
+			: wdl == WDL_CURSED_WIN ? 101
+			: wdl == WDL_BLESSED_LOSS ? -101
+			: wdl == WDL_LOSS ? -1
+			: 0;
+}
+
+static bool is_mate(const Position &position) {
+	Rules rules;
+	return rules.isPlayerInCheck(position, position.active_player())
+			&& rules.getAllLegalMoves(position).empty();
+}
+
+static void multisets(int size, int first, const std::string &prefix, std::vector<std::string> &out) {
+	if (size == 0) {
+		out.push_back(prefix);
+		return;
+	}
+	for (int type = first; type < 6; ++type)
+		multisets(size - 1, type, prefix + PIECE_CHARS[type], out);
+}
+
+// SYZYGY TABLEBASE
+
+SyzygyTablebase::SyzygyTablebase() {
+	// nothing
+}
+
+SyzygyTablebase::~SyzygyTablebase() {
+	// nothing
+}
+
+int SyzygyTablebase::open(const char *paths) {
+	close();
+	std::vector<std::string> directories;
+	for (const char *s = paths; *s; ) {
+		const char *separator = strchr(s, PATH_SEPARATOR);
+		const char *end = separator ? separator : s + strlen(s);
+		if (end > s)
+			directories.push_back(std::string(s, end));
+		s = separator ? separator + 1 : end;
+	}
+
+	for (int white = 0; white <= SYZYGY_MAX_PIECES - 2; ++white)
+	for (int black = 0; white + black <= SYZYGY_MAX_PIECES - 2; ++black) {
+		if (white + black == 0)
+			continue;
+		std::vector<std::string> whites, blacks;
+		multisets(white, TYPE_QUEEN, "K", whites);
+		multisets(black, TYPE_QUEEN, "K", blacks);
+		for (auto &w : whites)
+		for (auto &b : blacks)
+			add(directories, w + "v" + b);
+	}
+	return (int)_tables.size();
+}
+
+bool SyzygyTablebase::add(const std::vector<std::string> &directories, const std::string &name) {
+	int counts[2][6] = {};
+	int player = 0;
+	for (char c : name) {
+		if (c == 'v')
+			player = 1;
+		else
+			++counts[player][strchr(PIECE_CHARS, c) - PIECE_CHARS];
+	}
+	int swapped[2][6];
+	for (int t = 0; t < 6; ++t) {
+		swapped[0][t] = counts[1][t];
+		swapped[1][t] = counts[0][t];
+	}
+
+	// the other colouring has been found already
+	std::unique_ptr<SyzygyTable> table(new SyzygyTable());
+	table->key = material_key(counts);
+	table->key2 = material_key(swapped);
+	if (_materials.count(table->key))
+		return false;
+
+	for (int p = 0; p < 2; ++p)
+	for (int t = 0; t < 6; ++t) {
+		table->piece_count += counts[p][t];
+		if (t != TYPE_KING && counts[p][t] == 1)
+			table->has_unique_pieces = true;
+	}
+	int white_pawns = counts[PLAYER_WHITE][TYPE_PAWN];
+	int black_pawns = counts[PLAYER_BLACK][TYPE_PAWN];
+	table->has_pawns = white_pawns + black_pawns > 0;
+	if (table->has_pawns) {
+		// the colour with fewer pawns leads, white on a tie
+		bool white_leads = black_pawns == 0 || (white_pawns > 0 && black_pawns >= white_pawns);
+		table->pawn_count[0] = white_leads ? white_pawns : black_pawns;
+		table->pawn_count[1] = white_leads ? black_pawns : white_pawns;
+	}
+
+	bool found = false;
+	for (auto &directory : directories) {
+		if (table->wdl_file.open((directory + "/" + name + ".rtbw").c_str(), MappedFile::RANDOM)) {
+			found = true;
+			break;
+		}
+	}
+	if (!found || !setup(*table, false))
+		return false;
+	for (auto &directory : directories) {
+		if (table->dtz_file.open((directory + "/" + name + ".rtbz").c_str(), MappedFile::RANDOM)) {
+			table->has_dtz = setup(*table, true);
+			break;
+		}
+	}
+
+	if (table->piece_count > _max_pieces)
+		_max_pieces = table->piece_count;
+	_materials[table->key] = table.get();
+	_materials[table->key2] = table.get();
+	_tables.push_back(std::move(table));
+	return true;
+}
+
+void SyzygyTablebase::close() {
+	_materials.clear();
+	_tables.clear();
+	_max_pieces = 0;
+}
+
+int SyzygyTablebase::max_pieces() const {
+	return _max_pieces;
+}
+
+bool SyzygyTablebase::can_probe(const Position &position) const {
+	if (_max_pieces == 0 || position.width() != 8 || position.height() != 8)
+		return false;
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		if (position.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)))
+			return false;
+	}
+	int count = 0;
+	const Piece *board = position.pieces();
+	for (int square = 0; square < 64; ++square) {
+		if (board[square].type != TYPE_NONE && ++count > _max_pieces)
+			return false;
+	}
+	return true;
+}
+
+bool SyzygyTablebase::probe_wdl(const Position &position, SyzygyWdl &wdl) const {
+	if (!can_probe(position))
+		return false;
+	Position copy = position;
+	ProbeState state = PROBE_OK;
+	int value = search(copy, false, state);
+	if (state == PROBE_FAIL)
+		return false;
+	wdl = static_cast<SyzygyWdl>(value);
+	return true;
+}
+
+bool SyzygyTablebase::probe_dtz(const Position &position, int &dtz) const {
+	if (!can_probe(position))
+		return false;
+	Position copy = position;
+	ProbeState state = PROBE_OK;
+	dtz = probe_dtz(copy, state);
+	return state != PROBE_FAIL;
+}
+
+bool SyzygyTablebase::filter_root(const Position &root, int half_move_counter, std::vector<Action> &actions, SyzygyWdl &wdl) const {
+	if (actions.empty() || !can_probe(root))
+		return false;
+
+	// sure wins rank highest and the ones nearer to zeroing higher, wins
+	// that may run into the fifty-move rule still rank above draws
+	Position position = root;
+	const Board &board = position;
+	std::vector<int> ranks;
+	int best = INT_MIN;
+	for (auto &action : actions) {
+		bool zeroing = is_capture(action) || board[action.src].type == TYPE_PAWN;
+		Delta delta;
+		position.action(action, &delta);
+		ProbeState state = PROBE_OK;
+		int dtz;
+		if (zeroing) {
+			dtz = dtz_before_zeroing(-search(position, false, state));
+		} else {
+			dtz = -probe_dtz(position, state);
+			dtz += sign(dtz);
+		}
+		bool mate = dtz > 0 && state != PROBE_FAIL && is_mate(position);
+		position.apply(delta);
+		if (state == PROBE_FAIL)
+			return false;
+
+		int rank;
+		if (mate)
+			rank = 3000;
+		else if (dtz > 0)
+			rank = dtz + half_move_counter <= 99 ? 2000 - dtz : std::max(1, 1000 - dtz - half_move_counter);
+		else if (dtz < 0)
+			rank = -2 * dtz + half_move_counter < 100 ? -2000 - dtz : std::min(-1, -1000 - dtz + half_move_counter);
+		else
+			rank = 0;
+		ranks.push_back(rank);
+		best = std::max(best, rank);
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < actions.size(); ++i) {
+		if (ranks[i] == best)
+			actions[kept++] = actions[i];
+	}
+	actions.resize(kept);
+	wdl = best > 1000 ? WDL_WIN
+			: best > 0 ? WDL_CURSED_WIN
+			: best == 0 ? WDL_DRAW
+			: best > -1000 ? WDL_BLESSED_LOSS
+			: WDL_LOSS;
+	return true;
+}
+
+// PROBING
+
+int SyzygyTablebase::probe_table(const Position &position, bool is_dtz, int wdl, ProbeState &state) const {
+	const SyzygyIndexing &ix = indexing();
+	const Piece *board = position.pieces();
+	int counts[2][6] = {};
+	int total = 0;
+	for (int square = 0; square < 64; ++square) {
+		if (board[square].type != TYPE_NONE) {
+			++counts[board[square].player][board[square].type];
+			++total;
+		}
+	}
+	// there is no file for the bare kings
+	if (total == 2)
+		return WDL_DRAW;
+
+	uint64 key = material_key(counts);
+	auto found = _materials.find(key);
+	if (found == _materials.end() || (is_dtz && !found->second->has_dtz)) {
+		state = PROBE_FAIL;
+		return 0;
+	}
+	const SyzygyTable &table = *found->second;
+
+	// the file stores its first side as white, and only white to move if
+	// both sides are the same, so the board may have to be flipped
+	int player = position.active_player();
+	bool flip = (table.key == table.key2 && player == PLAYER_BLACK) || key != table.key;
+	int flip_color = flip ? 8 : 0;
+	int flip_squares = flip ? 56 : 0;
+	int stm = flip ? 1 - player : player;
+
+	int squares[SYZYGY_MAX_PIECES];
+	int pieces[SYZYGY_MAX_PIECES];
+	int size = 0;
+	int lead_count = 0;
+	int file = 0;
+	uint64 lead_pawns = 0;
+	auto by_map_pawns = [&](int a, int b) {
+		return ix.map_pawns[a] < ix.map_pawns[b];
+	};
+	if (table.has_pawns) {
+		// the pawns of the leading colour come first, the one nearest to
+		// the edge selects the table
+		int lead = table.pairs(is_dtz, 0, 0).pieces[0] ^ flip_color;
+		Player lead_player = lead & 8 ? PLAYER_BLACK : PLAYER_WHITE;
+		for (int square = 0; square < 64; ++square) {
+			if (board[square].type == TYPE_PAWN && board[square].player == lead_player) {
+				squares[size++] = square ^ flip_squares;
+				lead_pawns |= 1ull << square;
+			}
+		}
+		lead_count = size;
+		std::swap(squares[0], *std::max_element(squares, squares + lead_count, by_map_pawns));
+		file = std::min(file_of(squares[0]), 7 - file_of(squares[0]));
+	}
+
+	if (is_dtz) {
+		const SyzygyPairs &d = table.pairs(true, 0, file);
+		if ((d.flags & TABLE_PLAYER) != stm && !(table.key == table.key2 && !table.has_pawns)) {
+			state = PROBE_CHANGE_PLAYER;
+			return 0;
+		}
+	}
+
+	for (int square = 0; square < 64; ++square) {
+		if (board[square].type != TYPE_NONE && !(lead_pawns & (1ull << square))) {
+			squares[size] = square ^ flip_squares;
+			pieces[size++] = piece_code(board[square]) ^ flip_color;
+		}
+	}
+
+	// same order as the encoding
+	const SyzygyPairs &d = table.pairs(is_dtz, stm, file);
+	for (int i = lead_count; i < size - 1; ++i)
+	for (int j = i + 1; j < size; ++j) {
+		if (d.pieces[i] == pieces[j]) {
+			std::swap(pieces[i], pieces[j]);
+			std::swap(squares[i], squares[j]);
+			break;
+		}
+	}
+
+	// the leading piece is moved to files a-d
+	if (file_of(squares[0]) > 3) {
+		for (int i = 0; i < size; ++i)
+			squares[i] ^= 7;
+	}
+
+	uint64 index;
+	if (table.has_pawns) {
+		index = ix.lead_pawn_index[lead_count][squares[0]];
+		std::stable_sort(squares + 1, squares + lead_count, by_map_pawns);
+		for (int i = 1; i < lead_count; ++i)
+			index += ix.binomial[i][ix.map_pawns[squares[i]]];
+	} else {
+		// and without pawns into the triangle a1-d1-d4, the first piece of
+		// the leading group off the diagonal below it
+		if (rank_of(squares[0]) > 3) {
+			for (int i = 0; i < size; ++i)
+				squares[i] ^= 56;
+		}
+		for (int i = 0; i < d.group_length[0]; ++i) {
+			if (off_diagonal(squares[i]) == 0)
+				continue;
+			if (off_diagonal(squares[i]) > 0) {
+				for (int j = i; j < size; ++j)
+					squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+			}
+			break;
+		}
+
+		if (table.has_unique_pieces) {
+			int adjust1 = squares[1] > squares[0];
+			int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+			if (off_diagonal(squares[0])) {
+				index = ((uint64)ix.map_a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62
+						+ squares[2] - adjust2;
+			} else if (off_diagonal(squares[1])) {
+				index = (6 * 63 + rank_of(squares[0]) * 28 + ix.map_b1h1h7[squares[1]]) * 62
+						+ squares[2] - adjust2;
+			} else if (off_diagonal(squares[2])) {
+				index = 6 * 63 * 62 + 4 * 28 * 62
+						+ rank_of(squares[0]) * 7 * 28
+						+ (rank_of(squares[1]) - adjust1) * 28
+						+ ix.map_b1h1h7[squares[2]];
+			} else {
+				index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+						+ rank_of(squares[0]) * 7 * 6
+						+ (rank_of(squares[1]) - adjust1) * 6
+						+ (rank_of(squares[2]) - adjust2);
+			}
+		} else {
+			index = ix.map_kk[ix.map_a1d1d4[squares[0]]][squares[1]];
+		}
+	}
+
+	// the other groups by their sorted squares, skipping the squares taken
+	// by earlier groups
+	index *= d.group_index[0];
+	int *group = squares + d.group_length[0];
+	bool remaining_pawns = table.has_pawns && table.pawn_count[1] > 0;
+	for (int next = 1; d.group_length[next]; ++next) {
+		std::stable_sort(group, group + d.group_length[next]);
+		uint64 n = 0;
+		for (int i = 0; i < d.group_length[next]; ++i) {
+			int adjust = (int)std::count_if(squares, group, [&](int s) {
+				return group[i] > s;
+			});
+			n += ix.binomial[i + 1][group[i] - adjust - 8 * remaining_pawns];
+		}
+		remaining_pawns = false;
+		index += n * d.group_index[next];
+		group += d.group_length[next];
+	}
+
+	int value = decompress(d, index);
+	return is_dtz ? map_dtz(table, file, value, wdl) : value - 2;
+}
+
+/* Positions where a capture wins, or draws, may store any value that
+ * compresses well, and en passant is not encoded at all.  So the captures
+ * are tried first and the table only used if they are not good enough.
+ * With check_zeroing pawn moves are tried as well, as DTZ tables also
+ * leave out positions where a winning pawn move is best.
+ */
+int SyzygyTablebase::search(Position &position, bool check_zeroing, ProbeState &state) const {
+	Rules rules;
+	std::vector<Action> actions;
+	rules.getAllLegalMoves(position, actions, Rules::EVERY_PROMOTION);
+	const Board &board = position;
+	int best = WDL_LOSS;
+	size_t count = 0;
+	for (auto &action : actions) {
+		if (!is_capture(action) && (!check_zeroing || board[action.src].type != TYPE_PAWN))
+			continue;
+		++count;
+		Delta delta;
+		position.action(action, &delta);
+		int value = -search(position, false, state);
+		position.apply(delta);
+		if (state == PROBE_FAIL)
+			return WDL_DRAW;
+		if (value > best) {
+			best = value;
+			if (value >= WDL_WIN) {
+				state = PROBE_ZEROING_BEST_MOVE;
+				return value;
+			}
+		}
+	}
+
+	// the table can't be trusted if every action was tried
+	bool no_more_actions = count > 0 && count == actions.size();
+	int value = best;
+	if (!no_more_actions) {
+		value = probe_table(position, false, WDL_DRAW, state);
+		if (state == PROBE_FAIL)
+			return WDL_DRAW;
+	}
+	if (best >= value) {
+		state = best > WDL_DRAW || no_more_actions ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+		return best;
+	}
+	state = PROBE_OK;
+	return value;
+}
+
+int SyzygyTablebase::probe_dtz(Position &position, ProbeState &state) const {
+	state = PROBE_OK;
+	int wdl = search(position, true, state);
+	if (state == PROBE_FAIL || wdl == WDL_DRAW)
+		return 0;
+	if (state == PROBE_ZEROING_BEST_MOVE)
+		return dtz_before_zeroing(wdl);
+
+	int dtz = probe_table(position, true, wdl, state);
+	if (state == PROBE_FAIL)
+		return 0;
+	if (state != PROBE_CHANGE_PLAYER)
+		return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * sign(wdl);
+
+	// the table stores the other player, so take the best action from there
+	Rules rules;
+	std::vector<Action> actions;
+	rules.getAllLegalMoves(position, actions, Rules::EVERY_PROMOTION);
+	const Board &board = position;
+	int best = 0xffff;
+	for (auto &action : actions) {
+		bool zeroing = is_capture(action) || board[action.src].type == TYPE_PAWN;
+		Delta delta;
+		position.action(action, &delta);
+		// after a zeroing move only the result counts
+		dtz = zeroing ? -dtz_before_zeroing(search(position, false, state)) : -probe_dtz(position, state);
+		if (dtz == 1 && is_mate(position))
+			best = 1;
+		if (!zeroing)
+			dtz += sign(dtz);
+		if (dtz < best && sign(dtz) == sign(wdl))
+			best = dtz;
+		position.apply(delta);
+		if (state == PROBE_FAIL)
+			return 0;
+	}
+	// no legal actions is a mate
+	return best == 0xffff ? -1 : best;
+}
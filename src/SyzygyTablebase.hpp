@@ -0,0 +1,105 @@
+#ifndef SYZYGY_TABLEBASE_HPP
+#define SYZYGY_TABLEBASE_HPP
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// the largest Syzygy tables in use, kings included
+static const int SYZYGY_MAX_PIECES = 7;
+
+/// one material with its mapped files, defined in SyzygyTablebase.cpp
+struct SyzygyTable;
+
+/** Results of a Syzygy probe for the player to move.  Cursed wins and
+ * blessed losses would be wins and losses without the fifty-move rule.
+ */
+enum SyzygyWdl : int8 {
+	WDL_LOSS = -2,
+	WDL_BLESSED_LOSS,
+	WDL_DRAW,
+	WDL_CURSED_WIN,
+	WDL_WIN,
+};
+
+/** Probes Syzygy endgame tablebases: the .rtbw files with win, draw or
+ * loss and the .rtbz files with the distance to zeroing, i.e. to the next
+ * capture or pawn move with best play.
+ *
+ * The files are memory mapped and only their headers are read when they
+ * are opened, a probe decompresses a single block.  Probing is const and
+ * may be shared between threads.
+ *
+ * The tables don't store every position exactly: positions where a capture
+ * or pawn move is best may hold any value, and en passant is not encoded.
+ * The probes therefore try the captures themselves like the reference
+ * implementation does, so they generate moves with Rules.
+ */
+class SyzygyTablebase {
+public:
+	SyzygyTablebase();
+	~SyzygyTablebase();
+	SyzygyTablebase(const SyzygyTablebase &) = delete;
+	SyzygyTablebase &operator = (const SyzygyTablebase &) = delete;
+
+	/** Maps the tables found in a list of directories, separated by ':'
+	 * (';' on Windows).  Returns the number of WDL tables found.
+	 */
+	int open(const char *paths);
+	void close();
+
+	/// the most pieces any mapped WDL table has, 0 if there are none
+	int max_pieces() const;
+
+	/** Win, draw or loss of a position for the player to move, as if the
+	 * fifty-move counter was just reset.  Returns false if a table is
+	 * missing or the position has castling rights.
+	 */
+	bool probe_wdl(const Position &, SyzygyWdl &) const;
+
+	/** Distance to zeroing in plies, positive if the player to move wins
+	 * and negative if it loses, 0 for draws.  Wins and losses that the
+	 * fifty-move rule turns into draws are 100 plies further away.  The
+	 * tables round some distances up by one ply.
+	 */
+	bool probe_dtz(const Position &, int &dtz) const;
+
+	/** Keeps only the given legal actions of a root position that preserve
+	 * its best result under the fifty-move rule, given the half move
+	 * counter, and stores that result.  Winning actions are reduced further
+	 * to the ones nearest to zeroing, or a mate, losing ones to the ones
+	 * that resist the longest.  Returns false, and leaves the actions
+	 * alone, if a table is missing.
+	 */
+	bool filter_root(const Position &, int half_move_counter, std::vector<Action> &, SyzygyWdl &) const;
+
+private:
+	enum ProbeState {
+		PROBE_FAIL,
+		PROBE_OK,
+		/// the DTZ table only holds the other player to move
+		PROBE_CHANGE_PLAYER,
+		/// a capture or pawn move is best, the DTZ table can't be trusted
+		PROBE_ZEROING_BEST_MOVE,
+	};
+
+	bool add(const std::vector<std::string> &directories, const std::string &name);
+	bool can_probe(const Position &) const;
+
+	/// the raw value from a table, for DTZ given the WDL of the position
+	int probe_table(const Position &, bool dtz, int wdl, ProbeState &) const;
+	/// WDL with the captures tried, and pawn moves if check_zeroing is set
+	int search(Position &, bool check_zeroing, ProbeState &) const;
+	int probe_dtz(Position &, ProbeState &) const;
+
+	std::vector<std::unique_ptr<SyzygyTable>> _tables;
+	/// every table under the keys of both colourings of its material
+	std::unordered_map<uint64, SyzygyTable *> _materials;
+	int _max_pieces = 0;
+};
+
+#endif // SYZYGY_TABLEBASE_HPP
@@ -0,0 +1,342 @@
+#include "Tablebase.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+const char Tablebase::MAGIC[8] = {'C', 'H', 'S', 'T', 'B', 'L', '\r', '\n'};
+const uint8 Tablebase::VALUE_DRAW;
+const uint8 Tablebase::VALUE_ILLEGAL;
+
+// upper case names of the types, indexed by Type
+static const char PIECE_CHARS[] = "KQRBNP";
+
+// the squares of the triangle a1-d1-d4, for the white king without pawns
+static const int TRIANGLE[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+/** One of the eight symmetries of the board: bit 0 mirrors the files,
+ * bit 1 the ranks and bit 2 swaps files and ranks.
+ */
+static int transform(int square, int symmetry) {
+	int x = square & 7, y = square >> 3;
+	if (symmetry & 1)
+		x = 7 - x;
+	if (symmetry & 2)
+		y = 7 - y;
+	if (symmetry & 4) {
+		int t = x;
+		x = y;
+		y = t;
+	}
+	return y * 8 + x;
+}
+
+// MATERIAL
+
+bool TablebaseMaterial::parse(const char *name) {
+	count = 0;
+	has_pawns = false;
+	if (name[0] != 'K')
+		return false;
+
+	// the kings come first, the other pieces are sorted per player
+	Type types[2][TABLEBASE_MAX_PIECES];
+	int counts[2] = {0, 0};
+	int player = 0;
+	for (const char *s = name + 1; *s; ++s) {
+		const char *type = strchr(PIECE_CHARS, *s);
+		if (!type)
+			return false;
+		if (*s == 'K') {
+			if (player == 1)
+				return false;
+			player = 1;
+			continue;
+		}
+		if (2 + counts[0] + counts[1] >= TABLEBASE_MAX_PIECES)
+			return false;
+		Type t = static_cast<Type>(type - PIECE_CHARS);
+		int i = counts[player]++;
+		for (; i > 0 && types[player][i - 1] > t; --i)
+			types[player][i] = types[player][i - 1];
+		types[player][i] = t;
+	}
+	if (player != 1)
+		return false;
+
+	pieces[count++] = Piece{PLAYER_WHITE, TYPE_KING};
+	pieces[count++] = Piece{PLAYER_BLACK, TYPE_KING};
+	for (int p = 0; p < 2; ++p)
+	for (int i = 0; i < counts[p]; ++i) {
+		pieces[count++] = Piece{static_cast<Player>(p), types[p][i]};
+		has_pawns = has_pawns || types[p][i] == TYPE_PAWN;
+	}
+	return true;
+}
+
+std::string TablebaseMaterial::name() const {
+	std::string name;
+	for (int p = 0; p < 2; ++p)
+	for (int i = 0; i < count; ++i) {
+		if (pieces[i].player == p)
+			name += PIECE_CHARS[pieces[i].type];
+	}
+	return name;
+}
+
+TablebaseMaterial TablebaseMaterial::flipped() const {
+	TablebaseMaterial material;
+	for (int p = 1; p >= 0; --p)
+	for (int i = 0; i < count; ++i) {
+		if (pieces[i].type == TYPE_KING && pieces[i].player == p)
+			material.pieces[material.count++] = Piece{static_cast<Player>(1 - p), TYPE_KING};
+	}
+	for (int p = 1; p >= 0; --p)
+	for (int i = 2; i < count; ++i) {
+		if (pieces[i].player == p)
+			material.pieces[material.count++] = Piece{static_cast<Player>(1 - p), pieces[i].type};
+	}
+	material.has_pawns = has_pawns;
+	return material;
+}
+
+bool TablebaseMaterial::is_canonical() const {
+	int white = 2;
+	while (white < count && pieces[white].player == PLAYER_WHITE)
+		++white;
+	int white_count = white - 2;
+	int black_count = count - white;
+	if (white_count != black_count)
+		return white_count > black_count;
+
+	// lower types are stronger
+	for (int i = 0; i < white_count; ++i) {
+		Type w = pieces[2 + i].type;
+		Type b = pieces[white + i].type;
+		if (w != b)
+			return w < b;
+	}
+	return true;
+}
+
+uint32 TablebaseMaterial::key() const {
+	uint32 key = 0;
+	for (int i = 2; i < count; ++i)
+		key += 1u << (3 * (pieces[i].player * 5 + pieces[i].type - 1));
+	return key;
+}
+
+uint64 TablebaseMaterial::size() const {
+	uint64 size = has_pawns ? 32 : 10;
+	for (int i = 1; i < count; ++i)
+		size *= 64;
+	return size;
+}
+
+// TABLES
+
+static void multisets(int size, int first, const std::string &prefix, std::vector<std::string> &out) {
+	if (size == 0) {
+		out.push_back(prefix);
+		return;
+	}
+	for (int type = first; type < 6; ++type)
+		multisets(size - 1, type, prefix + PIECE_CHARS[type], out);
+}
+
+int Tablebase::open(const char *directory) {
+	close();
+	int found = 0;
+	for (int white = 0; white <= TABLEBASE_MAX_PIECES - 2; ++white)
+	for (int black = 0; white + black <= TABLEBASE_MAX_PIECES - 2; ++black) {
+		std::vector<std::string> whites, blacks;
+		multisets(white, TYPE_QUEEN, "K", whites);
+		multisets(black, TYPE_QUEEN, "K", blacks);
+		for (auto &w : whites)
+		for (auto &b : blacks) {
+			TablebaseMaterial material;
+			if (material.parse((w + b).c_str()) && material.is_canonical() && material.count > 2)
+				found += add(path(directory, material).c_str()) ? 1 : 0;
+		}
+	}
+	return found;
+}
+
+bool Tablebase::add(const char *path) {
+	std::unique_ptr<Table> table(new Table());
+	if (!table->file.open(path, MappedFile::RANDOM))
+		return false;
+
+	const size_t header_size = sizeof (TablebaseHeader);
+	if (table->file.size() < header_size)
+		return false;
+	TablebaseHeader header;
+	memcpy(&header, table->file.data(), header_size);
+	header.material[sizeof header.material - 1] = '\0';
+	TablebaseMaterial &material = table->material;
+	if (memcmp(header.magic, MAGIC, sizeof MAGIC) != 0
+			|| header.version != VERSION
+			|| !material.parse(header.material)
+			|| !material.is_canonical()
+			|| table->file.size() != header_size + 2 * material.size()) {
+		return false;
+	}
+
+	const uint8 *data = reinterpret_cast<const uint8 *>(table->file.data()) + header_size;
+	table->values[PLAYER_WHITE] = data;
+	table->values[PLAYER_BLACK] = data + material.size();
+	if (material.count > _max_pieces)
+		_max_pieces = material.count;
+	_tables[material.key()] = std::move(table);
+	return true;
+}
+
+void Tablebase::close() {
+	_tables.clear();
+	_max_pieces = 0;
+}
+
+int Tablebase::max_pieces() const {
+	return _max_pieces;
+}
+
+bool Tablebase::probe(const Position &position, TablebaseValue &value) const {
+	if (position.width() != 8 || position.height() != 8 || position.en_passant_file() >= 0)
+		return false;
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c) {
+		if (position.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)))
+			return false;
+	}
+
+	// the pieces of each player, sorted by type, so the king comes first
+	Piece pieces[2][TABLEBASE_MAX_PIECES];
+	int tiles[2][TABLEBASE_MAX_PIECES];
+	int counts[2] = {0, 0};
+	const Piece *board = position.pieces();
+	for (int square = 0; square < 64; ++square) {
+		Piece piece = board[square];
+		if (piece.type == TYPE_NONE)
+			continue;
+		int p = piece.player;
+		if (counts[0] + counts[1] == TABLEBASE_MAX_PIECES)
+			return false;
+		int i = counts[p]++;
+		for (; i > 0 && pieces[p][i - 1].type > piece.type; --i) {
+			pieces[p][i] = pieces[p][i - 1];
+			tiles[p][i] = tiles[p][i - 1];
+		}
+		pieces[p][i] = piece;
+		tiles[p][i] = square;
+	}
+	if (counts[0] == 0 || counts[1] == 0 || pieces[0][0].type != TYPE_KING || pieces[1][0].type != TYPE_KING)
+		return false;
+	if (counts[0] + counts[1] == 2) {
+		value = TablebaseValue{TB_DRAW, 0};
+		return true;
+	}
+
+	TablebaseMaterial material;
+	int squares[TABLEBASE_MAX_PIECES];
+	int order[TABLEBASE_MAX_PIECES][2] = {{0, 0}, {1, 0}};
+	int n = 2;
+	for (int p = 0; p < 2; ++p)
+	for (int i = 1; i < counts[p]; ++i) {
+		order[n][0] = p;
+		order[n++][1] = i;
+	}
+	material.count = n;
+	for (int i = 0; i < n; ++i) {
+		material.pieces[i] = pieces[order[i][0]][order[i][1]];
+		squares[i] = tiles[order[i][0]][order[i][1]];
+		material.has_pawns = material.has_pawns || material.pieces[i].type == TYPE_PAWN;
+	}
+
+	// tables are stored with the stronger pieces as white
+	Player player = position.active_player();
+	if (!material.is_canonical()) {
+		material = material.flipped();
+		n = 0;
+		squares[n++] = tiles[1][0] ^ 56;
+		squares[n++] = tiles[0][0] ^ 56;
+		for (int p = 1; p >= 0; --p)
+		for (int i = 1; i < counts[p]; ++i)
+			squares[n++] = tiles[p][i] ^ 56;
+		player = player == PLAYER_WHITE ? PLAYER_BLACK : PLAYER_WHITE;
+	}
+
+	auto table = _tables.find(material.key());
+	if (table == _tables.end())
+		return false;
+	uint8 stored = table->second->values[player][index(material, squares)];
+	if (stored == VALUE_ILLEGAL)
+		return false;
+	value = Tablebase::value(stored);
+	return true;
+}
+
+// INDEXING
+
+std::string Tablebase::path(const char *directory, const TablebaseMaterial &material) {
+	return std::string(directory) + "/" + material.name() + ".tb";
+}
+
+uint64 Tablebase::index(const TablebaseMaterial &material, const int *squares) {
+	// kings on the diagonal and equal pieces allow more than one index, the
+	// smallest is used
+	uint64 best = UINT64_MAX;
+	for (int symmetry = 0; symmetry < (material.has_pawns ? 2 : 8); ++symmetry) {
+		int king = transform(squares[0], symmetry);
+		uint64 index;
+		if (material.has_pawns) {
+			// pawns only allow mirroring the files
+			if ((king & 7) > 3)
+				continue;
+			index = (king >> 3) * 4 + (king & 7);
+		} else {
+			const int *found = std::find(TRIANGLE, TRIANGLE + 10, king);
+			if (found == TRIANGLE + 10)
+				continue;
+			index = found - TRIANGLE;
+		}
+
+		int tiles[TABLEBASE_MAX_PIECES];
+		for (int i = 1; i < material.count; ++i) {
+			int tile = transform(squares[i], symmetry);
+			int j = i;
+			for (; j > 1 && material.pieces[j - 1] == material.pieces[i] && tiles[j - 1] > tile; --j)
+				tiles[j] = tiles[j - 1];
+			tiles[j] = tile;
+		}
+		for (int i = 1; i < material.count; ++i)
+			index = index * 64 + tiles[i];
+		best = std::min(best, index);
+	}
+	return best;
+}
+
+void Tablebase::squares(const TablebaseMaterial &material, uint64 index, int *squares) {
+	for (int i = material.count - 1; i > 0; --i) {
+		squares[i] = index % 64;
+		index /= 64;
+	}
+	squares[0] = material.has_pawns ? (index / 4) * 8 + index % 4 : TRIANGLE[index];
+}
+
+TablebaseValue Tablebase::value(uint8 stored) {
+	if (stored == VALUE_DRAW || stored == VALUE_ILLEGAL)
+		return TablebaseValue{TB_DRAW, 0};
+	// the player to move gives mate after an odd number of plies
+	int plies = stored - 1;
+	return TablebaseValue{plies & 1 ? TB_WIN : TB_LOSS, plies};
+}
+
+TablebaseHeader Tablebase::header(const TablebaseMaterial &material) {
+	TablebaseHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, MAGIC, sizeof MAGIC);
+	header.version = VERSION;
+	std::string name = material.name();
+	strncpy(header.material, name.c_str(), sizeof header.material - 1);
+	return header;
+}
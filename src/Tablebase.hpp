@@ -0,0 +1,134 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/// the largest endings tables are generated for, kings included
+static const int TABLEBASE_MAX_PIECES = 5;
+
+enum TablebaseResult : int8 {
+	TB_LOSS = -1,
+	TB_DRAW,
+	TB_WIN,
+};
+
+/// the exact value of a position for the player to move
+struct TablebaseValue {
+	TablebaseResult result;
+	/// plies until mate with best play on both sides, 0 for draws
+	int plies;
+};
+
+/// the first 32 bytes of a table file, the values follow directly
+struct TablebaseHeader {
+	char magic[8];
+	uint32 version;
+	uint32 reserved;
+	/// zero terminated name of the material, e.g. "KQKR"
+	char material[16];
+};
+
+/** The pieces of an ending, in the order tables are indexed by: the white
+ * king, the black king, the other white pieces and then the other black
+ * pieces, both sorted by Type.
+ *
+ * Tables are only stored for canonical materials, where white has at
+ * least as many pieces as black and the stronger ones on a tie.  Others
+ * are probed with the colours swapped.
+ */
+struct TablebaseMaterial {
+	int count = 0;
+	Piece pieces[TABLEBASE_MAX_PIECES];
+	bool has_pawns = false;
+
+	/// reads a name like "KRPKR", returns false if it is not a valid ending
+	bool parse(const char *name);
+	std::string name() const;
+
+	/// the same material with the colours swapped
+	TablebaseMaterial flipped() const;
+	bool is_canonical() const;
+
+	/// identifies a material, independent of the order of the pieces
+	uint32 key() const;
+	/// number of entries for each player to move
+	uint64 size() const;
+};
+
+/** Endgame tablebases with win, draw or loss and the distance to mate,
+ * made by TablebaseGenerator.
+ *
+ * Every table holds one byte per position and player to move.  Positions
+ * are indexed by the tiles of their pieces after a symmetry reduction:
+ * without pawns the white king is moved into the triangle a1-d1-d4 by one
+ * of the eight symmetries of the board, with pawns the board is only
+ * mirrored so that the white king is on files a to d.  The files are
+ * memory mapped, so a probe costs an index computation and a page touch.
+ *
+ * Tables assume that nobody can castle or capture en passant, and they
+ * ignore the fifty-move rule.  Positions with castling or en passant
+ * rights are not probed.
+ */
+class Tablebase {
+public:
+	static const char MAGIC[8];
+	static const uint32 VERSION = 1;
+
+	/// the stored bytes, everything else is the number of plies to mate + 1
+	static const uint8 VALUE_DRAW = 0;
+	static const uint8 VALUE_ILLEGAL = 255;
+	static const int MAX_PLIES = 253;
+
+	Tablebase() = default;
+	Tablebase(const Tablebase &) = delete;
+	Tablebase &operator = (const Tablebase &) = delete;
+
+	/// maps all tables found in directory, returns how many there are
+	int open(const char *directory);
+	/// maps a single table file, returns false if it is not a valid table
+	bool add(const char *path);
+	void close();
+
+	/// the most pieces any mapped table has, 0 if there are none
+	int max_pieces() const;
+
+	/** Looks up an 8x8 position.  Returns false if there is no table for
+	 * its material or it has castling or en passant rights.  Positions
+	 * with only the two kings are always known to be draws.
+	 */
+	bool probe(const Position &, TablebaseValue &) const;
+
+	// INDEXING
+
+	/// the path of the table file for a material
+	static std::string path(const char *directory, const TablebaseMaterial &);
+
+	/** Index of a position, given the tiles of its pieces as y * 8 + x in
+	 * the order of the material.  Symmetric positions get the same index.
+	 */
+	static uint64 index(const TablebaseMaterial &, const int *squares);
+	/// the tiles of the pieces at an index, after the symmetry reduction
+	static void squares(const TablebaseMaterial &, uint64 index, int *squares);
+
+	static TablebaseValue value(uint8);
+	/// fills in a header for a new file
+	static TablebaseHeader header(const TablebaseMaterial &);
+
+private:
+	struct Table {
+		TablebaseMaterial material;
+		MappedFile file;
+		/// by the player to move
+		const uint8 *values[2];
+	};
+
+	std::unordered_map<uint32, std::unique_ptr<Table>> _tables;
+	int _max_pieces = 0;
+};
+
+#endif // TABLEBASE_HPP
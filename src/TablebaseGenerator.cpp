@@ -0,0 +1,448 @@
+#include "TablebaseGenerator.hpp"
+
+#include "Rules.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// entries are handed to the threads in chunks of this size
+static const uint64 CHUNK_SIZE = 4096;
+
+static const char PIECE_CHARS[] = "KQRBNP";
+
+static const int KING_STEPS[8][2] = {{-1, -1}, {-1, 0}, {-1, +1}, {0, -1}, {0, +1}, {+1, -1}, {+1, 0}, {+1, +1}};
+static const int KNIGHT_STEPS[8][2] = {{-1, -2}, {-1, +2}, {+1, -2}, {+1, +2}, {-2, -1}, {-2, +1}, {+2, -1}, {+2, +1}};
+static const int ROOK_STEPS[4][2] = {{+1, 0}, {-1, 0}, {0, -1}, {0, +1}};
+static const int BISHOP_STEPS[4][2] = {{+1, +1}, {+1, -1}, {-1, +1}, {-1, -1}};
+
+static Player opponent_of(Player player) {
+	return player == PLAYER_WHITE ? PLAYER_BLACK : PLAYER_WHITE;
+}
+
+/// captures and promotions lead into another table
+static bool leaves_table(const Action &action) {
+	return action.type == CAPTURE_PIECE || action.type == EN_PASSANT || action.promotion != TYPE_NONE;
+}
+
+/// calls work(begin, end, thread) for chunks of [0, count) on all threads
+static void parallel(int threads, uint64 count, const std::function<void(uint64, uint64, int)> &work) {
+	std::atomic<uint64> next(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			for (uint64 begin = next.fetch_add(CHUNK_SIZE); begin < count; begin = next.fetch_add(CHUNK_SIZE))
+				work(begin, std::min(begin + CHUNK_SIZE, count), t);
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+}
+
+/// an entry of the table being generated
+struct Entry {
+	Player player;
+	uint64 index;
+};
+
+struct TablebaseGenerator::Tables {
+	TablebaseMaterial material;
+	uint64 size;
+	/// as stored in the file, by the player to move
+	std::vector<uint8> values[2];
+	/// the ply at which a capture or promotion may decide the entry, or 0
+	std::vector<uint8> wake[2];
+	/// the ply at which a successor of the entry was decided
+	std::unique_ptr<std::atomic<uint8>[]> dirty[2];
+};
+
+/** The per-thread state for examining entries.
+ */
+class TablebaseGenerator::Worker {
+public:
+	Worker(Tables &tables, const Tablebase &tablebase) :
+		_tables(tables),
+		_material(tables.material),
+		_tablebase(tablebase),
+		_position(Board(), PLAYER_WHITE, Position::CASTLING_ALL_FALSE)
+	{
+		// nothing
+	}
+
+	/// resolves mates and stalemates and notes captures and promotions
+	void initialize(Player player, uint64 index) {
+		uint8 &value = _tables.values[player][index];
+		if (!setup(player, index) || Tablebase::index(_material, _squares) != index
+				|| _rules.isPlayerInCheck(_position, opponent_of(player))) {
+			// impossible, or a symmetric copy of another entry
+			value = Tablebase::VALUE_ILLEGAL;
+			return;
+		}
+
+		_actions.clear();
+		_rules.getAllLegalMoves(_position, _actions, Rules::EVERY_PROMOTION);
+		if (_actions.empty()) {
+			if (_rules.isPlayerInCheck(_position, player)) {
+				value = 1;
+				resolved.push_back(Entry{player, index});
+			}
+			return;
+		}
+
+		int min_loss = INT_MAX, max_win = -1;
+		bool leaves = false, draws = false;
+		for (auto &action : _actions) {
+			if (!leaves_table(action))
+				continue;
+			leaves = true;
+			TablebaseValue child = value_after(player, action);
+			if (child.result == TB_LOSS)
+				min_loss = std::min(min_loss, child.plies);
+			else if (child.result == TB_WIN)
+				max_win = std::max(max_win, child.plies);
+			else
+				draws = true;
+		}
+
+		// the ply at which this entry could be decided by them
+		int wake = 0;
+		if (min_loss != INT_MAX)
+			wake = min_loss + 1;
+		else if (leaves && !draws)
+			wake = max_win + 1;
+		if (wake > Tablebase::MAX_PLIES)
+			wake = 0;
+		_tables.wake[player][index] = wake;
+		max_wake = std::max(max_wake, wake);
+	}
+
+	/** True if the entry is decided at the given ply: at odd plies it is
+	 * won if a successor is lost after one ply less, at even plies it is
+	 * lost if all successors are won, the slowest after one ply less.
+	 */
+	bool resolves(Player player, uint64 index, int ply) {
+		setup(player, index);
+		_actions.clear();
+		_rules.getAllLegalMoves(_position, _actions, Rules::EVERY_PROMOTION);
+		if (_actions.empty())
+			return false;
+
+		bool win = ply & 1;
+		int max_win = -1;
+		for (auto &action : _actions) {
+			TablebaseValue child = value_after(player, action);
+			if (win && child.result == TB_LOSS && child.plies == ply - 1)
+				return true;
+			if (!win) {
+				if (child.result != TB_WIN)
+					return false;
+				max_win = std::max(max_win, child.plies);
+			}
+		}
+		return !win && max_win == ply - 1;
+	}
+
+	/// marks every undecided entry that can reach a decided one in one move
+	void mark_predecessors(const Entry &entry, int ply) {
+		int squares[TABLEBASE_MAX_PIECES];
+		Tablebase::squares(_material, entry.index, squares);
+		uint64 occupied = 0;
+		for (int i = 0; i < _material.count; ++i)
+			occupied |= 1ULL << squares[i];
+
+		Player mover = opponent_of(entry.player);
+		auto mark = [&](int i, int x, int y) {
+			int saved = squares[i];
+			squares[i] = y * 8 + x;
+			uint64 index = Tablebase::index(_material, squares);
+			if (_tables.values[mover][index] == Tablebase::VALUE_DRAW)
+				_tables.dirty[mover][index].store(ply, std::memory_order_relaxed);
+			squares[i] = saved;
+		};
+		auto is_free = [&](int x, int y) {
+			return x >= 0 && x < 8 && y >= 0 && y < 8 && !(occupied & (1ULL << (y * 8 + x)));
+		};
+		auto steps = [&](int i, const int (*offsets)[2], int count, bool slide) {
+			int x = squares[i] & 7, y = squares[i] >> 3;
+			for (int d = 0; d < count; ++d) {
+				int tx = x + offsets[d][0], ty = y + offsets[d][1];
+				for (; is_free(tx, ty); tx += offsets[d][0], ty += offsets[d][1]) {
+					mark(i, tx, ty);
+					if (!slide)
+						break;
+				}
+			}
+		};
+
+		for (int i = 0; i < _material.count; ++i) {
+			if (_material.pieces[i].player != mover)
+				continue;
+			switch (_material.pieces[i].type) {
+			case TYPE_KING:
+				steps(i, KING_STEPS, 8, false);
+				break;
+			case TYPE_QUEEN:
+				steps(i, ROOK_STEPS, 4, true);
+				steps(i, BISHOP_STEPS, 4, true);
+				break;
+			case TYPE_ROOK:
+				steps(i, ROOK_STEPS, 4, true);
+				break;
+			case TYPE_BISHOP:
+				steps(i, BISHOP_STEPS, 4, true);
+				break;
+			case TYPE_KNIGHT:
+				steps(i, KNIGHT_STEPS, 8, false);
+				break;
+			case TYPE_PAWN: {
+				// pawns can only be taken back to rows they may stand on
+				int x = squares[i] & 7, y = squares[i] >> 3;
+				int back = mover == PLAYER_WHITE ? -1 : +1;
+				int double_row = mover == PLAYER_WHITE ? 3 : 4;
+				if (y + back >= 1 && y + back <= 6 && is_free(x, y + back)) {
+					mark(i, x, y + back);
+					if (y == double_row && is_free(x, y + 2 * back))
+						mark(i, x, y + 2 * back);
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+
+	std::vector<Entry> resolved;
+	int max_wake = 0;
+
+private:
+	/// places the pieces of an entry, returns false if the entry is impossible
+	bool setup(Player player, uint64 index) {
+		int squares[TABLEBASE_MAX_PIECES];
+		Tablebase::squares(_material, index, squares);
+		uint64 occupied = 0;
+		for (int i = 0; i < _material.count; ++i) {
+			uint64 bit = 1ULL << squares[i];
+			int row = squares[i] >> 3;
+			if (occupied & bit)
+				return false;
+			if (_material.pieces[i].type == TYPE_PAWN && (row == 0 || row == 7))
+				return false;
+			occupied |= bit;
+		}
+
+		const Board &board = _position;
+		for (int square = 0; square < 64; ++square) {
+			if (board.pieces()[square].type != TYPE_NONE)
+				_position.removePiece(Tile(square & 7, square >> 3));
+		}
+		for (int i = 0; i < _material.count; ++i)
+			_position.setPiece(Tile(squares[i] & 7, squares[i] >> 3), _material.pieces[i]);
+		_position.active_player() = player;
+		_position.en_passant_file() = -1;
+		std::copy(squares, squares + _material.count, _squares);
+		return true;
+	}
+
+	/** The value of the position after an action, for the opponent.  En
+	 * passant rights after a double step are ignored.
+	 */
+	TablebaseValue value_after(Player player, const Action &action) {
+		if (leaves_table(action)) {
+			Delta delta;
+			_position.action(action, &delta);
+			TablebaseValue value;
+			if (!_tablebase.probe(_position, value))
+				value = TablebaseValue{TB_DRAW, 0};
+			_position.apply(delta);
+			return value;
+		}
+
+		int squares[TABLEBASE_MAX_PIECES];
+		int src = action.src[1] * 8 + action.src[0];
+		for (int i = 0; i < _material.count; ++i)
+			squares[i] = _squares[i] == src ? action.dst[1] * 8 + action.dst[0] : _squares[i];
+		uint64 index = Tablebase::index(_material, squares);
+		return Tablebase::value(_tables.values[opponent_of(player)][index]);
+	}
+
+	Tables &_tables;
+	const TablebaseMaterial &_material;
+	const Tablebase &_tablebase;
+	Rules _rules;
+	Position _position;
+	std::vector<Action> _actions;
+	int _squares[TABLEBASE_MAX_PIECES];
+};
+
+TablebaseGenerator::TablebaseGenerator(const char *directory, int threads) :
+	_directory(directory),
+	_threads(std::max(1, threads))
+{
+	// nothing
+}
+
+void TablebaseGenerator::set_verbose(bool verbose) {
+	_verbose = verbose;
+}
+
+bool TablebaseGenerator::generate(const char *name) {
+	TablebaseMaterial material;
+	if (!material.parse(name) || material.count < 3)
+		return false;
+	if (!material.is_canonical())
+		material = material.flipped();
+	return require(material);
+}
+
+bool TablebaseGenerator::require(const TablebaseMaterial &material) {
+	std::string name = material.name();
+	if (_available.count(name))
+		return true;
+	std::string path = Tablebase::path(_directory.c_str(), material);
+	if (!_tablebase.add(path.c_str())) {
+		if (!generate(material) || !_tablebase.add(path.c_str()))
+			return false;
+	}
+	_available.insert(name);
+	return true;
+}
+
+bool TablebaseGenerator::generate(const TablebaseMaterial &material) {
+	// every material one capture or promotion away comes first
+	std::vector<Type> types[2];
+	for (int i = 2; i < material.count; ++i)
+		types[material.pieces[i].player].push_back(material.pieces[i].type);
+	auto child = [&](int promoted, Type promotion, int captured) {
+		std::string name[2] = {"K", "K"};
+		for (int p = 0; p < 2; ++p)
+		for (int i = 0; i < (int)types[p].size(); ++i) {
+			int piece = p * TABLEBASE_MAX_PIECES + i;
+			if (piece == captured)
+				continue;
+			name[p] += PIECE_CHARS[piece == promoted ? promotion : types[p][i]];
+		}
+		TablebaseMaterial result;
+		result.parse((name[0] + name[1]).c_str());
+		if (!result.is_canonical())
+			result = result.flipped();
+		return result;
+	};
+	std::vector<TablebaseMaterial> children;
+	for (int p = 0; p < 2; ++p)
+	for (int i = 0; i < (int)types[p].size(); ++i) {
+		int piece = p * TABLEBASE_MAX_PIECES + i;
+		children.push_back(child(-1, TYPE_NONE, piece));
+		if (types[p][i] != TYPE_PAWN)
+			continue;
+		for (Type promotion : {TYPE_QUEEN, TYPE_ROOK, TYPE_BISHOP, TYPE_KNIGHT}) {
+			children.push_back(child(piece, promotion, -1));
+			for (int j = 0; j < (int)types[1 - p].size(); ++j)
+				children.push_back(child(piece, promotion, (1 - p) * TABLEBASE_MAX_PIECES + j));
+		}
+	}
+	for (auto &c : children) {
+		if (c.count > 2 && !require(c))
+			return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Tables tables;
+	tables.material = material;
+	tables.size = material.size();
+	uint64 size = tables.size;
+	for (int p = 0; p < 2; ++p) {
+		tables.values[p].assign(size, Tablebase::VALUE_DRAW);
+		tables.wake[p].assign(size, 0);
+		tables.dirty[p].reset(new std::atomic<uint8>[size]);
+	}
+	std::vector<std::unique_ptr<Worker>> workers;
+	for (int t = 0; t < _threads; ++t)
+		workers.emplace_back(new Worker(tables, _tablebase));
+
+	// entries of both players are numbered player * size + index
+	auto for_all = [&](const std::function<void(Worker &, Player, uint64)> &work) {
+		parallel(_threads, 2 * size, [&](uint64 begin, uint64 end, int t) {
+			for (uint64 i = begin; i < end; ++i) {
+				Player player = i < size ? PLAYER_WHITE : PLAYER_BLACK;
+				work(*workers[t], player, i < size ? i : i - size);
+			}
+		});
+	};
+	for_all([&](Worker &, Player player, uint64 index) {
+		tables.dirty[player][index].store(0, std::memory_order_relaxed);
+	});
+	for_all([&](Worker &worker, Player player, uint64 index) {
+		worker.initialize(player, index);
+	});
+
+	std::vector<Entry> resolved;
+	int max_wake = 0;
+	auto collect = [&](int ply) {
+		resolved.clear();
+		for (auto &worker : workers) {
+			resolved.insert(resolved.end(), worker->resolved.begin(), worker->resolved.end());
+			worker->resolved.clear();
+			max_wake = std::max(max_wake, worker->max_wake);
+		}
+		for (auto &entry : resolved)
+			tables.values[entry.player][entry.index] = ply + 1;
+	};
+	collect(0);
+
+	int longest = 0;
+	for (int ply = 1; ply <= Tablebase::MAX_PLIES; ++ply) {
+		if (resolved.empty() && ply > max_wake)
+			break;
+		parallel(_threads, resolved.size(), [&](uint64 begin, uint64 end, int t) {
+			for (uint64 i = begin; i < end; ++i)
+				workers[t]->mark_predecessors(resolved[i], ply);
+		});
+		for_all([&](Worker &worker, Player player, uint64 index) {
+			if (tables.values[player][index] != Tablebase::VALUE_DRAW)
+				return;
+			if (tables.dirty[player][index].load(std::memory_order_relaxed) != ply
+					&& tables.wake[player][index] != ply)
+				return;
+			if (worker.resolves(player, index, ply))
+				worker.resolved.push_back(Entry{player, index});
+		});
+		collect(ply);
+		if (!resolved.empty())
+			longest = ply;
+	}
+
+	std::string path = Tablebase::path(_directory.c_str(), material);
+	TablebaseHeader header = Tablebase::header(material);
+	FILE *file = fopen(path.c_str(), "wb");
+	bool ok = file
+			&& fwrite(&header, sizeof header, 1, file) == 1
+			&& fwrite(tables.values[0].data(), 1, size, file) == size
+			&& fwrite(tables.values[1].data(), 1, size, file) == size;
+	if (file && fclose(file) != 0)
+		ok = false;
+	if (!ok) {
+		fprintf(stderr, "can't write %s\n", path.c_str());
+		return false;
+	}
+
+	if (_verbose) {
+		uint64 counts[3] = {0, 0, 0};
+		for (int p = 0; p < 2; ++p)
+		for (uint8 stored : tables.values[p]) {
+			if (stored != Tablebase::VALUE_ILLEGAL)
+				++counts[Tablebase::value(stored).result + 1];
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%s: %llu wins, %llu draws, %llu losses, longest mate %d plies, %.1f s\n",
+				material.name().c_str(), (unsigned long long)counts[2], (unsigned long long)counts[1],
+				(unsigned long long)counts[0], longest, seconds);
+	}
+	return true;
+}
@@ -0,0 +1,53 @@
+#ifndef TABLEBASE_GENERATOR_HPP
+#define TABLEBASE_GENERATOR_HPP
+
+#include "Tablebase.hpp"
+
+#include <set>
+#include <string>
+
+/** Generates Tablebase files by retrograde analysis.
+ *
+ * All positions of a material are first checked for legality, mates and
+ * stalemates with Rules.  Captures and promotions lead into smaller
+ * tables, which are generated before and probed.  Then the values are
+ * resolved ply by ply: after a position got its value, the positions that
+ * can reach it by taking back one move are queued, and only those are
+ * examined again at the next ply.  Every ply is split among the threads.
+ *
+ * Memory use is three bytes per entry, so 5 piece endings without pawns
+ * need about a gigabyte.
+ */
+class TablebaseGenerator {
+public:
+	TablebaseGenerator(const char *directory, int threads = 1);
+	TablebaseGenerator(const TablebaseGenerator &) = delete;
+	TablebaseGenerator &operator = (const TablebaseGenerator &) = delete;
+
+	/** Generates the table of a material, given as e.g. "KRPKR", and every
+	 * smaller table it depends on that is not in the directory yet.
+	 * Returns false if the material is invalid or a file can't be written.
+	 */
+	bool generate(const char *material);
+
+	/// print a summary of every generated table to stdout, on by default
+	void set_verbose(bool);
+
+private:
+	struct Tables;
+	class Worker;
+
+	/// maps the table of a material, generating it first if needed
+	bool require(const TablebaseMaterial &);
+	bool generate(const TablebaseMaterial &);
+
+	std::string _directory;
+	int _threads;
+	bool _verbose = true;
+
+	/// the smaller tables probed for captures and promotions
+	Tablebase _tablebase;
+	std::set<std::string> _available;
+};
+
+#endif // TABLEBASE_GENERATOR_HPP
@@ -0,0 +1,97 @@
+#include "TranspositionTable.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// the layout of the data word, a zero word is an empty slot
+static const uint64 DATA_USED = 1ull << 63;
+static const int SHIFT_DEPTH = 32;
+static const int SHIFT_BOUND = 40;
+static const int SHIFT_SRC = 42;
+static const int SHIFT_DST = 50;
+static const int SHIFT_PROMOTION = 58;
+
+static uint64 pack_tile(Tile tile) {
+	return (uint64)(tile[0] & 15) | (uint64)(tile[1] & 15) << 4;
+}
+
+static Tile unpack_tile(uint64 bits) {
+	return Tile((Coord)(bits & 15), (Coord)((bits >> 4) & 15));
+}
+
+TranspositionTable::TranspositionTable(size_t size) {
+	resize(size);
+}
+
+void TranspositionTable::resize(size_t size) {
+	size_t slots = 1;
+	while (slots * 2 <= size)
+		slots *= 2;
+
+	_slots.reset(new std::atomic<uint64>[2 * slots]);
+	_mask = slots - 1;
+	clear();
+}
+
+void TranspositionTable::clear() {
+	for (size_t i = 0; i < 2 * size(); ++i)
+		_slots[i].store(0, std::memory_order_relaxed);
+}
+
+size_t TranspositionTable::size() const {
+	return _mask + 1;
+}
+
+bool TranspositionTable::probe(uint64 hash, Entry &entry) const {
+	size_t slot = 2 * (hash & _mask);
+	uint64 check = _slots[slot].load(std::memory_order_relaxed);
+	uint64 data = _slots[slot + 1].load(std::memory_order_relaxed);
+	if (!(data & DATA_USED) || (check ^ data) != hash)
+		return false;
+
+	uint32 rating = (uint32)data;
+	memcpy(&entry.rating, &rating, sizeof entry.rating);
+	entry.depth = (data >> SHIFT_DEPTH) & 0xff;
+	entry.bound = static_cast<Bound>((data >> SHIFT_BOUND) & 3);
+	entry.src = unpack_tile(data >> SHIFT_SRC);
+	entry.dst = unpack_tile(data >> SHIFT_DST);
+	entry.promotion = static_cast<Type>((int)((data >> SHIFT_PROMOTION) & 7) - 1);
+	return true;
+}
+
+void TranspositionTable::store(uint64 hash, const Entry &entry) {
+	uint32 rating;
+	memcpy(&rating, &entry.rating, sizeof rating);
+	uint64 data = DATA_USED
+			| rating
+			| (uint64)std::min(std::max(entry.depth, 0), 255) << SHIFT_DEPTH
+			| (uint64)entry.bound << SHIFT_BOUND
+			| pack_tile(entry.src) << SHIFT_SRC
+			| pack_tile(entry.dst) << SHIFT_DST
+			| (uint64)(entry.promotion + 1) << SHIFT_PROMOTION;
+	size_t slot = 2 * (hash & _mask);
+	_slots[slot].store(hash ^ data, std::memory_order_relaxed);
+	_slots[slot + 1].store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+	size_t sample = std::min(size(), (size_t)1000);
+	size_t used = 0;
+	for (size_t i = 0; i < sample; ++i) {
+		if (_slots[2 * i + 1].load(std::memory_order_relaxed) & DATA_USED)
+			++used;
+	}
+	return (int)(used * 1000 / sample);
+}
+
+TranspositionTable::Entry TranspositionTable::entry(float rating, int depth, Bound bound, const Action &action) {
+	bool fits = action.src[0] < 16 && action.src[1] < 16 && action.dst[0] < 16 && action.dst[1] < 16;
+	if (!fits || action.src == action.dst)
+		return Entry{rating, depth, bound, Tile(0, 0), Tile(0, 0), TYPE_NONE};
+	return Entry{rating, depth, bound, action.src, action.dst, action.promotion};
+}
+
+bool TranspositionTable::matches(const Entry &entry, const Action &action) {
+	return entry.src != entry.dst && action.src == entry.src && action.dst == entry.dst
+			&& action.promotion == entry.promotion;
+}
@@ -0,0 +1,71 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include "Action.hpp"
+
+#include <atomic>
+#include <memory>
+
+/** Remembers the results of searched positions: the rating, how deep it
+ * was searched, whether it is exact or a bound, and the best action.
+ *
+ * Like the EvalCache it is direct-mapped and a newer entry overwrites the
+ * old one.  It can be shared by threads searching at the same time
+ * without locks: every slot is two words, one of them the hash XORed with
+ * the other, so a slot torn by two writers fails the check on the next
+ * probe instead of returning a wrong entry.
+ */
+class TranspositionTable {
+public:
+
+	static const size_t DEFAULT_SIZE = 1 << 20;
+	/// bytes per slot, for sizing a table by memory
+	static const size_t SLOT_SIZE = 16;
+
+	enum Bound : uint8 {
+		BOUND_EXACT,
+		BOUND_LOWER,
+		BOUND_UPPER,
+	};
+
+	struct Entry {
+		float rating;
+		/// the remaining depth of the search that stored it
+		int depth;
+		Bound bound;
+		/// the best action, src == dst if there is none
+		Tile src;
+		Tile dst;
+		Type promotion;
+	};
+
+	TranspositionTable(size_t size = DEFAULT_SIZE);
+	~TranspositionTable() = default;
+	TranspositionTable(const TranspositionTable &) = delete;
+	TranspositionTable &operator = (const TranspositionTable &) = delete;
+
+	/** Changes the number of slots.  The size is rounded down to a power of
+	 * two and all entries are dropped.  Nobody may search meanwhile.
+	 */
+	void resize(size_t size);
+	void clear();
+	size_t size() const;
+
+	bool probe(uint64 hash, Entry &) const;
+	void store(uint64 hash, const Entry &);
+
+	/// used slots per thousand, sampled from the first thousand slots
+	int hashfull() const;
+
+	/// the entry for an action, boards up to 16x16 keep it
+	static Entry entry(float rating, int depth, Bound, const Action &);
+	/// true if the entry's best action is the given one
+	static bool matches(const Entry &, const Action &);
+
+private:
+	/// two words per slot: the hash XOR the data, and the data
+	std::unique_ptr<std::atomic<uint64>[]> _slots;
+	size_t _mask = 0;
+};
+
+#endif // TRANSPOSITION_TABLE_HPP
@@ -0,0 +1,455 @@
+/* Builds an opening book from PGN game archives.
+ *
+ * Every valid, finished game contributes one (position key, move, result)
+ * tuple for each of its first plies.  Worker threads read parts of the
+ * memory mapped archive and collect tuples in a buffer; a full buffer is
+ * sorted, equal tuples are combined and the result is written to a run
+ * file.  The runs are then merged into a Polyglot book, at most
+ * MAX_FAN_IN at a time and in several passes if there are more, so
+ * archives of any size can be processed with a fixed amount of memory and
+ * a fixed number of open files.
+ *
+ * The weight of a move is 2 * wins + draws from the point of view of the
+ * player making it, scaled per position to fit into 16 bits.  Positions
+ * get the standard Polyglot keys, so other programs can read the book.
+ *
+ * usage: bookbuild <games.pgn> [-o <book.bin>] [-p <plies>] [-n <min games>]
+ *                  [-m <memory MB>] [-t <threads>]
+ */
+
+#include "MappedFile.hpp"
+#include "PgnReader.hpp"
+#include "PolyglotBook.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t PART_SIZE = 4 << 20;
+/// runs read at the same time by one merge
+static const size_t MAX_FAN_IN = 64;
+/// records buffered per run while merging, at least
+static const size_t MIN_READ_BUFFER = 256;
+
+/// statistics of one move in one position, results from the mover's view
+struct BookRecord {
+	uint64 key;
+	uint16 move;
+	uint16 unused;
+	uint32 wins;
+	uint32 draws;
+	uint32 losses;
+};
+
+static bool operator < (const BookRecord &lhs, const BookRecord &rhs) {
+	return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.move < rhs.move);
+}
+
+static bool same_move(const BookRecord &lhs, const BookRecord &rhs) {
+	return lhs.key == rhs.key && lhs.move == rhs.move;
+}
+
+static void combine(BookRecord &into, const BookRecord &from) {
+	into.wins += from.wins;
+	into.draws += from.draws;
+	into.losses += from.losses;
+}
+
+struct Options {
+	const char *input = nullptr;
+	const char *output = "book.bin";
+	int plies = 20;
+	int min_games = 1;
+	size_t memory = 256 << 20;
+	int threads = 1;
+};
+
+// RUN GENERATION
+
+class RunWriter {
+public:
+	RunWriter(const Options &options) : _options(options) {}
+
+	/// sorts and combines the records and writes them as a new run
+	bool write(std::vector<BookRecord> &records) {
+		if (records.empty())
+			return true;
+		std::sort(records.begin(), records.end());
+		size_t out = 0;
+		for (size_t i = 1; i < records.size(); ++i) {
+			if (same_move(records[out], records[i]))
+				combine(records[out], records[i]);
+			else
+				records[++out] = records[i];
+		}
+		size_t count = out + 1;
+
+		std::string path;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			path = std::string(_options.output) + ".run" + std::to_string(_paths.size());
+			_paths.push_back(path);
+		}
+		FILE *file = fopen(path.c_str(), "wb");
+		bool ok = file && fwrite(records.data(), sizeof (BookRecord), count, file) == count;
+		if (file && fclose(file) != 0)
+			ok = false;
+		records.clear();
+		if (!ok)
+			_failed = true;
+		return ok;
+	}
+
+	const std::vector<std::string> &paths() const { return _paths; }
+	bool failed() const { return _failed; }
+
+private:
+	const Options &_options;
+	std::mutex _mutex;
+	std::vector<std::string> _paths;
+	std::atomic<bool> _failed{false};
+};
+
+struct Counters {
+	std::atomic<uint64> games{0};
+	std::atomic<uint64> used{0};
+	std::atomic<uint64> tuples{0};
+};
+
+static void read_part(const char *begin, const char *end, const Options &options,
+		std::vector<BookRecord> &buffer, size_t capacity, RunWriter &runs, Counters &counters) {
+	PgnReader reader(begin, end);
+	PgnGame game;
+	PgnError error;
+	Situation situation;
+	uint64 games = 0, used = 0, tuples = 0;
+	while (reader.next(game, error)) {
+		++games;
+		if (error.message || game.result == PGN_RESULT_UNKNOWN)
+			continue;
+		++used;
+
+		situation = game.start;
+		int plies = std::min<int>(options.plies, game.actions.size());
+		for (int i = 0; i < plies; ++i) {
+			const Action &action = game.actions[i];
+			Player player = situation.active_player();
+			BookRecord record = {PolyglotBook::key(situation), PolyglotBook::encode_move(situation, action), 0, 0, 0, 0};
+			if (game.result == PGN_DRAW)
+				record.draws = 1;
+			else if ((game.result == PGN_WHITE_WINS) == (player == PLAYER_WHITE))
+				record.wins = 1;
+			else
+				record.losses = 1;
+			buffer.push_back(record);
+			++tuples;
+			if (buffer.size() >= capacity)
+				runs.write(buffer);
+			situation.action(action);
+		}
+	}
+	counters.games += games;
+	counters.used += used;
+	counters.tuples += tuples;
+}
+
+// MERGING
+
+class RunReader {
+public:
+	/// returns false if the run can't be opened or read, runs are never empty
+	bool open(const std::string &path, size_t buffer_records) {
+		_file = fopen(path.c_str(), "rb");
+		_buffer.resize(buffer_records);
+		return _file && fill();
+	}
+
+	~RunReader() {
+		if (_file)
+			fclose(_file);
+	}
+
+	const BookRecord &current() const { return _buffer[_position]; }
+
+	/// moves to the next record, returns false at the end of the run or on an error
+	bool advance() {
+		return ++_position < _count || fill();
+	}
+
+	bool failed() const {
+		return !_file || ferror(_file);
+	}
+
+private:
+	bool fill() {
+		_count = fread(_buffer.data(), sizeof (BookRecord), _buffer.size(), _file);
+		_position = 0;
+		return _count > 0;
+	}
+
+	FILE *_file = nullptr;
+	std::vector<BookRecord> _buffer;
+	size_t _position = 0;
+	size_t _count = 0;
+};
+
+class BookWriter {
+public:
+	BookWriter(const Options &options) : _options(options) {}
+
+	bool open() {
+		_file = fopen(_options.output, "wb");
+		return _file != nullptr;
+	}
+
+	bool close() {
+		flush_position();
+		bool ok = _file && !ferror(_file);
+		if (_file && fclose(_file) != 0)
+			ok = false;
+		_file = nullptr;
+		return ok;
+	}
+
+	void add(const BookRecord &record) {
+		if (!_moves.empty() && _moves.back().key != record.key)
+			flush_position();
+		_moves.push_back(record);
+	}
+
+	uint64 entries() const { return _entries; }
+	uint64 positions() const { return _positions; }
+
+private:
+	static void write_be(uint8 *s, uint64 value, int bytes) {
+		for (int i = bytes - 1; i >= 0; --i, value >>= 8)
+			s[i] = value & 0xFF;
+	}
+
+	/// writes the moves of one position, best first
+	void flush_position() {
+		std::vector<PolyglotEntry> entries;
+		uint64 best = 0;
+		for (auto &m : _moves) {
+			uint64 games = (uint64)m.wins + m.draws + m.losses;
+			uint64 score = 2 * (uint64)m.wins + m.draws;
+			if (games < (uint64)_options.min_games || score == 0)
+				continue;
+			entries.push_back(PolyglotEntry{m.key, m.move, 0, 0});
+			_scores.push_back(score);
+			best = std::max(best, score);
+		}
+		for (size_t i = 0; i < entries.size(); ++i) {
+			uint64 weight = best > 0xFFFF ? _scores[i] * 0xFFFF / best : _scores[i];
+			entries[i].weight = std::max<uint64>(weight, 1);
+		}
+		std::stable_sort(entries.begin(), entries.end(), [](const PolyglotEntry &a, const PolyglotEntry &b) {
+			return a.weight > b.weight;
+		});
+
+		for (auto &e : entries) {
+			uint8 raw[PolyglotBook::ENTRY_SIZE];
+			write_be(raw, e.key, 8);
+			write_be(raw + 8, e.move, 2);
+			write_be(raw + 10, e.weight, 2);
+			write_be(raw + 12, e.learn, 4);
+			fwrite(raw, sizeof raw, 1, _file);
+		}
+		_entries += entries.size();
+		_positions += entries.empty() ? 0 : 1;
+		_moves.clear();
+		_scores.clear();
+	}
+
+	const Options &_options;
+	FILE *_file = nullptr;
+	std::vector<BookRecord> _moves;
+	std::vector<uint64> _scores;
+	uint64 _entries = 0;
+	uint64 _positions = 0;
+};
+
+/** Merges at most MAX_FAN_IN sorted runs and passes every move with its
+ * results combined to add, in order.  The read buffers share memory bytes.
+ */
+static bool merge_runs(const std::vector<std::string> &paths, size_t memory,
+		const std::function<bool(const BookRecord &)> &add) {
+	if (paths.empty())
+		return true;
+	size_t buffer_records = std::max(MIN_READ_BUFFER, memory / paths.size() / sizeof (BookRecord));
+	std::vector<RunReader> runs(paths.size());
+
+	// smallest record first
+	typedef std::pair<BookRecord, size_t> Head;
+	auto greater = [](const Head &a, const Head &b) { return b.first < a.first; };
+	std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+	for (size_t i = 0; i < runs.size(); ++i) {
+		if (!runs[i].open(paths[i], buffer_records)) {
+			fprintf(stderr, "can't read %s\n", paths[i].c_str());
+			return false;
+		}
+		heap.push(Head(runs[i].current(), i));
+	}
+
+	bool pending = false;
+	BookRecord record;
+	while (!heap.empty()) {
+		Head head = heap.top();
+		heap.pop();
+		if (runs[head.second].advance())
+			heap.push(Head(runs[head.second].current(), head.second));
+		else if (runs[head.second].failed())
+			break;
+
+		if (pending && same_move(record, head.first)) {
+			combine(record, head.first);
+		} else {
+			if (pending && !add(record))
+				return false;
+			record = head.first;
+			pending = true;
+		}
+	}
+	for (size_t i = 0; i < runs.size(); ++i) {
+		if (runs[i].failed()) {
+			fprintf(stderr, "can't read %s\n", paths[i].c_str());
+			return false;
+		}
+	}
+	return !pending || add(record);
+}
+
+/// merges the runs into the book, with intermediate passes while there are more than MAX_FAN_IN
+static bool merge(std::vector<std::string> paths, const Options &options, BookWriter &book) {
+	std::vector<std::string> created;
+	bool ok = true;
+	for (int pass = 0; ok && paths.size() > MAX_FAN_IN; ++pass) {
+		std::vector<std::string> merged;
+		for (size_t first = 0; ok && first < paths.size(); first += MAX_FAN_IN) {
+			std::vector<std::string> group(paths.begin() + first,
+					paths.begin() + std::min(first + MAX_FAN_IN, paths.size()));
+			std::string path = std::string(options.output) + ".pass" + std::to_string(pass)
+					+ "." + std::to_string(merged.size());
+			created.push_back(path);
+			merged.push_back(path);
+
+			FILE *file = fopen(path.c_str(), "wb");
+			ok = file && merge_runs(group, options.memory, [file](const BookRecord &record) {
+				return fwrite(&record, sizeof record, 1, file) == 1;
+			});
+			bool written = file && !ferror(file);
+			if (file && fclose(file) != 0)
+				written = false;
+			if (!written) {
+				fprintf(stderr, "can't write %s\n", path.c_str());
+				ok = false;
+			}
+			// a pass needs no more disk space than its input
+			for (auto &input : group)
+				remove(input.c_str());
+		}
+		paths.swap(merged);
+	}
+	ok = ok && merge_runs(paths, options.memory, [&book](const BookRecord &record) {
+		book.add(record);
+		return true;
+	});
+	for (auto &path : created)
+		remove(path.c_str());
+	return ok;
+}
+
+// MAIN
+
+int main(int argc, char **argv) {
+	Options options;
+	options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			options.output = argv[++i];
+		else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+			options.plies = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			options.min_games = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+			options.memory = (size_t)std::max(1, atoi(argv[++i])) << 20;
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			options.threads = std::max(1, atoi(argv[++i]));
+		else if (!options.input)
+			options.input = argv[i];
+		else
+			options.input = nullptr, i = argc;
+	}
+	if (!options.input) {
+		fprintf(stderr, "usage: %s <games.pgn> [-o <book.bin>] [-p <plies>] [-n <min games>]\n"
+				"                 [-m <memory MB>] [-t <threads>]\n", argv[0]);
+		return 1;
+	}
+	if (!PolyglotBook::keys_valid())
+		return 1;
+
+	auto start = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.open(options.input)) {
+		fprintf(stderr, "can't open %s\n", options.input);
+		return 1;
+	}
+
+	std::vector<const char *> cuts;
+	PgnReader::split(file.begin(), file.end(), std::max<size_t>(options.threads, file.size() / PART_SIZE + 1), cuts);
+
+	// every thread fills its own buffer and writes its own runs
+	size_t capacity = std::max<size_t>(1024, options.memory / options.threads / sizeof (BookRecord));
+	RunWriter runs(options);
+	Counters counters;
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < options.threads; ++t) {
+		workers.emplace_back([&]() {
+			std::vector<BookRecord> buffer;
+			buffer.reserve(capacity);
+			for (size_t i = next++; i + 1 < cuts.size(); i = next++)
+				read_part(cuts[i], cuts[i + 1], options, buffer, capacity, runs, counters);
+			runs.write(buffer);
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+	file.close();
+
+	if (runs.failed()) {
+		fprintf(stderr, "can't write run files next to %s\n", options.output);
+	} else {
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%llu games, %llu used, %llu positions in %.1f s, %llu runs\n",
+				(unsigned long long)counters.games, (unsigned long long)counters.used,
+				(unsigned long long)counters.tuples, seconds, (unsigned long long)runs.paths().size());
+	}
+
+	BookWriter book(options);
+	bool ok = !runs.failed() && book.open() && merge(runs.paths(), options, book);
+	ok = book.close() && ok;
+	for (auto &path : runs.paths())
+		remove(path.c_str());
+	if (!ok) {
+		// an incomplete book must not be mistaken for a complete one
+		remove(options.output);
+		fprintf(stderr, "can't write %s\n", options.output);
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("written %s: %llu entries for %llu positions, %.1f s\n", options.output,
+			(unsigned long long)book.entries(), (unsigned long long)book.positions(), seconds);
+	return 0;
+}
@@ -1,47 +1,41 @@
 #include "compare.hpp"
 #include "Board.hpp"
 
+#include <cstring>
+
+// Both comparators order by hash first, which is cached on the board and
+// almost always decides the comparison. Ties fall back to a memcmp over the
+// packed piece arrays, so the order stays strict and weak on collisions.
+
 bool BoardCompare::operator () (const Board &lhs, const Board &rhs) const {
-	if (lhs.width() < rhs.width())
-		return true;
-	if (lhs.width() > rhs.width())
-		return false;
-	if (lhs.height() < rhs.height())
-		return true;
-	if (lhs.height() > rhs.height())
+	if (&lhs == &rhs)
 		return false;
-	auto w = lhs.width();
-	auto h = lhs.height();
-	for (Coord y = 0; y < h; ++y)
-		for (Coord x = 0; x < w; ++x) {
-			auto tile = Tile(x, y);
-			auto a = lhs[tile];
-			auto b = rhs[tile];
-			if (a.player < b.player)
-				return true;
-			if (a.player > b.player)
-				return false;
-			if (a.type < b.type)
-				return true;
-			if (a.type > b.type)
-				return false;
-		}
 
-	return false;
+	uint64 lhs_hash = lhs.hash_value();
+	uint64 rhs_hash = rhs.hash_value();
+	if (lhs_hash != rhs_hash)
+		return lhs_hash < rhs_hash;
+
+	if (lhs.width() != rhs.width())
+		return lhs.width() < rhs.width();
+	if (lhs.height() != rhs.height())
+		return lhs.height() < rhs.height();
+
+	auto size = lhs.width() * lhs.height() * sizeof (Piece);
+	return memcmp(lhs.pieces(), rhs.pieces(), size) < 0;
 }
 
 bool PositionCompare::operator () (const Position &lhs, const Position &rhs) const {
-
-	if (lhs.active_player() < rhs.active_player())
-		return true;
-	if (lhs.active_player() > rhs.active_player())
+	if (&lhs == &rhs)
 		return false;
 
-	BoardCompare board_comp;
-	if (board_comp(lhs, rhs))
-		return true;
-	if (board_comp(rhs, lhs))
-		return false;
+	uint64 lhs_hash = lhs.hash_value();
+	uint64 rhs_hash = rhs.hash_value();
+	if (lhs_hash != rhs_hash)
+		return lhs_hash < rhs_hash;
+
+	if (lhs.active_player() != rhs.active_player())
+		return lhs.active_player() < rhs.active_player();
 
 	for (int player_i = 0; player_i < 2; ++player_i)
 		for (int castling_i = 0; castling_i < 2; ++castling_i) {
@@ -49,16 +43,18 @@ bool PositionCompare::operator () (const Position &lhs, const Position &rhs) con
 			auto player = static_cast<Player>(player_i);
 			bool lhs_castle = lhs.can_castle(player, castling);
 			bool rhs_castle = rhs.can_castle(player, castling);
-			if (!lhs_castle && rhs_castle)
-				return true;
-			if (lhs_castle && !rhs_castle)
-				return false;
+			if (lhs_castle != rhs_castle)
+				return rhs_castle;
 		}
 
-	if (lhs.en_passant_file() < rhs.en_passant_file())
-		return true;
-	if (lhs.en_passant_file() > rhs.en_passant_file())
-		return false;
+	if (lhs.en_passant_file() != rhs.en_passant_file())
+		return lhs.en_passant_file() < rhs.en_passant_file();
+
+	if (lhs.width() != rhs.width())
+		return lhs.width() < rhs.width();
+	if (lhs.height() != rhs.height())
+		return lhs.height() < rhs.height();
 
-	return false;
+	auto size = lhs.width() * lhs.height() * sizeof (Piece);
+	return memcmp(lhs.pieces(), rhs.pieces(), size) < 0;
 }
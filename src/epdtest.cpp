@@ -0,0 +1,291 @@
+/* Runs an EPD test suite against SpeedyBot.
+ *
+ * Every record is a FEN without move counters followed by operations, of
+ * which "bm" (best moves), "am" (avoid moves) and "id" are used:
+ *
+ *     r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - bm Bb5; id "ruy";
+ *
+ * A pool of threads, each with its own bot, searches the positions with
+ * the given limits.  Every search starts with empty caches, so the results
+ * don't depend on the number of threads or the order of the positions.  A
+ * position is solved if the final move is one of the best moves and none
+ * of the moves to avoid.  Time and nodes to solution are taken from the
+ * first iteration after which the bot never changed to a wrong move again.
+ *
+ * Syzygy tables given with -z are only probed with -p.  They then rate
+ * positions below the root and pick the moves of the positions they cover.
+ *
+ * usage: epdtest <suite.epd> [-d <plies>] [-n <nodes>] [-s <milliseconds>]
+ *                [-t <threads>] [-e <tablebase directory>] [-z <syzygy paths> [-p]] [-q]
+ */
+
+#include "SpeedyBot.hpp"
+#include "fen.hpp"
+#include "san.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int DEFAULT_MOVETIME = 1000;
+static const int MAX_PLIES = 64;
+
+struct TestCase {
+	int line;
+	std::string id;
+	Situation situation;
+	std::vector<Action> best;
+	std::vector<Action> avoid;
+
+	// results
+	Action action;
+	int depth;
+	bool solved;
+	double seconds;
+	double solution_seconds;
+	uint64 nodes;
+	uint64 solution_nodes;
+};
+
+static bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/** Reads the operations of an EPD record.  Returns nullptr on success,
+ * otherwise a description of the problem.
+ */
+static const char *parse_operations(const char *s, const char *end, TestCase &test) {
+	while (true) {
+		while (s < end && is_space(*s))
+			++s;
+		if (s == end)
+			return nullptr;
+
+		const char *opcode = s;
+		while (s < end && !is_space(*s) && *s != ';')
+			++s;
+		std::string name(opcode, s);
+
+		// operands up to the semicolon, strings may contain anything
+		std::vector<std::string> operands;
+		while (true) {
+			while (s < end && is_space(*s))
+				++s;
+			if (s == end)
+				return "missing ';'";
+			if (*s == ';') {
+				++s;
+				break;
+			}
+			const char *operand = s;
+			if (*s == '"') {
+				const char *close = (const char *)memchr(s + 1, '"', end - s - 1);
+				if (!close)
+					return "unterminated string";
+				operands.push_back(std::string(s + 1, close));
+				s = close + 1;
+				continue;
+			}
+			while (s < end && !is_space(*s) && *s != ';')
+				++s;
+			operands.push_back(std::string(operand, s));
+		}
+
+		if (name == "id" && !operands.empty()) {
+			test.id = operands[0];
+		} else if (name == "bm" || name == "am") {
+			for (auto &move : operands) {
+				Action action;
+				if (san_parse(test.situation, move.data(), move.data() + move.size(), action))
+					return "invalid move";
+				(name == "bm" ? test.best : test.avoid).push_back(action);
+			}
+		}
+	}
+}
+
+static bool load(const char *path, std::vector<TestCase> &tests) {
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::string line;
+	int number = 0;
+	while (std::getline(file, line)) {
+		++number;
+		const char *s = line.data();
+		const char *end = s + line.size();
+		while (s < end && is_space(*s))
+			++s;
+		if (s == end || *s == '#')
+			continue;
+
+		TestCase test = TestCase();
+		test.line = number;
+		const char *rest = fen_parse(s, end, test.situation);
+		const char *message = rest ? parse_operations(rest, end, test) : "invalid FEN";
+		if (!message && test.best.empty() && test.avoid.empty())
+			message = "no bm or am operation";
+		if (message) {
+			fprintf(stderr, "%s:%d: %s, skipped\n", path, number, message);
+			continue;
+		}
+		if (test.id.empty())
+			test.id = "line " + std::to_string(number);
+		tests.push_back(test);
+	}
+	return true;
+}
+
+static bool is_correct(const TestCase &test, const Action &action) {
+	if (std::find(test.avoid.begin(), test.avoid.end(), action) != test.avoid.end())
+		return false;
+	return test.best.empty() || std::find(test.best.begin(), test.best.end(), action) != test.best.end();
+}
+
+static void run(SpeedyBot &bot, TestCase &test) {
+	std::vector<SearchInfo> iterations;
+	bot.set_info_callback([&](const SearchInfo &info) {
+		iterations.push_back(info);
+	});
+	bot.reset(test.situation);
+	bot.clear_caches();
+
+	auto start = std::chrono::steady_clock::now();
+	test.action = bot.next_action();
+	test.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	test.nodes = bot.stats().total_nodes();
+	test.depth = iterations.empty() ? 0 : iterations.back().depth;
+	test.solved = is_correct(test, test.action);
+
+	// the first iteration of the final run of correct ones
+	size_t first = iterations.size();
+	while (first > 0 && is_correct(test, iterations[first - 1].action))
+		--first;
+	if (test.solved && first < iterations.size()) {
+		test.solution_seconds = iterations[first].seconds;
+		test.solution_nodes = iterations[first].nodes;
+	} else {
+		test.solution_seconds = test.seconds;
+		test.solution_nodes = test.nodes;
+	}
+}
+
+int main(int argc, char **argv) {
+	const char *input = nullptr;
+	SearchLimits limits;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	bool quiet = false;
+	const char *tablebase_directory = nullptr;
+	const char *syzygy_paths = nullptr;
+	bool syzygy_probing = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			limits.depth = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			limits.nodes = std::max(1LL, atoll(argv[++i]));
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			limits.movetime = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+			tablebase_directory = argv[++i];
+		else if (!strcmp(argv[i], "-z") && i + 1 < argc)
+			syzygy_paths = argv[++i];
+		else if (!strcmp(argv[i], "-p"))
+			syzygy_probing = true;
+		else if (!strcmp(argv[i], "-q"))
+			quiet = true;
+		else if (!input)
+			input = argv[i];
+		else
+			input = nullptr, i = argc;
+	}
+	if (!input) {
+		fprintf(stderr, "usage: %s <suite.epd> [-d <plies>] [-n <nodes>] [-s <milliseconds>]\n"
+				"               [-t <threads>] [-e <tablebase directory>] [-z <syzygy paths> [-p]] [-q]\n", argv[0]);
+		return 1;
+	}
+	if (limits.depth == 0) {
+		// without a depth the bounds end the search
+		if (limits.nodes == 0 && limits.movetime == 0)
+			limits.movetime = DEFAULT_MOVETIME;
+		limits.depth = MAX_PLIES;
+	}
+
+	std::shared_ptr<Tablebase> tablebase;
+	if (tablebase_directory) {
+		tablebase = std::make_shared<Tablebase>();
+		if (tablebase->open(tablebase_directory) == 0)
+			fprintf(stderr, "no tablebases in %s\n", tablebase_directory);
+	}
+	std::shared_ptr<SyzygyTablebase> syzygy;
+	if (syzygy_paths) {
+		syzygy = std::make_shared<SyzygyTablebase>();
+		if (syzygy->open(syzygy_paths) == 0)
+			fprintf(stderr, "no Syzygy tables in %s\n", syzygy_paths);
+	}
+
+	std::vector<TestCase> tests;
+	if (!load(input, tests)) {
+		fprintf(stderr, "can't open %s\n", input);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&]() {
+			SpeedyBot bot;
+			bot.set_limits(limits);
+			bot.set_verbose(false);
+			bot.set_tablebase(tablebase);
+			bot.set_syzygy(syzygy);
+			bot.set_syzygy_probing(syzygy_probing);
+			for (size_t i = next++; i < tests.size(); i = next++)
+				run(bot, tests[i]);
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int solved = 0;
+	double solution_seconds = 0;
+	uint64 solution_nodes = 0, nodes = 0;
+	for (auto &test : tests) {
+		nodes += test.nodes;
+		if (test.solved) {
+			++solved;
+			solution_seconds += test.solution_seconds;
+			solution_nodes += test.solution_nodes;
+		}
+		if (quiet)
+			continue;
+		char san[SAN_MAX_LENGTH];
+		san_write(test.situation, test.action, san);
+		printf("%-20s %-6s %-8s depth %2d  %8.3f s  %10llu nodes\n", test.id.c_str(),
+				test.solved ? "solved" : "FAILED", san, test.depth,
+				test.solution_seconds, (unsigned long long)test.solution_nodes);
+	}
+
+	int total = (int)tests.size();
+	printf("solved %d of %d (%.1f%%)\n", solved, total, total ? 100.0 * solved / total : 0.0);
+	if (solved > 0) {
+		printf("mean time to solution %.3f s, mean nodes to solution %.0f\n",
+				solution_seconds / solved, (double)solution_nodes / solved);
+	}
+	printf("%llu nodes, %.2f s, %.0f nodes/s, %d threads\n", (unsigned long long)nodes,
+			seconds, nodes / std::max(seconds, 1e-6), threads);
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef EVAL_TABLES_HPP
+#define EVAL_TABLES_HPP
+
+/* Material values and placement ratings used by the Evaluator.
+ *
+ * PIECE_VALUES is indexed by Type, PIECE_POS_RATINGS by [Type][x][y] with y
+ * counted from the owner's home row.  This file can be regenerated from a
+ * set of labelled positions with the tuner (tune.cpp).
+ */
+
+static const float PIECE_VALUES[6] = { 0, 9, 5, 3, 3, 1 };
+static const float PIECE_POS_RATINGS[6][8][8] = {
+		{
+				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{1.0, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{0.3, 0.5, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{0.7, 0.5, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{0.3, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{1.0, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+				{0.8, 0.8, 0.3, 0.1, 0.0, 0.0, 0.0, 0.0},
+		}, {
+				{0.0, 0.1, 0.2, 0.3, 0.4, 0.4, 0.3, 0.2},
+				{0.1, 0.2, 0.3, 0.4, 0.5, 0.4, 0.3, 0.2},
+				{0.2, 0.3, 0.4, 0.6, 0.8, 0.7, 0.3, 0.2},
+				{0.3, 0.4, 0.5, 0.9, 1.0, 0.8, 0.5, 0.2},
+				{0.3, 0.4, 0.5, 0.9, 1.0, 0.8, 0.5, 0.2},
+				{0.2, 0.3, 0.4, 0.6, 0.8, 0.7, 0.3, 0.2},
+				{0.1, 0.2, 0.3, 0.4, 0.5, 0.4, 0.3, 0.2},
+				{0.0, 0.1, 0.2, 0.3, 0.4, 0.4, 0.3, 0.2},
+		}, {
+				{0.4, 0.2, 0.3, 0.4, 0.4, 0.3, 0.3, 0.3},
+				{0.2, 0.2, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
+				{0.6, 0.3, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
+				{1.0, 0.9, 0.5, 0.5, 0.4, 0.3, 0.3, 0.3},
+				{1.0, 0.9, 0.5, 0.5, 0.4, 0.3, 0.3, 0.3},
+				{0.6, 0.3, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
+				{0.2, 0.2, 0.2, 0.2, 0.1, 0.2, 0.3, 0.3},
+				{0.4, 0.2, 0.3, 0.4, 0.4, 0.3, 0.3, 0.3},
+		}, {
+				{0.0, 0.1, 0.3, 0.4, 0.3, 0.2, 0.1, 0.0},
+				{0.0, 0.2, 0.3, 0.5, 0.4, 0.3, 0.2, 0.0},
+				{0.1, 0.2, 0.4, 0.8, 0.6, 0.4, 0.2, 0.1},
+				{0.1, 0.3, 0.7, 1.0, 0.8, 0.5, 0.3, 0.1},
+				{0.1, 0.3, 0.7, 1.0, 0.8, 0.5, 0.3, 0.1},
+				{0.1, 0.2, 0.4, 0.8, 0.6, 0.4, 0.2, 0.1},
+				{0.0, 0.2, 0.3, 0.5, 0.4, 0.3, 0.2, 0.0},
+				{0.0, 0.1, 0.3, 0.4, 0.3, 0.2, 0.1, 0.0},
+		}, {
+				{0.0, 0.0, 0.1, 0.1, 0.1, 0.1, 0.0, 0.0},
+				{0.0, 0.1, 0.2, 0.3, 0.3, 0.2, 0.1, 0.0},
+				{0.1, 0.2, 0.4, 0.5, 0.5, 0.4, 0.2, 0.1},
+				{0.1, 0.3, 0.7, 1.0, 1.0, 0.7, 0.3, 0.1},
+				{0.1, 0.3, 0.7, 1.0, 1.0, 0.7, 0.3, 0.1},
+				{0.1, 0.2, 0.4, 0.5, 0.5, 0.4, 0.2, 0.1},
+				{0.0, 0.1, 0.2, 0.3, 0.3, 0.2, 0.1, 0.0},
+				{0.0, 0.0, 0.1, 0.1, 0.1, 0.1, 0.0, 0.0},
+		}, {
+				{0.0, 0.2, 0.2, 0.3, 0.3, 0.7, 3.0, 0.0},
+				{0.0, 0.2, 0.2, 0.3, 0.4, 0.8, 4.0, 0.0},
+				{0.0, 0.2, 0.2, 0.3, 0.6, 1.0, 4.0, 0.0},
+				{0.0, 0.0, 0.3, 0.6, 0.7, 1.0, 4.0, 0.0},
+				{0.0, 0.0, 0.3, 0.6, 0.7, 1.0, 4.0, 0.0},
+				{0.0, 0.2, 0.2, 0.3, 0.6, 1.0, 4.0, 0.0},
+				{0.0, 0.2, 0.2, 0.3, 0.4, 0.8, 4.0, 0.0},
+				{0.0, 0.2, 0.2, 0.3, 0.3, 0.7, 3.0, 0.0},
+		}
+};
+
+#endif // EVAL_TABLES_HPP
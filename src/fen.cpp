@@ -0,0 +1,239 @@
+#include "fen.hpp"
+
+#include <cstring>
+
+// upper case for white, lower case for black, indexed by Type
+static const char PIECE_CHARS[] = "KQRBNP";
+
+static const int MAX_COUNTER = 1000000;
+
+static bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static const char *skip_spaces(const char *s, const char *end) {
+	while (s < end && is_space(*s))
+		++s;
+	return s;
+}
+
+/// reads a non-negative decimal number, returns nullptr if there is none
+static const char *parse_number(const char *s, const char *end, int &value) {
+	if (s == end || !is_digit(*s))
+		return nullptr;
+	value = 0;
+	for (; s < end && is_digit(*s); ++s) {
+		value = value * 10 + (*s - '0');
+		if (value > MAX_COUNTER)
+			return nullptr;
+	}
+	return s;
+}
+
+static const char *parse_placement(const char *s, const char *end, Board &board) {
+	Coord x = 0, y = 7;
+	for (; s < end && !is_space(*s); ++s) {
+		char c = *s;
+		if (c == '/') {
+			if (x != 8 || y == 0)
+				return nullptr;
+			x = 0;
+			--y;
+		} else if (c >= '1' && c <= '8') {
+			for (int n = c - '0'; n > 0; --n) {
+				if (x >= 8)
+					return nullptr;
+				board[Tile(x++, y)] = Piece::NONE;
+			}
+		} else {
+			const char *type = (const char *)memchr(PIECE_CHARS, c & ~0x20, 6);
+			if (!type || !(c & 0x40) || x >= 8)
+				return nullptr;
+			Player player = c & 0x20 ? PLAYER_BLACK : PLAYER_WHITE;
+			board[Tile(x++, y)] = Piece{player, static_cast<Type>(type - PIECE_CHARS)};
+		}
+	}
+	if (x != 8 || y != 0)
+		return nullptr;
+	return s;
+}
+
+static const char *parse_castling(const char *s, const char *end, Position &position) {
+	for (int p = 0; p < 2; ++p)
+	for (int c = 0; c < 2; ++c)
+		position.can_castle(static_cast<Player>(p), static_cast<CastlingType>(c)) = false;
+
+	if (s < end && *s == '-')
+		return s + 1;
+
+	const char *begin = s;
+	for (; s < end && !is_space(*s); ++s) {
+		switch (*s) {
+		case 'K': position.can_castle(PLAYER_WHITE, KINGSIDE) = true; break;
+		case 'Q': position.can_castle(PLAYER_WHITE, QUEENSIDE) = true; break;
+		case 'k': position.can_castle(PLAYER_BLACK, KINGSIDE) = true; break;
+		case 'q': position.can_castle(PLAYER_BLACK, QUEENSIDE) = true; break;
+		default: return nullptr;
+		}
+	}
+	return s > begin ? s : nullptr;
+}
+
+static const char *parse_en_passant(const char *s, const char *end, Position &position) {
+	position.en_passant_file() = -1;
+	if (s < end && *s == '-')
+		return s + 1;
+	if (end - s < 2 || s[0] < 'a' || s[0] > 'h')
+		return nullptr;
+
+	// the square behind the pawn that moved two tiles
+	Player player = position.active_player();
+	char rank = player == PLAYER_WHITE ? '6' : '3';
+	if (s[1] != rank)
+		return nullptr;
+
+	// only keep the file if the capture is actually possible
+	const Board &board = position;
+	Coord file = s[0] - 'a';
+	Coord row = player == PLAYER_WHITE ? 4 : 3;
+	Player opponent = static_cast<Player>(1 - player);
+	Piece own_pawn = Piece{player, TYPE_PAWN};
+	bool left = file > 0 && board[Tile(file - 1, row)] == own_pawn;
+	bool right = file < 7 && board[Tile(file + 1, row)] == own_pawn;
+	if (board[Tile(file, row)] == Piece{opponent, TYPE_PAWN} && (left || right))
+		position.en_passant_file() = file;
+	return s + 2;
+}
+
+const char *fen_parse(const char *begin, const char *end, Situation &situation, int *full_move_number) {
+	if (situation.width() != 8 || situation.height() != 8)
+		static_cast<Board &>(situation) = Board();
+
+	const char *s = skip_spaces(begin, end);
+	s = parse_placement(s, end, situation);
+	if (!s)
+		return nullptr;
+
+	s = skip_spaces(s, end);
+	if (s == end)
+		return nullptr;
+	if (*s == 'w')
+		situation.active_player() = PLAYER_WHITE;
+	else if (*s == 'b')
+		situation.active_player() = PLAYER_BLACK;
+	else
+		return nullptr;
+	++s;
+	if (s == end || !is_space(*s))
+		return nullptr;
+
+	s = parse_castling(skip_spaces(s, end), end, situation);
+	if (!s || s == end || !is_space(*s))
+		return nullptr;
+
+	s = parse_en_passant(skip_spaces(s, end), end, situation);
+	if (!s || (s < end && !is_space(*s)))
+		return nullptr;
+
+	// the move counters are optional
+	int half_moves = 0;
+	int full_moves = 1;
+	const char *next = parse_number(skip_spaces(s, end), end, half_moves);
+	if (next && (next == end || is_space(*next))) {
+		s = next;
+		next = parse_number(skip_spaces(s, end), end, full_moves);
+		if (next && (next == end || is_space(*next)))
+			s = next;
+	}
+
+	situation.restore(SituationState{half_moves, false, false, PLAYER_NONE});
+	if (full_move_number)
+		*full_move_number = full_moves;
+	return s;
+}
+
+bool fen_parse(const char *fen, Situation &situation, int *full_move_number) {
+	const char *end = fen + strlen(fen);
+	const char *s = fen_parse(fen, end, situation, full_move_number);
+	return s && skip_spaces(s, end) == end;
+}
+
+/// writes a non-negative number, returns the position behind it
+static char *write_number(char *s, int value) {
+	char digits[12];
+	int n = 0;
+	do {
+		digits[n++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	while (n > 0)
+		*s++ = digits[--n];
+	return s;
+}
+
+int fen_write(const Situation &situation, char *buffer, int full_move_number) {
+	if (situation.width() != 8 || situation.height() != 8) {
+		buffer[0] = '\0';
+		return 0;
+	}
+
+	char *s = buffer;
+	for (Coord y = 7; y >= 0; --y) {
+		int empty = 0;
+		for (Coord x = 0; x < 8; ++x) {
+			Piece piece = situation[Tile(x, y)];
+			if (piece.type == TYPE_NONE) {
+				++empty;
+				continue;
+			}
+			if (empty > 0)
+				*s++ = '0' + empty;
+			empty = 0;
+			char c = PIECE_CHARS[piece.type];
+			*s++ = piece.player == PLAYER_BLACK ? c | 0x20 : c;
+		}
+		if (empty > 0)
+			*s++ = '0' + empty;
+		if (y > 0)
+			*s++ = '/';
+	}
+
+	*s++ = ' ';
+	*s++ = situation.active_player() == PLAYER_BLACK ? 'b' : 'w';
+
+	*s++ = ' ';
+	char *castling = s;
+	if (situation.can_castle(PLAYER_WHITE, KINGSIDE)) *s++ = 'K';
+	if (situation.can_castle(PLAYER_WHITE, QUEENSIDE)) *s++ = 'Q';
+	if (situation.can_castle(PLAYER_BLACK, KINGSIDE)) *s++ = 'k';
+	if (situation.can_castle(PLAYER_BLACK, QUEENSIDE)) *s++ = 'q';
+	if (s == castling)
+		*s++ = '-';
+
+	*s++ = ' ';
+	Coord file = situation.en_passant_file();
+	if (file >= 0) {
+		*s++ = 'a' + file;
+		*s++ = situation.active_player() == PLAYER_WHITE ? '6' : '3';
+	} else {
+		*s++ = '-';
+	}
+
+	*s++ = ' ';
+	s = write_number(s, situation.half_move_counter());
+	*s++ = ' ';
+	s = write_number(s, full_move_number);
+	*s = '\0';
+
+	return (int)(s - buffer);
+}
+
+std::string fen_string(const Situation &situation, int full_move_number) {
+	char buffer[FEN_MAX_LENGTH];
+	int length = fen_write(situation, buffer, full_move_number);
+	return std::string(buffer, length);
+}
@@ -0,0 +1,47 @@
+#ifndef FEN_HPP
+#define FEN_HPP
+
+#include "Situation.hpp"
+
+#include <string>
+
+/* Forsyth-Edwards Notation for 8x8 situations.
+ *
+ * Parsing works on a character range, so lines can be read straight out of
+ * a file buffer without copying or terminating them.  Neither direction
+ * allocates, except for resizing a situation whose board is not 8x8 and
+ * for fen_string.
+ */
+
+/// the starting position of a standard game
+static const char *const FEN_STANDARD = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+/// buffer size for fen_write, including the terminating zero
+static const int FEN_MAX_LENGTH = 128;
+
+/** Reads a FEN record from [begin, end) into situation.
+ *
+ * Piece placement, active player, castling and en passant are required.
+ * The half-move counter and full-move number may be omitted, as in EPD
+ * records; they default to 0 and 1.  The en passant square is only kept if
+ * the active player has a pawn next to the pawn that just moved, which is
+ * the condition Position::action uses.  Castling rights are taken as given.
+ *
+ * Returns a pointer behind the last field read, so callers can go on with
+ * EPD operations or other trailing data, or nullptr if the record is
+ * malformed.  In that case the situation is left in an unspecified state.
+ */
+const char *fen_parse(const char *begin, const char *end, Situation &, int *full_move_number = nullptr);
+
+/// parses a zero terminated FEN, anything but whitespace after it is an error
+bool fen_parse(const char *fen, Situation &, int *full_move_number = nullptr);
+
+/** Writes the FEN of an 8x8 situation into buffer, which must hold at least
+ * FEN_MAX_LENGTH characters.  Returns the length without the terminating
+ * zero, or 0 if the board is not 8x8.
+ */
+int fen_write(const Situation &, char *buffer, int full_move_number = 1);
+
+std::string fen_string(const Situation &, int full_move_number = 1);
+
+#endif // FEN_HPP
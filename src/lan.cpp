@@ -0,0 +1,60 @@
+#include "lan.hpp"
+
+#include "Rules.hpp"
+
+#include <cstring>
+
+// lower case promotion letters, indexed by Type
+static const char PIECE_CHARS[] = "kqrbnp";
+
+static bool parse_tile(const char *s, Tile &tile) {
+	if (s[0] < 'a' || s[0] > 'h' || s[1] < '1' || s[1] > '8')
+		return false;
+	tile = Tile(s[0] - 'a', s[1] - '1');
+	return true;
+}
+
+const char *lan_parse(const Position &position, const char *begin, const char *end, Action &action) {
+	if (position.width() != 8 || position.height() != 8)
+		return "unsupported board size";
+
+	size_t length = end - begin;
+	Tile src, dst;
+	if ((length != 4 && length != 5) || !parse_tile(begin, src) || !parse_tile(begin + 2, dst))
+		return "malformed move";
+
+	Type promotion = TYPE_NONE;
+	if (length == 5) {
+		const char *type = (const char *)memchr(PIECE_CHARS, begin[4], 6);
+		if (!type || *type == 'k' || *type == 'p')
+			return "malformed move";
+		promotion = static_cast<Type>(type - PIECE_CHARS);
+	}
+
+	Rules rules;
+	const Board &board = position;
+	if (board[src].type == TYPE_NONE || board[src].player != position.active_player())
+		return "illegal move";
+	action = rules.examineMove(position, src, dst, promotion == TYPE_NONE ? TYPE_QUEEN : promotion);
+	if (promotion != TYPE_NONE && action.promotion == TYPE_NONE)
+		return "illegal move";
+	return rules.isActionLegal(position, action) ? nullptr : "illegal move";
+}
+
+int lan_write(const Action &action, char *buffer) {
+	char *s = buffer;
+	*s++ = 'a' + action.src[0];
+	*s++ = '1' + action.src[1];
+	*s++ = 'a' + action.dst[0];
+	*s++ = '1' + action.dst[1];
+	if (action.promotion != TYPE_NONE)
+		*s++ = PIECE_CHARS[action.promotion];
+	*s = '\0';
+	return (int)(s - buffer);
+}
+
+std::string lan_string(const Action &action) {
+	char buffer[LAN_MAX_LENGTH];
+	lan_write(action, buffer);
+	return buffer;
+}
@@ -0,0 +1,31 @@
+#ifndef LAN_HPP
+#define LAN_HPP
+
+#include "Position.hpp"
+
+#include <string>
+
+/* Long algebraic notation for moves on 8x8 boards, as used by UCI, e.g.
+ * "e2e4", "e7e8q", or "e1g1" for castling.
+ */
+
+/// buffer size for lan_write, including the terminating zero
+static const int LAN_MAX_LENGTH = 6;
+
+/** Resolves a move in long algebraic notation against a position and checks
+ * it with Rules::isActionLegal.
+ *
+ * Returns nullptr on success, otherwise a short description of the problem
+ * ("malformed move", "illegal move", ...).
+ */
+const char *lan_parse(const Position &, const char *begin, const char *end, Action &);
+
+/** Writes an action into buffer, which must hold at least LAN_MAX_LENGTH
+ * characters.  Returns the length without the terminating zero.
+ */
+int lan_write(const Action &, char *buffer);
+
+/// lan_write into a string
+std::string lan_string(const Action &);
+
+#endif // LAN_HPP
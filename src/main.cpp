@@ -1,8 +1,14 @@
+#include <atomic>
 #include <cstdio>
 #include <memory>
+#include <mutex>
 
-#include <boost/thread.hpp>
-#include <boost/atomic.hpp>
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/resource.h>
+#endif
 
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_image.h>
@@ -12,68 +18,42 @@
 #include <allegro5/allegro_ttf.h>
 
 #include "View.hpp"
+#include "BotPool.hpp"
 #include "Game.hpp"
 #include "Action.hpp"
 #include "Piece.hpp"
 #include "Rules.hpp"
 #include "SpeedyBot.hpp"
-#include "RandomBot.hpp"
 
 using std::shared_ptr;
 using std::move;
 
-static const int TIMER_BPS = 1000;
-static const int64 US_PER_TICK = 1e6 / TIMER_BPS;
-
-class BotThread {
-public:
-	BotThread();
-
-	void run(Bot *bot);
-	bool isRunning();
-	bool isDone();
-	Action getResult();
-
-private:
-	boost::thread _thread;
-	Action _action;
-	Bot *_bot;
-	boost::atomic<bool> _done;
-	boost::atomic<bool> _running;
-};
-
-
-BotThread::BotThread() :
-	_done(false),
-	_running(false)
-{
-	// nothing
-}
-
-void BotThread::run(Bot *bot) {
-	_bot = bot;
-	_done = false;
-	_running = true;
-	_thread = boost::thread([&] {
-		_action = _bot->next_action();
-		_done = true;
-	});
-	_thread.detach();
-}
-
-bool BotThread::isRunning() {
-	return _running;
-}
-
-bool BotThread::isDone() {
-	return _done;
-}
-
-Action BotThread::getResult() {
-	_thread.join();
-	_done = false;
-	_running = false;
-	return _action;
+/// the most frames per second, a frame is only drawn if something changed
+static const int TIMER_BPS = 60;
+/// the readout of frame time and CPU usage is averaged over this many seconds
+static const double STATS_INTERVAL = 1.0;
+
+/// emitted by the bot pool when a search is done
+static const unsigned BOT_EVENT = ALLEGRO_GET_EVENT_TYPE('C', 'B', 'O', 'T');
+
+/// CPU time of all threads of the process so far, in seconds
+static double process_cpu_seconds() {
+#if defined(_WIN32)
+	// std::clock is wall time on Windows
+	FILETIME creation, exited, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user))
+		return 0;
+	auto seconds = [](const FILETIME &time) {
+		return ((uint64)time.dwHighDateTime << 32 | time.dwLowDateTime) * 1e-7;
+	};
+	return seconds(kernel) + seconds(user);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+			+ (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
 }
 
 class Main {
@@ -81,7 +61,8 @@ public:
 	Main() = default;
 	~Main();
 
-	int run();
+	/// book may be nullptr, see PolyglotBook
+	int run(const char *book_path);
 
 private:
 
@@ -89,15 +70,20 @@ private:
 	void createWindow();
 
 	void loop();
-	void updateFps();
-	void updateLogic();
-	void handleEvents();
+	void updateStats();
+	void handleEvent(const ALLEGRO_EVENT &ev);
 	void handleKeyEvent(int key);
 	void handleClickEvent(int x, int y);
 
 	void makeMove(Tile src, Tile dst);
 	void makeMove(Action action);
 
+	/// starts the search of the bot to move, if it is one and has not yet
+	void startBot();
+	/// drops the running search, its result is ignored
+	void cancelBot();
+	void handleBotEvent(const ALLEGRO_EVENT &ev);
+
 	void drawFrame();
 
 	ALLEGRO_DISPLAY *_display = nullptr;
@@ -106,38 +92,63 @@ private:
 	ALLEGRO_FONT *_font = nullptr;
 
 	Game *_game = nullptr;
-	Game::HistoryConstIter _iter;
+	/// index of the displayed position in the game history
+	int _index = 0;
+	/// the displayed position, which may lie in the past
+	Situation _shown;
 	View *_view = nullptr;
 
-	Bot *_white_bot = nullptr;
-	Bot *_black_bot = nullptr;
+	/// searches for the bots, in the background
+	std::unique_ptr<BotPool> _bot_pool;
+	/// search depth of each player's bot as for SpeedyBot(int), 0 for a human
+	int _bot_depth[2] = {3, 2};
 	bool _expect_player_move = false;
-	BotThread _bot_thread;
+	/// counts the searches, a result is only used if it is the latest one's
+	uint64 _bot_ticket = 0;
+	bool _bot_running = false;
+	/// the results of the searches, as they come from the workers
+	ALLEGRO_EVENT_SOURCE _bot_events;
+	bool _has_bot_events = false;
+	std::mutex _bot_mutex;
+	Action _bot_action;
+	uint64 _bot_action_ticket = 0;
+	/// depth of the last completed iteration of the running search
+	std::atomic<int> _bot_progress{0};
 
 	bool _shutdown = false;
-	int _fps_counter = 0;
+	/// something shown changed since the last frame
+	bool _dirty = true;
+	/// the bot's depth as last drawn
+	int _shown_progress = 0;
+
+	// frame statistics, see updateStats
+	double _stats_time = 0;
+	double _stats_cpu_seconds = 0;
+	int _frame_counter = 0;
+	double _frame_seconds = 0;
 	int _fps = 0;
-	int64 _us_counter = 0;
+	double _frame_ms = 0;
+	/// CPU time of the whole process, the bot included, per wall time
+	double _cpu_usage = 0;
 
 	Tile _selection = Tile(-1, -1);
 	Type _promo_selection = TYPE_QUEEN;
 
-	bool _panic = nullptr;
+	bool _panic = false;
 };
 
+// usage: chess [<book.bin>]
 int main(int argc, char **argv) {
 	Main main;
-	return main.run();
+	return main.run(argc > 1 ? argv[1] : nullptr);
 }
 
 Main::~Main() {
-	if (_white_bot) {
-		delete _white_bot;
-		_white_bot = nullptr;
-	}
-	if (_black_bot) {
-		delete _black_bot;
-		_black_bot = nullptr;
+	// the workers must be gone before the event source they emit to
+	_bot_pool.reset();
+	if (_has_bot_events) {
+		al_destroy_user_event_source(&_bot_events);
+		_has_bot_events = false;
 	}
 
 	if (_font) {
@@ -167,7 +178,7 @@ Main::~Main() {
 	}
 }
 
-int Main::run() {
+int Main::run(const char *book_path) {
 	startSystems();
 	createWindow();
 
@@ -178,11 +189,15 @@ int Main::run() {
 
 	const Situation &situation = _game->current_situation();
 
-	_white_bot = new SpeedyBot(3);
-	_white_bot->reset(situation);
-	_black_bot = new SpeedyBot(2);
-	_black_bot->reset(situation);
-	_expect_player_move = _white_bot == nullptr;
+	auto book = std::make_shared<PolyglotBook>();
+	if (book_path && !book->open(book_path))
+		fprintf(stderr, "can't open book %s\n", book_path);
+
+	_bot_pool.reset(new BotPool(1, [&](SpeedyBot &bot) {
+		if (book->is_open())
+			bot.set_book(book);
+	}));
+	_expect_player_move = _bot_depth[situation.active_player()] == 0;
 
 	al_start_timer(_timer);
 	loop();
@@ -274,7 +289,8 @@ void Main::createWindow() {
 		Situation situation(move(*shared_board), PLAYER_WHITE);
 		shared_board.reset();
 		_game = new Game(situation);
-		_iter = --_game->history().end();
+		_index = _game->current_index();
+		_shown = _game->current_situation();
 
 		const Situation &current = _game->current_situation();
 		auto w = current.width();
@@ -311,106 +327,160 @@ void Main::createWindow() {
 	al_register_event_source(_event_queue, al_get_keyboard_event_source());
 	al_register_event_source(_event_queue, al_get_mouse_event_source());
 	al_register_event_source(_event_queue, al_get_display_event_source(_display));
+	al_register_event_source(_event_queue, al_get_timer_event_source(_timer));
+
+	al_init_user_event_source(&_bot_events);
+	_has_bot_events = true;
+	al_register_event_source(_event_queue, &_bot_events);
 }
 
 void Main::loop() {
-	while (true) {
-		updateLogic();
+	_stats_time = al_get_time();
+	_stats_cpu_seconds = process_cpu_seconds();
+	while (!_shutdown) {
+		// sleep until something happens, then take everything that did
+		ALLEGRO_EVENT ev;
+		bool tick = false;
+		al_wait_for_event(_event_queue, &ev);
+		do {
+			tick |= ev.type == ALLEGRO_EVENT_TIMER;
+			handleEvent(ev);
+		} while (!_shutdown && al_get_next_event(_event_queue, &ev));
 		if (_shutdown)
 			break;
-		drawFrame();
+
+		startBot();
+		if (tick) {
+			updateStats();
+			if (_bot_running && _bot_progress != _shown_progress)
+				_dirty = true;
+			if (_dirty)
+				drawFrame();
+		}
 	}
 }
 
-void Main::handleEvents() {
-	ALLEGRO_EVENT ev;
-	while (!_shutdown && al_get_next_event(_event_queue, &ev)) {
-		// select event type
-		switch (ev.type) {
-		case ALLEGRO_EVENT_KEY_DOWN:
-			break;
-		case ALLEGRO_EVENT_KEY_UP:
-			break;
-		case ALLEGRO_EVENT_KEY_CHAR:
-			handleKeyEvent(ev.keyboard.keycode);
-			break;
-
-		case ALLEGRO_EVENT_MOUSE_AXES:
-			break;
-		case ALLEGRO_EVENT_MOUSE_BUTTON_DOWN:
-			break;
-		case ALLEGRO_EVENT_MOUSE_BUTTON_UP:
-			if (ev.mouse.button == 1)
-				handleClickEvent(ev.mouse.x, ev.mouse.y);
-			break;
-
-		case ALLEGRO_EVENT_MOUSE_WARPED:
-			break;
-		case ALLEGRO_EVENT_MOUSE_ENTER_DISPLAY:
-			break;
-		case ALLEGRO_EVENT_MOUSE_LEAVE_DISPLAY:
-			break;
-
-		case ALLEGRO_EVENT_TIMER:
-			break;
-
-		case ALLEGRO_EVENT_DISPLAY_EXPOSE:
-			break;
-		case ALLEGRO_EVENT_DISPLAY_RESIZE:
-			break;
-		case ALLEGRO_EVENT_DISPLAY_CLOSE:
-			_shutdown = true;
-			break;
-		case ALLEGRO_EVENT_DISPLAY_LOST:
-		case ALLEGRO_EVENT_DISPLAY_FOUND:
-		case ALLEGRO_EVENT_DISPLAY_SWITCH_OUT:
-		case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
-		case ALLEGRO_EVENT_DISPLAY_ORIENTATION:
-
-		default:
-			break; // ignore everything we don't know
-		} // select event type
-	} // process all events
+void Main::handleEvent(const ALLEGRO_EVENT &ev) {
+	// select event type
+	switch (ev.type) {
+	case ALLEGRO_EVENT_KEY_DOWN:
+		break;
+	case ALLEGRO_EVENT_KEY_UP:
+		break;
+	case ALLEGRO_EVENT_KEY_CHAR:
+		handleKeyEvent(ev.keyboard.keycode);
+		_dirty = true;
+		break;
+
+	case ALLEGRO_EVENT_MOUSE_AXES:
+		// the piece under the cursor is highlighted
+		_dirty = true;
+		break;
+	case ALLEGRO_EVENT_MOUSE_BUTTON_DOWN:
+		break;
+	case ALLEGRO_EVENT_MOUSE_BUTTON_UP:
+		if (ev.mouse.button == 1)
+			handleClickEvent(ev.mouse.x, ev.mouse.y);
+		_dirty = true;
+		break;
+
+	case ALLEGRO_EVENT_MOUSE_WARPED:
+		break;
+	case ALLEGRO_EVENT_MOUSE_ENTER_DISPLAY:
+		break;
+	case ALLEGRO_EVENT_MOUSE_LEAVE_DISPLAY:
+		_dirty = true;
+		break;
+
+	case ALLEGRO_EVENT_TIMER:
+		break;
+
+	case ALLEGRO_EVENT_DISPLAY_EXPOSE:
+	case ALLEGRO_EVENT_DISPLAY_RESIZE:
+	case ALLEGRO_EVENT_DISPLAY_FOUND:
+	case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
+		_dirty = true;
+		break;
+	case ALLEGRO_EVENT_DISPLAY_CLOSE:
+		_shutdown = true;
+		break;
+	case ALLEGRO_EVENT_DISPLAY_LOST:
+	case ALLEGRO_EVENT_DISPLAY_SWITCH_OUT:
+	case ALLEGRO_EVENT_DISPLAY_ORIENTATION:
+		break;
+
+	case BOT_EVENT:
+		handleBotEvent(ev);
+		_dirty = true;
+		break;
+
+	default:
+		break; // ignore everything we don't know
+	} // select event type
 }
 
-void Main::updateLogic() {
-	handleEvents();
-
+void Main::startBot() {
 	const Situation &situation = _game->current_situation();
+	if (_expect_player_move || _bot_running)
+		return;
+
+	Rules rules;
+	std::vector<Action> actions = rules.getAllLegalMoves(*_game);
+	if(actions.size() == 0)
+		return;
 
-	if (!_expect_player_move) {
+	SearchLimits limits;
+	limits.depth = _bot_depth[situation.active_player()] + 1;
+	uint64 ticket = ++_bot_ticket;
+	_bot_running = true;
+	_bot_progress = 0;
+	_bot_pool->submit(*_game, limits, [this, ticket](const Action &action) {
+		{
+			std::lock_guard<std::mutex> lock(_bot_mutex);
+			_bot_action = action;
+			_bot_action_ticket = ticket;
+		}
+		ALLEGRO_EVENT ev;
+		ev.user.type = BOT_EVENT;
+		ev.user.data1 = (intptr_t)ticket;
+		al_emit_user_event(&_bot_events, &ev, nullptr);
+	}, [this](const SearchInfo &info) {
+		_bot_progress = info.depth;
+	});
+}
 
-		Bot *bot = nullptr;
-		if (situation.active_player() == PLAYER_WHITE)
-			bot = _white_bot;
-		if (situation.active_player() == PLAYER_BLACK)
-			bot = _black_bot;
+void Main::cancelBot() {
+	++_bot_ticket;
+	_bot_running = false;
+	_bot_pool->cancel();
+}
 
-		Rules rules;
-		std::vector<Action> actions = rules.getAllLegalMoves(*_game);
-		if(actions.size() == 0)
+void Main::handleBotEvent(const ALLEGRO_EVENT &ev) {
+	Action action;
+	{
+		std::lock_guard<std::mutex> lock(_bot_mutex);
+		if ((uint64)ev.user.data1 != _bot_ticket || _bot_action_ticket != _bot_ticket)
 			return;
-
-		if (bot) {
-			if (_bot_thread.isRunning()) {
-				if (_bot_thread.isDone()) {
-					Action action = _bot_thread.getResult();
-					makeMove(action);
-				}
-			} else {
-				_bot_thread.run(bot);
-			}
-		}
+		action = _bot_action;
 	}
+	_bot_running = false;
+	makeMove(action);
 }
 
-void Main::updateFps() {
-	int64 new_us_counter = US_PER_TICK * al_get_timer_count(_timer);
-	if (new_us_counter / 1000000 > _us_counter / 1000000) {
-		_fps = _fps_counter;
-		_fps_counter = 0;
-	}
-	_us_counter = new_us_counter;
+void Main::updateStats() {
+	double now = al_get_time();
+	if (now - _stats_time < STATS_INTERVAL)
+		return;
+	double cpu_seconds = process_cpu_seconds();
+	double seconds = now - _stats_time;
+	_fps = (int)(_frame_counter / seconds + 0.5);
+	_frame_ms = _frame_counter ? 1000 * _frame_seconds / _frame_counter : 0;
+	_cpu_usage = (cpu_seconds - _stats_cpu_seconds) / seconds;
+	_frame_counter = 0;
+	_frame_seconds = 0;
+	_stats_time = now;
+	_stats_cpu_seconds = cpu_seconds;
+	_dirty = true;
 }
 
 void Main::handleKeyEvent(int key) {
@@ -420,11 +490,14 @@ void Main::handleKeyEvent(int key) {
 			break;
 
 		case ALLEGRO_KEY_R: {
+			cancelBot();
 			shared_ptr<Board> shared_board = Board::factoryStandard();
 			Situation situation(move(*shared_board), PLAYER_WHITE);
 			shared_board.reset();
 			_game->reset(situation);
-			_iter = --_game->history().end();
+			_index = _game->current_index();
+			_shown = _game->current_situation();
+			_expect_player_move = _bot_depth[PLAYER_WHITE] == 0;
 			break;
 		}
 
@@ -436,23 +509,23 @@ void Main::handleKeyEvent(int key) {
 		}
 
 		case ALLEGRO_KEY_B:
-			if (_iter->index > 0) {
+			if (_index > 0) {
 				_selection = Board::INVALID_TILE;
-				--_iter;
+				_game->situation_at(--_index, _shown);
 			}
 			break;
 
 		case ALLEGRO_KEY_N:
-			if (_iter->index < (int)_game->history().size() - 1) {
+			if (_index < _game->current_index()) {
 				_selection = Board::INVALID_TILE;
-				++_iter;
+				_game->situation_at(++_index, _shown);
 			}
 			break;
 	} // switch
 }
 
 void Main::handleClickEvent(int x, int y) {
-	const Situation &situation = _iter->situation;
+	const Situation &situation = _shown;
 
 	// which tile was clicked?
 	Tile tile = _view->getTileAt(x, y);
@@ -499,10 +572,10 @@ void Main::handleClickEvent(int x, int y) {
 }
 
 void Main::makeMove(Tile src, Tile dst) {
-	const Situation &situation = _iter->situation;
+	const Situation &situation = _shown;
 
 	// forget all moves made after the current one
-	_game->seek(_iter->index);
+	_game->seek(_index);
 
 	Rules rules;
 	Action action = rules.examineMove(situation, src, dst, _promo_selection);
@@ -526,20 +599,20 @@ void Main::makeMove(Action action) {
 
 	_selection = Board::INVALID_TILE;
 
-	if (_white_bot) _white_bot->update(action);
-	if (_black_bot) _black_bot->update(action);
-
-	_iter = --_game->history().end();
+	_index = _game->current_index();
+	_shown = _game->current_situation();
 
 	Player player = _game->current_situation().active_player();
-	_expect_player_move = player == PLAYER_WHITE ? _white_bot == 0 : _black_bot == 0;
+	_expect_player_move = _bot_depth[player] == 0;
 }
 
 void Main::drawFrame() {
-	const Situation &situation = _iter->situation;
+	const Situation &situation = _shown;
 	Player player = situation.active_player();
 
-	updateFps();
+	double start = al_get_time();
+	_dirty = false;
+	_shown_progress = _bot_progress;
 
 	al_set_target_backbuffer(al_get_current_display());
 
@@ -553,23 +626,32 @@ void Main::drawFrame() {
 		cursor = Board::INVALID_TILE;
 	}
 
-	_view->draw(0.0, 0.0, _iter->situation, _selection, cursor, promo_cursor, _promo_selection);
+	_view->draw(0.0, 0.0, _shown, _selection, cursor, promo_cursor, _promo_selection);
 
 	auto bg = al_color_name("black");
 	auto fg = al_color_name("white");
 	al_draw_filled_rectangle(560, 0, 640, 490, bg);
 	int lineno = 0;
-	int file = _iter->situation.en_passant_file();
+	int file = _shown.en_passant_file();
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "fps: %3d", _fps);
+	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "frame:");
+	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "%.1f ms", _frame_ms);
+	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "cpu: %.0f%%", 100 * _cpu_usage);
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, " ");
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "e.p.:");
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "%d", file);
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, " ");
 	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "turn:");
-	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "%d", _iter->index);
+	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "%d", _index);
+	if (_bot_running) {
+		al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, " ");
+		al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "depth:");
+		al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "%d", _shown_progress);
+	}
 //	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, " ");
 //	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "ͰͱͲͳʹ͵Ͷͷ͸͹ͺͻͼͽ;Ϳ");
 //	al_draw_textf(_font, fg, 580, 20 + lineno++ * 20, 0, "@µßöäü°^ŽͻψΏϟ€€€");
 	al_flip_display();
-	++_fps_counter;
+	++_frame_counter;
+	_frame_seconds += al_get_time() - start;
 }
@@ -0,0 +1,637 @@
+/* Plays a match between two bot configurations to measure a strength
+ * difference.
+ *
+ * A bot is given as "random" or "speedy" followed by comma separated
+ * settings, e.g. "speedy,depth=4" or "speedy,nodes=20000,hash=64":
+ *
+ *     depth=<plies>   deepest iteration, 3 without a time control
+ *     nodes=<nodes>   node bound per move
+ *     hash=<MB>       size of the transposition table, 16 by default
+ *
+ * Every opening of the suite is played twice with the colours swapped, in
+ * order and round robin once the suite is used up.  Without a suite all
+ * games start from the standard position.  A suite is a PGN file, whose
+ * main lines are the openings, or a file with one FEN or EPD per line.
+ *
+ * A pool of threads plays the games concurrently, each with bots of its
+ * own.  A game ends by mate, stalemate, threefold repetition, the
+ * fifty-move rule, insufficient material, an illegal move or a lost time,
+ * or it is adjudicated:
+ *
+ *     -maxplies <plies>            a draw after this many plies, 400 by default
+ *     -resign <cp> <plies>         a loss if the mover's own score was at
+ *                                  most -cp for this many of its moves
+ *                                  and the opponent's at least cp
+ *     -draw <move> <cp> <plies>    a draw from this move on if both scores
+ *                                  stayed within cp for this many plies
+ *
+ * Only speedy bots report scores.  With -sprt the match stops early as
+ * soon as a sequential probability ratio test between the hypotheses that
+ * the first bot is elo0 or elo1 stronger than the second ends; the games
+ * still running are played out.  The summary gives the Elo difference
+ * with a 95% confidence interval.
+ *
+ * usage: match <bot1> <bot2> [-games <n>] [-openings <file>] [-tc <s>[+<inc>]]
+ *              [-margin <ms>] [-maxplies <plies>] [-resign <cp> <plies>]
+ *              [-draw <move> <cp> <plies>] [-sprt <elo0> <elo1> [<alpha> <beta>]]
+ *              [-pgnout <file>] [-t <threads>] [-q]
+ */
+
+#include "MappedFile.hpp"
+#include "PgnReader.hpp"
+#include "RandomBot.hpp"
+#include "Rules.hpp"
+#include "SpeedyBot.hpp"
+#include "fen.hpp"
+#include "san.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int DEFAULT_GAMES = 100;
+static const int DEFAULT_MAX_PLIES = 400;
+static const int DEFAULT_HASH = 16;
+static const int DEFAULT_MARGIN = 50;
+static const int MAX_PLIES = 64;
+/// the number of moves the clock is split over
+static const int MOVES_TO_GO = 30;
+
+struct BotConfig {
+	std::string name;
+	bool random = false;
+	SearchLimits limits;
+	int hash = DEFAULT_HASH;
+};
+
+struct Opening {
+	Situation start;
+	int full_move;
+	std::vector<Action> actions;
+};
+
+struct Adjudication {
+	int max_plies = DEFAULT_MAX_PLIES;
+	/// in pawns, 0 disables
+	float resign_score = 0;
+	int resign_plies = 0;
+	int draw_move = 0;
+	float draw_score = 0;
+	int draw_plies = 0;
+};
+
+struct TimeControl {
+	/// in milliseconds, 0 without a time control
+	int time = 0;
+	int increment = 0;
+	/// overrun allowed before a game is lost on time
+	int margin = DEFAULT_MARGIN;
+};
+
+struct GameRecord {
+	int round;
+	bool first_is_white;
+	const Opening *opening;
+	std::vector<Action> actions;
+	PgnResult result;
+	std::string termination;
+};
+
+/// a bot of a worker, kept across its games
+struct Contestant {
+	std::unique_ptr<Bot> bot;
+	/// null for random bots
+	SpeedyBot *speedy = nullptr;
+	std::shared_ptr<TranspositionTable> tt;
+	const BotConfig *config;
+	bool has_score;
+	/// the last score, for the player to move
+	float score;
+};
+
+static bool parse_bot(const char *spec, BotConfig &config) {
+	config.name = spec;
+	std::stringstream in(spec);
+	std::string field;
+	std::getline(in, field, ',');
+	if (field == "random")
+		config.random = true;
+	else if (field != "speedy")
+		return false;
+
+	while (std::getline(in, field, ',')) {
+		size_t equals = field.find('=');
+		if (equals == std::string::npos || config.random)
+			return false;
+		std::string key = field.substr(0, equals);
+		const char *value = field.c_str() + equals + 1;
+		if (key == "depth")
+			config.limits.depth = std::min(std::max(atoi(value), 1), MAX_PLIES);
+		else if (key == "nodes")
+			config.limits.nodes = std::max(1LL, atoll(value));
+		else if (key == "hash")
+			config.hash = std::max(1, atoi(value));
+		else
+			return false;
+	}
+	return true;
+}
+
+static bool parse_time_control(const char *s, TimeControl &tc) {
+	char *end;
+	double seconds = strtod(s, &end);
+	double increment = 0;
+	if (*end == '+')
+		increment = strtod(end + 1, &end);
+	if (*end || seconds <= 0 || increment < 0)
+		return false;
+	tc.time = (int)(seconds * 1000);
+	tc.increment = (int)(increment * 1000);
+	return true;
+}
+
+static bool load_openings(const char *path, std::vector<Opening> &openings) {
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	size_t length = strlen(path);
+	if (length >= 4 && !strcmp(path + length - 4, ".pgn")) {
+		PgnReader reader(file.begin(), file.end());
+		PgnGame game;
+		PgnError error;
+		while (reader.next(game, error)) {
+			if (error.message) {
+				fprintf(stderr, "%s:%d:%d: %s, skipped\n", path, error.line, error.column, error.message);
+				continue;
+			}
+			openings.push_back(Opening{game.start, game.start_full_move, game.actions});
+		}
+		return true;
+	}
+
+	const char *s = file.begin();
+	int number = 0;
+	while (s < file.end()) {
+		++number;
+		const char *end = std::find(s, file.end(), '\n');
+		const char *first = s;
+		while (first < end && (*first == ' ' || *first == '\t' || *first == '\r'))
+			++first;
+		if (first < end && *first != '#') {
+			Opening opening;
+			opening.full_move = 1;
+			if (fen_parse(first, end, opening.start, &opening.full_move))
+				openings.push_back(opening);
+			else
+				fprintf(stderr, "%s:%d: invalid FEN, skipped\n", path, number);
+		}
+		s = end + (end < file.end());
+	}
+	return true;
+}
+
+static void setup_player(Contestant &player, const BotConfig &config) {
+	player.config = &config;
+	if (config.random) {
+		RandomBot *bot = new RandomBot(std::random_device()());
+		bot->set_verbose(false);
+		player.bot.reset(bot);
+		return;
+	}
+	player.speedy = new SpeedyBot();
+	player.bot.reset(player.speedy);
+	player.speedy->set_verbose(false);
+	player.tt = std::make_shared<TranspositionTable>(((size_t)config.hash << 20) / TranspositionTable::SLOT_SIZE);
+	player.speedy->set_transposition_table(player.tt);
+	player.speedy->set_info_callback([&player](const SearchInfo &info) {
+		player.has_score = true;
+		player.score = info.score;
+	});
+}
+
+static bool is_insufficient_material(const Board &board) {
+	int minors = 0;
+	const Piece *pieces = board.pieces();
+	for (int i = 0; i < board.width() * board.height(); ++i) {
+		Type type = pieces[i].type;
+		if (type == TYPE_QUEEN || type == TYPE_ROOK || type == TYPE_PAWN)
+			return false;
+		if (type == TYPE_BISHOP || type == TYPE_KNIGHT)
+			++minors;
+	}
+	return minors <= 1;
+}
+
+/// the win of a player as a result
+static PgnResult win(Player player) {
+	return player == PLAYER_WHITE ? PGN_WHITE_WINS : PGN_BLACK_WINS;
+}
+
+static void play(Contestant (&players)[2], const TimeControl &tc, const Adjudication &adjudication, GameRecord &record) {
+	const Opening &opening = *record.opening;
+	Game game(opening.start);
+	for (auto &action : opening.actions)
+		game.action(action);
+
+	// players[0] is the first bot, seat[c] the player of colour c
+	Contestant *seat[2];
+	seat[PLAYER_WHITE] = &players[record.first_is_white ? 0 : 1];
+	seat[PLAYER_BLACK] = &players[record.first_is_white ? 1 : 0];
+	int clock[2] = {tc.time, tc.time};
+	int resign_plies[2] = {0, 0};
+	int draw_plies = 0;
+	for (auto &player : players) {
+		player.bot->reset(opening.start);
+		for (auto &action : opening.actions)
+			player.bot->update(action);
+		if (player.tt)
+			player.tt->clear();
+	}
+
+	Rules rules;
+	std::vector<Action> legal;
+	while (true) {
+		const Situation &situation = game.current_situation();
+		Player active = situation.active_player();
+
+		legal.clear();
+		rules.getAllLegalMoves(situation, legal);
+		if (legal.empty()) {
+			bool check = rules.isPlayerInCheck(situation, active);
+			record.result = check ? win((Player)!active) : PGN_DRAW;
+			record.termination = check ? "checkmate" : "stalemate";
+			return;
+		}
+		if (game.position_repetition_counter() >= 3) {
+			record.result = PGN_DRAW;
+			record.termination = "threefold repetition";
+			return;
+		}
+		if (situation.half_move_counter() >= 100) {
+			record.result = PGN_DRAW;
+			record.termination = "fifty-move rule";
+			return;
+		}
+		if (is_insufficient_material(situation)) {
+			record.result = PGN_DRAW;
+			record.termination = "insufficient material";
+			return;
+		}
+		if ((int)record.actions.size() >= adjudication.max_plies) {
+			record.result = PGN_DRAW;
+			record.termination = "adjudication: maximum length";
+			return;
+		}
+
+		Contestant &mover = *seat[active];
+		if (mover.speedy) {
+			SearchLimits limits = mover.config->limits;
+			if (tc.time) {
+				// an even share of the clock plus most of the increment
+				int share = clock[active] / MOVES_TO_GO + tc.increment * 3 / 4;
+				limits.movetime = std::max(std::min(share, clock[active] / 2), 1);
+				if (limits.depth == 0)
+					limits.depth = MAX_PLIES;
+			}
+			mover.speedy->set_limits(limits);
+		}
+		mover.has_score = false;
+
+		auto start = std::chrono::steady_clock::now();
+		Action action = mover.bot->next_action();
+		int elapsed = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		if (std::find(legal.begin(), legal.end(), action) == legal.end()) {
+			record.result = win((Player)!active);
+			record.termination = "illegal move";
+			return;
+		}
+		if (tc.time) {
+			clock[active] -= elapsed;
+			if (clock[active] < -tc.margin) {
+				record.result = win((Player)!active);
+				record.termination = "time forfeit";
+				return;
+			}
+			clock[active] = std::max(clock[active], 0) + tc.increment;
+		}
+
+		game.action(action);
+		record.actions.push_back(action);
+		for (auto &player : players)
+			player.bot->update(action);
+
+		// scores are for the mover, the opponent's last one for the opponent
+		Contestant &opponent = *seat[!active];
+		bool scored = mover.has_score && opponent.has_score;
+		if (adjudication.resign_score > 0) {
+			if (scored && mover.score <= -adjudication.resign_score && opponent.score >= adjudication.resign_score)
+				++resign_plies[active];
+			else
+				resign_plies[active] = 0;
+			if (resign_plies[active] >= adjudication.resign_plies) {
+				record.result = win((Player)!active);
+				record.termination = "adjudication: resignation";
+				return;
+			}
+		}
+		if (adjudication.draw_score > 0) {
+			int move = opening.full_move + ((int)(opening.actions.size() + record.actions.size()) + (opening.start.active_player() == PLAYER_BLACK)) / 2;
+			if (scored && move >= adjudication.draw_move && std::fabs(mover.score) <= adjudication.draw_score
+					&& std::fabs(opponent.score) <= adjudication.draw_score)
+				++draw_plies;
+			else
+				draw_plies = 0;
+			if (draw_plies >= adjudication.draw_plies) {
+				record.result = PGN_DRAW;
+				record.termination = "adjudication: draw";
+				return;
+			}
+		}
+	}
+}
+
+static const char *result_string(PgnResult result) {
+	switch (result) {
+	case PGN_WHITE_WINS: return "1-0";
+	case PGN_BLACK_WINS: return "0-1";
+	case PGN_DRAW: return "1/2-1/2";
+	default: return "*";
+	}
+}
+
+static void write_pgn(FILE *file, const GameRecord &record, const BotConfig (&configs)[2]) {
+	const Opening &opening = *record.opening;
+	const char *white = configs[record.first_is_white ? 0 : 1].name.c_str();
+	const char *black = configs[record.first_is_white ? 1 : 0].name.c_str();
+
+	Situation standard;
+	fen_parse(FEN_STANDARD, standard);
+	bool is_standard = opening.full_move == 1 && fen_string(opening.start) == fen_string(standard);
+
+	fprintf(file, "[Event \"match\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"%d\"]\n", record.round);
+	fprintf(file, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n", white, black, result_string(record.result));
+	if (!is_standard) {
+		fprintf(file, "[SetUp \"1\"]\n[FEN \"%s\"]\n", fen_string(opening.start, opening.full_move).c_str());
+	}
+	fprintf(file, "[PlyCount \"%d\"]\n[Termination \"%s\"]\n\n",
+			(int)(opening.actions.size() + record.actions.size()), record.termination.c_str());
+
+	// the opening and the game, wrapped before 80 columns
+	Situation situation = opening.start;
+	int full_move = opening.full_move;
+	int column = 0;
+	auto word = [&](const char *text) {
+		int length = (int)strlen(text);
+		if (column > 0 && column + 1 + length > 79) {
+			fputc('\n', file);
+			column = 0;
+		} else if (column > 0) {
+			fputc(' ', file);
+			++column;
+		}
+		fputs(text, file);
+		column += length;
+	};
+	bool first = true;
+	for (size_t i = 0; i < opening.actions.size() + record.actions.size(); ++i) {
+		const Action &action = i < opening.actions.size() ? opening.actions[i] : record.actions[i - opening.actions.size()];
+		char text[16 + SAN_MAX_LENGTH];
+		int length = 0;
+		if (situation.active_player() == PLAYER_WHITE)
+			length = sprintf(text, "%d. ", full_move);
+		else if (first)
+			length = sprintf(text, "%d... ", full_move);
+		san_write(situation, action, text + length);
+		word(text);
+		if (situation.active_player() == PLAYER_BLACK)
+			++full_move;
+		situation.action(action);
+		first = false;
+	}
+	word(result_string(record.result));
+	fputs("\n\n", file);
+}
+
+/// the expected score of a player that is elo stronger
+static double expected_score(double elo) {
+	return 1 / (1 + pow(10, -elo / 400));
+}
+
+static double elo(double score) {
+	return -400 * log10(1 / score - 1);
+}
+
+struct Tally {
+	/// from the view of the first bot
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+
+	int games() const { return wins + draws + losses; }
+	double score() const { return (wins + 0.5 * draws) / games(); }
+	/// the variance of the score of a single game
+	double variance() const;
+	/** The log-likelihood ratio of elo1 against elo0 in the normal
+	 * approximation of the trinomial distribution of game results.
+	 */
+	double llr(double elo0, double elo1) const;
+};
+
+double Tally::variance() const {
+	double s = score();
+	return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+}
+
+double Tally::llr(double elo0, double elo1) const {
+	if (games() == 0)
+		return 0;
+	// half a game of every result keeps the variance of one-sided results
+	// above zero
+	double w = wins + 0.5, d = draws + 0.5, l = losses + 0.5, n = w + d + l;
+	double s = (w + 0.5 * d) / n;
+	double variance = (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+	double s0 = expected_score(elo0), s1 = expected_score(elo1);
+	return (s1 - s0) * (2 * s - s0 - s1) * n / (2 * variance);
+}
+
+static void print_elo(const Tally &tally) {
+	if (tally.games() == 0)
+		return;
+	double s = tally.score();
+	double margin = 1.96 * sqrt(tally.variance() / tally.games());
+	double low = std::max(s - margin, 1e-6), high = std::min(s + margin, 1 - 1e-6);
+	if (s <= 0 || s >= 1) {
+		printf("score %.1f%%, Elo %s\n", 100 * s, s <= 0 ? "-inf" : "+inf");
+		return;
+	}
+	printf("score %.1f%%, Elo %+.1f [%+.1f, %+.1f] (95%%)\n", 100 * s, elo(s), elo(low), elo(high));
+}
+
+int main(int argc, char **argv) {
+	BotConfig configs[2];
+	int bots = 0;
+	int games = DEFAULT_GAMES;
+	const char *openings_path = nullptr;
+	const char *pgn_path = nullptr;
+	TimeControl tc;
+	Adjudication adjudication;
+	bool sprt = false;
+	double elo0 = 0, elo1 = 0, alpha = 0.05, beta = 0.05;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	bool quiet = false;
+	bool usage = false;
+
+	for (int i = 1; i < argc && !usage; ++i) {
+		int rest = argc - i - 1;
+		if (!strcmp(argv[i], "-games") && rest >= 1)
+			games = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-openings") && rest >= 1)
+			openings_path = argv[++i];
+		else if (!strcmp(argv[i], "-tc") && rest >= 1)
+			usage = !parse_time_control(argv[++i], tc);
+		else if (!strcmp(argv[i], "-margin") && rest >= 1)
+			tc.margin = std::max(0, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-maxplies") && rest >= 1)
+			adjudication.max_plies = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-resign") && rest >= 2) {
+			adjudication.resign_score = std::max(1, atoi(argv[++i])) / 100.0f;
+			adjudication.resign_plies = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-draw") && rest >= 3) {
+			adjudication.draw_move = std::max(1, atoi(argv[++i]));
+			adjudication.draw_score = std::max(1, atoi(argv[++i])) / 100.0f;
+			adjudication.draw_plies = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-sprt") && rest >= 2) {
+			sprt = true;
+			elo0 = atof(argv[++i]);
+			elo1 = atof(argv[++i]);
+			if (rest >= 4 && argv[i + 1][0] != '-') {
+				alpha = atof(argv[++i]);
+				beta = atof(argv[++i]);
+			}
+			usage = elo0 >= elo1 || alpha <= 0 || alpha >= 0.5 || beta <= 0 || beta >= 0.5;
+		} else if (!strcmp(argv[i], "-pgnout") && rest >= 1)
+			pgn_path = argv[++i];
+		else if (!strcmp(argv[i], "-t") && rest >= 1)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-q"))
+			quiet = true;
+		else if (argv[i][0] != '-' && bots < 2) {
+			usage = !parse_bot(argv[i], configs[bots++]);
+			if (usage)
+				fprintf(stderr, "invalid bot %s\n", argv[i]);
+		} else
+			usage = true;
+	}
+	if (usage || bots < 2) {
+		fprintf(stderr, "usage: %s <bot1> <bot2> [-games <n>] [-openings <file>] [-tc <s>[+<inc>]]\n"
+				"             [-margin <ms>] [-maxplies <plies>] [-resign <cp> <plies>]\n"
+				"             [-draw <move> <cp> <plies>] [-sprt <elo0> <elo1> [<alpha> <beta>]]\n"
+				"             [-pgnout <file>] [-t <threads>] [-q]\n"
+				"a bot is \"random\" or \"speedy[,depth=<plies>][,nodes=<n>][,hash=<MB>]\"\n", argv[0]);
+		return 1;
+	}
+	for (auto &config : configs) {
+		if (!config.random && !tc.time && config.limits.depth == 0 && config.limits.nodes == 0)
+			config.limits.depth = 3;
+	}
+
+	std::vector<Opening> openings;
+	if (openings_path) {
+		if (!load_openings(openings_path, openings)) {
+			fprintf(stderr, "can't open %s\n", openings_path);
+			return 1;
+		}
+		if (openings.empty()) {
+			fprintf(stderr, "no openings in %s\n", openings_path);
+			return 1;
+		}
+	} else {
+		Opening standard;
+		fen_parse(FEN_STANDARD, standard.start);
+		standard.full_move = 1;
+		openings.push_back(standard);
+	}
+
+	FILE *pgn = nullptr;
+	if (pgn_path && !(pgn = fopen(pgn_path, "w"))) {
+		fprintf(stderr, "can't write %s\n", pgn_path);
+		return 1;
+	}
+
+	double lower = log(beta / (1 - alpha));
+	double upper = log((1 - beta) / alpha);
+
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<int> next(0);
+	std::atomic<bool> stop(false);
+	std::mutex mutex;
+	Tally tally;
+	const char *verdict = nullptr;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < std::min(threads, games); ++t) {
+		workers.emplace_back([&]() {
+			Contestant players[2];
+			for (int b = 0; b < 2; ++b)
+				setup_player(players[b], configs[b]);
+			for (int i = next++; i < games && !stop; i = next++) {
+				GameRecord record;
+				record.round = i + 1;
+				record.first_is_white = i % 2 == 0;
+				record.opening = &openings[i / 2 % openings.size()];
+				play(players, tc, adjudication, record);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				bool first_wins = record.result == (record.first_is_white ? PGN_WHITE_WINS : PGN_BLACK_WINS);
+				if (record.result == PGN_DRAW)
+					++tally.draws;
+				else if (first_wins)
+					++tally.wins;
+				else
+					++tally.losses;
+				if (pgn)
+					write_pgn(pgn, record, configs);
+				if (!quiet) {
+					printf("game %d: %s %s %s (%s), +%d =%d -%d\n", record.round,
+							configs[record.first_is_white ? 0 : 1].name.c_str(), result_string(record.result),
+							configs[record.first_is_white ? 1 : 0].name.c_str(), record.termination.c_str(),
+							tally.wins, tally.draws, tally.losses);
+				}
+				if (sprt && !verdict) {
+					double llr = tally.llr(elo0, elo1);
+					if (llr <= lower || llr >= upper) {
+						verdict = llr >= upper ? "H1 accepted" : "H0 accepted";
+						stop = true;
+					}
+				}
+			}
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+	if (pgn)
+		fclose(pgn);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%s vs %s: %d games, +%d =%d -%d, %.1f s, %d threads\n", configs[0].name.c_str(),
+			configs[1].name.c_str(), tally.games(), tally.wins, tally.draws, tally.losses, seconds,
+			(int)workers.size());
+	print_elo(tally);
+	if (sprt) {
+		printf("SPRT elo0 %g elo1 %g alpha %g beta %g: LLR %.2f [%.2f, %.2f], %s\n", elo0, elo1, alpha, beta,
+				tally.llr(elo0, elo1), lower, upper, verdict ? verdict : "no decision");
+	}
+
+	return 0;
+}
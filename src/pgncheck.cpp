@@ -0,0 +1,129 @@
+/* Reads and validates PGN game archives.
+ *
+ * The file is memory mapped and split at game boundaries into many parts,
+ * which a pool of worker threads reads with PgnReader.  Every move of every
+ * game is resolved and played, so a game that passes is legal.  Problems
+ * are printed as
+ *
+ *     <file>:<line>:<column>: <message> (game at line <line>)
+ *
+ * followed by a summary with the throughput.  The exit code is 0 if all
+ * games are valid.
+ *
+ * usage: pgncheck <games.pgn> [-t <threads>] [-q]
+ */
+
+#include "MappedFile.hpp"
+#include "PgnReader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// parts are about this big, so the threads stay balanced
+static const size_t PART_SIZE = 4 << 20;
+
+struct GameError {
+	PgnError error;
+	int game_line;
+};
+
+struct Part {
+	const char *begin;
+	const char *end;
+	/// number of line breaks in the part
+	int lines;
+	uint64 games;
+	uint64 moves;
+	std::vector<GameError> errors;
+};
+
+static void read_part(Part &part) {
+	PgnReader reader(part.begin, part.end, 0);
+	PgnGame game;
+	PgnError error;
+	while (reader.next(game, error)) {
+		++part.games;
+		part.moves += game.actions.size();
+		if (error.message)
+			part.errors.push_back(GameError{error, game.line});
+	}
+	part.lines = reader.line();
+}
+
+int main(int argc, char **argv) {
+	const char *input = nullptr;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	bool quiet = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-q"))
+			quiet = true;
+		else if (!input)
+			input = argv[i];
+		else
+			input = nullptr, i = argc;
+	}
+	if (!input) {
+		fprintf(stderr, "usage: %s <games.pgn> [-t <threads>] [-q]\n", argv[0]);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.open(input)) {
+		fprintf(stderr, "can't open %s\n", input);
+		return 1;
+	}
+
+	// split at game boundaries
+	std::vector<const char *> cuts;
+	size_t count = std::max<size_t>(threads, file.size() / PART_SIZE + 1);
+	PgnReader::split(file.begin(), file.end(), count, cuts);
+	std::vector<Part> parts;
+	for (size_t i = 0; i + 1 < cuts.size(); ++i)
+		parts.push_back(Part{cuts[i], cuts[i + 1], 0, 0, 0, {}});
+
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < parts.size(); i = next++)
+				read_part(parts[i]);
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	// line numbers within parts start at 0, turn them into file lines
+	uint64 games = 0, moves = 0, invalid = 0;
+	int first_line = 1;
+	for (auto &part : parts) {
+		games += part.games;
+		moves += part.moves;
+		invalid += part.errors.size();
+		for (auto &e : part.errors) {
+			if (!quiet)
+				printf("%s:%d:%d: %s (game at line %d)\n", input,
+						first_line + e.error.line, e.error.column, e.error.message,
+						first_line + e.game_line);
+		}
+		first_line += part.lines;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	seconds = std::max(seconds, 1e-6);
+	printf("%llu games, %llu moves, %llu invalid\n",
+			(unsigned long long)games, (unsigned long long)moves, (unsigned long long)invalid);
+	printf("%.2f s, %.0f games/s, %.1f MB/s, %d threads\n",
+			seconds, games / seconds, file.size() / seconds / (1 << 20), threads);
+
+	return invalid == 0 ? 0 : 1;
+}
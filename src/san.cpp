@@ -0,0 +1,217 @@
+#include "san.hpp"
+
+#include "Rules.hpp"
+
+#include <cstring>
+
+// indexed by Type
+static const char PIECE_CHARS[] = "KQRBNP";
+
+static Type piece_type(char c) {
+	const char *type = (const char *)memchr(PIECE_CHARS, c, 6);
+	return type && c ? static_cast<Type>(type - PIECE_CHARS) : TYPE_NONE;
+}
+
+static bool is_suffix(char c) {
+	return c == '+' || c == '#' || c == '!' || c == '?';
+}
+
+/// true if a piece on src could make a regular move to dst on an empty board
+static bool can_reach(Rules &rules, const Board &board, Tile src, Tile dst) {
+	if (!rules.isSquareInRange(board[src].type, dst - src))
+		return false;
+	return rules.isPathFree(board, src, dst);
+}
+
+const char *san_parse(const Position &position, const char *begin, const char *end, Action &action) {
+	if (position.width() != 8 || position.height() != 8)
+		return "unsupported board size";
+
+	while (end > begin && is_suffix(end[-1]))
+		--end;
+	if (begin == end)
+		return "empty move";
+
+	Rules rules;
+	const Board &board = position;
+	Player player = position.active_player();
+	size_t length = end - begin;
+
+	// castling
+	if (begin[0] == 'O' || begin[0] == '0') {
+		char c = begin[0];
+		bool queenside;
+		if (length == 3 && begin[1] == '-' && begin[2] == c)
+			queenside = false;
+		else if (length == 5 && begin[1] == '-' && begin[2] == c && begin[3] == '-' && begin[4] == c)
+			queenside = true;
+		else
+			return "malformed move";
+		Tile src = rules.getKingStartingSquare(position, player);
+		Tile dst = src + Tile(queenside ? -2 : +2, 0);
+		action = Action{player, CASTLING, src, dst, TYPE_NONE, NO_ANNOUNCEMENT};
+		return rules.isActionLegal(position, action) ? nullptr : "illegal move";
+	}
+
+	// the moving piece, pawns have no letter
+	const char *s = begin;
+	Type type = TYPE_PAWN;
+	if (*s >= 'A' && *s <= 'Z') {
+		type = piece_type(*s);
+		if (type == TYPE_NONE || type == TYPE_PAWN)
+			return "malformed move";
+		++s;
+	}
+
+	// promotion, with or without '='
+	Type promotion = TYPE_NONE;
+	if (type == TYPE_PAWN && end - s >= 3 && end[-1] >= 'A' && end[-1] <= 'Z') {
+		promotion = piece_type(end[-1]);
+		if (promotion == TYPE_NONE || promotion == TYPE_KING || promotion == TYPE_PAWN)
+			return "malformed promotion";
+		--end;
+		if (end[-1] == '=')
+			--end;
+	}
+
+	// target square
+	if (end - s < 2)
+		return "malformed move";
+	Coord dst_x = end[-2] - 'a';
+	Coord dst_y = end[-1] - '1';
+	if (dst_x < 0 || dst_x >= 8 || dst_y < 0 || dst_y >= 8)
+		return "malformed move";
+	Tile dst(dst_x, dst_y);
+	end -= 2;
+
+	bool capture = false;
+	if (end > s && (end[-1] == 'x' || end[-1] == ':')) {
+		capture = true;
+		--end;
+	}
+
+	// optional disambiguation
+	Coord from_x = -1;
+	Coord from_y = -1;
+	for (; s < end; ++s) {
+		if (*s >= 'a' && *s <= 'h' && from_x < 0)
+			from_x = *s - 'a';
+		else if (*s >= '1' && *s <= '8' && from_y < 0)
+			from_y = *s - '1';
+		else
+			return "malformed move";
+	}
+
+	if (type == TYPE_PAWN) {
+		Coord forward = player == PLAYER_WHITE ? +1 : -1;
+		Tile src;
+		if (capture || (from_x >= 0 && from_x != dst_x)) {
+			if (from_x < 0)
+				return "malformed move";
+			src = Tile(from_x, dst_y - forward);
+		} else {
+			// a single step, or a double step over an empty tile
+			src = Tile(dst_x, dst_y - forward);
+			if (board.isInBound(src) && board[src] == Piece::NONE)
+				src = Tile(dst_x, dst_y - 2 * forward);
+		}
+		if (!board.isInBound(src) || board[src] != Piece{player, TYPE_PAWN})
+			return "illegal move";
+
+		Coord end_row = player == PLAYER_WHITE ? 7 : 0;
+		if (dst_y == end_row && promotion == TYPE_NONE)
+			return "missing promotion";
+		if (dst_y != end_row && promotion != TYPE_NONE)
+			return "illegal promotion";
+
+		action = rules.examineMove(position, src, dst, promotion);
+		action.announcement = NO_ANNOUNCEMENT;
+		return rules.isActionLegal(position, action) ? nullptr : "illegal move";
+	}
+
+	// find the one piece of that type that can legally go there
+	int found = 0;
+	Piece piece = Piece{player, type};
+	for (Coord y = 0; y < 8; ++y)
+	for (Coord x = 0; x < 8; ++x) {
+		Tile src(x, y);
+		if (board[src] != piece)
+			continue;
+		if ((from_x >= 0 && x != from_x) || (from_y >= 0 && y != from_y))
+			continue;
+		if (!can_reach(rules, board, src, dst))
+			continue;
+		Action candidate = rules.examineMove(position, src, dst);
+		candidate.announcement = NO_ANNOUNCEMENT;
+		if (!rules.isActionLegal(position, candidate))
+			continue;
+		action = candidate;
+		++found;
+	}
+
+	if (found == 0)
+		return "illegal move";
+	if (found > 1)
+		return "ambiguous move";
+	return nullptr;
+}
+
+int san_write(const Position &position, const Action &action, char *buffer) {
+	Rules rules;
+	const Board &board = position;
+	Piece piece = board[action.src];
+	char *s = buffer;
+
+	if (action.type == CASTLING) {
+		bool queenside = action.dst[0] < action.src[0];
+		memcpy(s, queenside ? "O-O-O" : "O-O", queenside ? 5 : 3);
+		s += queenside ? 5 : 3;
+	} else if (piece.type == TYPE_PAWN) {
+		if (action.type == CAPTURE_PIECE || action.type == EN_PASSANT) {
+			*s++ = 'a' + action.src[0];
+			*s++ = 'x';
+		}
+		*s++ = 'a' + action.dst[0];
+		*s++ = '1' + action.dst[1];
+		if (action.promotion != TYPE_NONE) {
+			*s++ = '=';
+			*s++ = PIECE_CHARS[action.promotion];
+		}
+	} else {
+		*s++ = PIECE_CHARS[piece.type];
+
+		// other pieces of the same kind that could go there as well
+		bool ambiguous = false, same_file = false, same_rank = false;
+		for (Coord y = 0; y < board.height(); ++y)
+		for (Coord x = 0; x < board.width(); ++x) {
+			Tile other(x, y);
+			if (other == action.src || board[other] != piece)
+				continue;
+			if (!can_reach(rules, board, other, action.dst))
+				continue;
+			if (!rules.isActionLegal(position, rules.examineMove(position, other, action.dst)))
+				continue;
+			ambiguous = true;
+			same_file |= x == action.src[0];
+			same_rank |= y == action.src[1];
+		}
+		if (ambiguous && (!same_file || same_rank))
+			*s++ = 'a' + action.src[0];
+		if (ambiguous && same_file)
+			*s++ = '1' + action.src[1];
+
+		if (action.type == CAPTURE_PIECE)
+			*s++ = 'x';
+		*s++ = 'a' + action.dst[0];
+		*s++ = '1' + action.dst[1];
+	}
+
+	// check and mate
+	Position next = position;
+	next.action(action);
+	if (rules.isPlayerInCheck(next, next.active_player()))
+		*s++ = rules.getAllLegalMoves(next).empty() ? '#' : '+';
+
+	*s = '\0';
+	return (int)(s - buffer);
+}
@@ -0,0 +1,31 @@
+#ifndef SAN_HPP
+#define SAN_HPP
+
+#include "Position.hpp"
+
+/* Standard algebraic notation for moves on 8x8 boards, e.g. "Nbd7",
+ * "exd6", "e8=Q+" or "O-O-O".
+ */
+
+/// buffer size for san_write, including the terminating zero
+static const int SAN_MAX_LENGTH = 12;
+
+/** Resolves a move in SAN against a position.
+ *
+ * Check, mate and annotation suffixes ("+", "#", "!", "?") are accepted and
+ * ignored, and castling may be written with zeros.  Only the pieces that
+ * could reach the target square are checked with Rules::isActionLegal, so
+ * this is much cheaper than generating all legal moves.
+ *
+ * Returns nullptr on success, otherwise a short description of the problem
+ * ("illegal move", "ambiguous move", ...).
+ */
+const char *san_parse(const Position &, const char *begin, const char *end, Action &);
+
+/** Writes a legal action in SAN, including check and mate suffixes, into
+ * buffer, which must hold at least SAN_MAX_LENGTH characters.  Returns the
+ * length without the terminating zero.
+ */
+int san_write(const Position &, const Action &, char *buffer);
+
+#endif // SAN_HPP
@@ -0,0 +1,681 @@
+/* A long-running analysis service.  Requests are read as JSON lines from
+ * stdin, or from the clients of a Unix domain socket, and answered on the
+ * same stream as the searches finish, which is not necessarily in order:
+ *
+ *     {"id": "a", "fen": "<fen>", "depth": 8}
+ *     {"id": "b", "fen": "<fen>", "movetime": 500, "nodes": 100000, "multipv": 3}
+ *     {"cancel": "a"}
+ *     {"stats": true}
+ *
+ * The answer to an analysis carries its id, the status ("ok" or
+ * "cancelled"), the best move and the line in long algebraic notation,
+ * the depth, the score in "cp" or "mate", the nodes, and the time spent in
+ * the queue and in total in milliseconds.  With a multipv above 1 it also
+ * lists that many best moves in "lines", each with its score and line.
+ * Problems are answered with an "error" instead.  A request without limits
+ * searches DEFAULT_MOVETIME milliseconds.
+ *
+ * A pool of workers, each with its own bot, takes the requests from a
+ * bounded queue and shares one transposition table.  While the queue is
+ * full, the requests of a client wait in a backlog of its own, and the
+ * clients' backlogs take turns as the queue gets room.  Only once the
+ * backlog is full too is the input of the client not read any further, so
+ * the pipe or socket slows the client down and a batch of any size is
+ * analysed completely, while cancels and stats sent before are still
+ * handled right away.  With -reject a request that finds the queue full is
+ * refused with the error "queue full" instead.  A cancelled request is
+ * dropped from the backlog or the queue, or its search is stopped and the
+ * best move found so far answered.  Ids are per client.
+ *
+ * usage: chess-service [-socket <path>] [-t <threads>] [-queue <requests>]
+ *                      [-backlog <requests>] [-reject] [-hash <MB>]
+ */
+
+#include "Rules.hpp"
+#include "SpeedyBot.hpp"
+#include "fen.hpp"
+#include "lan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const int DEFAULT_MOVETIME = 1000;
+static const int DEFAULT_QUEUE = 256;
+static const int DEFAULT_BACKLOG = 256;
+static const int DEFAULT_HASH = 64;
+static const int MAX_PLIES = 64;
+/// the latency percentiles are taken over this many latest requests
+static const size_t LATENCY_WINDOW = 4096;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Request;
+
+/// one client, answers to it may come from any worker
+class Connection {
+public:
+	Connection(FILE *in, FILE *out) : in(in), out(out) {}
+	~Connection() {
+		fclose(in);
+		if (out != stdout)
+			fclose(out);
+	}
+	Connection(const Connection &) = delete;
+	Connection &operator = (const Connection &) = delete;
+
+	void send(const std::string &line) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		fputs(line.c_str(), out);
+		fputc('\n', out);
+		fflush(out);
+	}
+
+	FILE *in;
+	FILE *out;
+	/// requests waiting for room in the queue, guarded by the mutex of the service
+	std::deque<std::shared_ptr<Request>> backlog;
+
+private:
+	std::mutex _mutex;
+};
+
+struct Request {
+	std::shared_ptr<Connection> connection;
+	std::string id;
+	Situation situation;
+	SearchLimits limits;
+	int multipv;
+	Clock::time_point received;
+	std::atomic<bool> stop{false};
+};
+
+/// fields of a flat JSON object, strings unescaped and numbers as written
+typedef std::map<std::string, std::string> JsonObject;
+
+static const char *skip_space(const char *s, const char *end) {
+	while (s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n'))
+		++s;
+	return s;
+}
+
+/// reads a string after its opening quote, nullptr if it is malformed
+static const char *parse_string(const char *s, const char *end, std::string &value) {
+	value.clear();
+	while (s < end && *s != '"') {
+		if (*s == '\\') {
+			if (++s == end)
+				return nullptr;
+			switch (*s) {
+			case 'n': value += '\n'; break;
+			case 't': value += '\t'; break;
+			case 'r': value += '\r'; break;
+			case 'b': value += '\b'; break;
+			case 'f': value += '\f'; break;
+			case 'u':
+				// only ASCII is of any use in a FEN or an id
+				if (end - s < 5)
+					return nullptr;
+				value += (char)strtol(std::string(s + 1, s + 5).c_str(), nullptr, 16);
+				s += 4;
+				break;
+			default: value += *s; break;
+			}
+			++s;
+		} else {
+			value += *s++;
+		}
+	}
+	return s < end ? s + 1 : nullptr;
+}
+
+/** Reads an object of strings, numbers and literals.  Returns nullptr on
+ * success, otherwise a description of the problem.
+ */
+static const char *parse_object(const std::string &line, JsonObject &object) {
+	const char *s = line.data(), *end = s + line.size();
+	s = skip_space(s, end);
+	if (s == end || *s++ != '{')
+		return "expected an object";
+	s = skip_space(s, end);
+	if (s < end && *s == '}')
+		return nullptr;
+	while (true) {
+		std::string key, value;
+		s = skip_space(s, end);
+		if (s == end || *s != '"' || !(s = parse_string(s + 1, end, key)))
+			return "expected a key";
+		s = skip_space(s, end);
+		if (s == end || *s++ != ':')
+			return "expected ':'";
+		s = skip_space(s, end);
+		if (s < end && *s == '"') {
+			if (!(s = parse_string(s + 1, end, value)))
+				return "unterminated string";
+		} else {
+			const char *first = s;
+			while (s < end && (isalnum((unsigned char)*s) || *s == '-' || *s == '+' || *s == '.'))
+				++s;
+			if (s == first)
+				return "unsupported value";
+			value.assign(first, s);
+		}
+		object[key] = value;
+		s = skip_space(s, end);
+		if (s < end && *s == ',') {
+			++s;
+			continue;
+		}
+		if (s < end && *s == '}')
+			return skip_space(s + 1, end) == end ? nullptr : "trailing characters";
+		return "expected ',' or '}'";
+	}
+}
+
+static std::string quote(const std::string &s) {
+	std::string quoted = "\"";
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			quoted += '\\';
+			quoted += c;
+		} else if ((unsigned char)c < 0x20) {
+			char escape[8];
+			snprintf(escape, sizeof escape, "\\u%04x", c);
+			quoted += escape;
+		} else {
+			quoted += c;
+		}
+	}
+	return quoted + "\"";
+}
+
+static std::string pv_json(const std::vector<Action> &pv) {
+	std::string json = "[";
+	for (size_t i = 0; i < pv.size(); ++i)
+		json += (i ? ", " : "") + quote(lan_string(pv[i]));
+	return json + "]";
+}
+
+static std::string score_json(float rating) {
+	ReportedScore score = ReportedScore::from_rating(rating);
+	return (score.mate ? "{\"mate\": " : "{\"cp\": ") + std::to_string(score.value) + "}";
+}
+
+static double milliseconds(Clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+class Service {
+public:
+	/** backlog requests of each client wait while the queue is full, reject
+	 * refuses requests instead
+	 */
+	Service(int threads, size_t capacity, size_t backlog, size_t tt_size, bool reject);
+	~Service();
+
+	/// handles one line of a client
+	void command(const std::shared_ptr<Connection> &, const std::string &line);
+	/// cancels everything of a client that went away
+	void disconnect(const std::shared_ptr<Connection> &);
+	/// waits for the queue to run empty
+	void drain();
+
+	std::string stats();
+
+private:
+	void work(int worker);
+	void finish(Request &, const std::string &answer);
+	/// moves backlogs into the queue while it has room, _mutex must be held
+	bool refill();
+
+	size_t _capacity;
+	size_t _backlog;
+	bool _reject;
+	std::shared_ptr<TranspositionTable> _tt;
+
+	std::mutex _mutex;
+	std::condition_variable _work_signal;
+	std::condition_variable _idle_signal;
+	/// a backlog got shorter
+	std::condition_variable _space_signal;
+	std::deque<std::shared_ptr<Request>> _queue;
+	/// the clients with a backlog, whose turn is next first
+	std::deque<std::shared_ptr<Connection>> _waiting;
+	/// the request of every worker, null while it waits
+	std::vector<std::shared_ptr<Request>> _running;
+	bool _shutdown = false;
+	std::vector<std::thread> _workers;
+
+	// counters
+	uint64 _completed = 0;
+	uint64 _cancelled = 0;
+	uint64 _rejected = 0;
+	uint64 _errors = 0;
+	/// total latencies of the latest requests, in milliseconds
+	std::vector<double> _latencies;
+	size_t _next_latency = 0;
+};
+
+Service::Service(int threads, size_t capacity, size_t backlog, size_t tt_size, bool reject) :
+	_capacity(capacity),
+	_backlog(backlog),
+	_reject(reject),
+	_tt(std::make_shared<TranspositionTable>(tt_size)),
+	_running(threads)
+{
+	for (int i = 0; i < threads; ++i)
+		_workers.emplace_back(&Service::work, this, i);
+}
+
+Service::~Service() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_shutdown = true;
+		for (auto &request : _running) {
+			if (request)
+				request->stop = true;
+		}
+	}
+	_work_signal.notify_all();
+	_space_signal.notify_all();
+	for (auto &worker : _workers)
+		worker.join();
+}
+
+void Service::command(const std::shared_ptr<Connection> &connection, const std::string &line) {
+	if (line.find_first_not_of(" \t\r") == std::string::npos)
+		return;
+
+	JsonObject object;
+	const char *message = parse_object(line, object);
+	std::string id = object.count("id") ? object["id"] : "";
+	auto fail = [&](const std::string &error) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_errors;
+		}
+		connection->send("{\"id\": " + quote(id) + ", \"error\": " + quote(error) + "}");
+	};
+	if (message)
+		return fail(message);
+
+	if (object.count("stats")) {
+		connection->send(stats());
+		return;
+	}
+
+	if (object.count("cancel")) {
+		const std::string &target = object["cancel"];
+		std::shared_ptr<Request> queued;
+		bool found = false, refilled = false;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::deque<std::shared_ptr<Request>> &backlog = connection->backlog;
+			for (auto i = backlog.begin(); i != backlog.end(); ++i) {
+				if ((*i)->id == target) {
+					queued = *i;
+					backlog.erase(i);
+					if (backlog.empty())
+						_waiting.erase(std::find(_waiting.begin(), _waiting.end(), connection));
+					break;
+				}
+			}
+			for (auto i = _queue.begin(); !queued && i != _queue.end(); ++i) {
+				if ((*i)->connection == connection && (*i)->id == target) {
+					queued = *i;
+					_queue.erase(i);
+					refilled = refill();
+					break;
+				}
+			}
+			for (auto &request : _running) {
+				if (!queued && request && request->connection == connection && request->id == target) {
+					request->stop = true;
+					found = true;
+				}
+			}
+		}
+		// a running search answers by itself once it stops
+		if (queued) {
+			queued->stop = true;
+			finish(*queued, "{\"id\": " + quote(target) + ", \"status\": \"cancelled\"}");
+			if (refilled)
+				_work_signal.notify_one();
+			_idle_signal.notify_all();
+			_space_signal.notify_all();
+		} else if (!found) {
+			id = target;
+			fail("unknown id");
+		}
+		return;
+	}
+
+	if (!object.count("fen"))
+		return fail("missing fen");
+	auto request = std::make_shared<Request>();
+	request->connection = connection;
+	request->id = id;
+	request->received = Clock::now();
+	if (!fen_parse(object["fen"].c_str(), request->situation))
+		return fail("invalid fen");
+	if (object.count("depth"))
+		request->limits.depth = std::min(std::max(atoi(object["depth"].c_str()), 1), MAX_PLIES);
+	if (object.count("nodes"))
+		request->limits.nodes = std::max(1LL, atoll(object["nodes"].c_str()));
+	if (object.count("movetime"))
+		request->limits.movetime = std::max(1, atoi(object["movetime"].c_str()));
+	request->multipv = object.count("multipv") ? std::max(1, atoi(object["multipv"].c_str())) : 1;
+	if (request->limits.depth == 0) {
+		if (request->limits.nodes == 0 && request->limits.movetime == 0)
+			request->limits.movetime = DEFAULT_MOVETIME;
+		request->limits.depth = MAX_PLIES;
+	}
+
+	{
+		// the reader of this client only waits once its backlog is full,
+		// which holds the client back through its pipe or socket
+		std::unique_lock<std::mutex> lock(_mutex);
+		std::deque<std::shared_ptr<Request>> &backlog = connection->backlog;
+		if (!_reject)
+			_space_signal.wait(lock, [&]() { return _shutdown || backlog.size() < _backlog; });
+		if (_queue.size() < _capacity && backlog.empty()) {
+			_queue.push_back(request);
+		} else if (_reject || _shutdown) {
+			++_rejected;
+			message = "queue full";
+		} else {
+			if (backlog.empty())
+				_waiting.push_back(connection);
+			backlog.push_back(request);
+			return;
+		}
+	}
+	if (message) {
+		connection->send("{\"id\": " + quote(id) + ", \"error\": \"queue full\"}");
+		return;
+	}
+	_work_signal.notify_one();
+}
+
+void Service::disconnect(const std::shared_ptr<Connection> &connection) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto gone = [&](const std::shared_ptr<Request> &request) {
+		return request->connection == connection;
+	};
+	size_t size = _queue.size();
+	_queue.erase(std::remove_if(_queue.begin(), _queue.end(), gone), _queue.end());
+	_cancelled += size - _queue.size() + connection->backlog.size();
+	connection->backlog.clear();
+	_waiting.erase(std::remove(_waiting.begin(), _waiting.end(), connection), _waiting.end());
+	for (auto &request : _running) {
+		if (request && gone(request))
+			request->stop = true;
+	}
+	if (refill())
+		_work_signal.notify_all();
+	_idle_signal.notify_all();
+	_space_signal.notify_all();
+}
+
+void Service::drain() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle_signal.wait(lock, [this]() {
+		return _queue.empty() && _waiting.empty() && std::none_of(_running.begin(), _running.end(),
+				[](const std::shared_ptr<Request> &request) { return (bool)request; });
+	});
+}
+
+std::string Service::stats() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t running = std::count_if(_running.begin(), _running.end(),
+			[](const std::shared_ptr<Request> &request) { return (bool)request; });
+	size_t waiting = 0;
+	for (auto &connection : _waiting)
+		waiting += connection->backlog.size();
+
+	std::vector<double> latencies = _latencies;
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&](double p) {
+		return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+	};
+	double mean = 0;
+	for (double latency : latencies)
+		mean += latency;
+	if (!latencies.empty())
+		mean /= latencies.size();
+
+	char buffer[512];
+	snprintf(buffer, sizeof buffer, "{\"waiting\": %u, \"queued\": %u, \"running\": %u, \"workers\": %u, \"capacity\": %u, "
+			"\"completed\": %llu, \"cancelled\": %llu, \"rejected\": %llu, \"errors\": %llu, "
+			"\"latency_ms\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}, "
+			"\"hashfull\": %d}",
+			(unsigned)waiting, (unsigned)_queue.size(), (unsigned)running, (unsigned)_running.size(), (unsigned)_capacity,
+			(unsigned long long)_completed, (unsigned long long)_cancelled,
+			(unsigned long long)_rejected, (unsigned long long)_errors,
+			mean, percentile(0.5), percentile(0.9), percentile(0.99),
+			latencies.empty() ? 0.0 : latencies.back(), _tt->hashfull());
+	return buffer;
+}
+
+void Service::finish(Request &request, const std::string &answer) {
+	request.connection->send(answer);
+	double latency = milliseconds(Clock::now() - request.received);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (request.stop)
+		++_cancelled;
+	else
+		++_completed;
+	if (_latencies.size() < LATENCY_WINDOW)
+		_latencies.push_back(latency);
+	else
+		_latencies[_next_latency++ % LATENCY_WINDOW] = latency;
+}
+
+bool Service::refill() {
+	bool moved = false;
+	while (_queue.size() < _capacity && !_waiting.empty()) {
+		std::shared_ptr<Connection> connection = _waiting.front();
+		_waiting.pop_front();
+		_queue.push_back(connection->backlog.front());
+		connection->backlog.pop_front();
+		if (!connection->backlog.empty())
+			_waiting.push_back(connection);
+		moved = true;
+	}
+	return moved;
+}
+
+void Service::work(int worker) {
+	SpeedyBot bot;
+	bot.set_verbose(false);
+	bot.set_transposition_table(_tt);
+	Rules rules;
+
+	while (true) {
+		std::shared_ptr<Request> request;
+		bool refilled;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_work_signal.wait(lock, [this]() { return _shutdown || !_queue.empty(); });
+			if (_shutdown)
+				return;
+			request = _queue.front();
+			_queue.pop_front();
+			_running[worker] = request;
+			refilled = refill();
+		}
+		if (refilled) {
+			_work_signal.notify_one();
+			_space_signal.notify_all();
+		}
+
+		double queued = milliseconds(Clock::now() - request->received);
+		std::string answer = "{\"id\": " + quote(request->id);
+		if (rules.getAllLegalMoves(request->situation).empty()) {
+			answer += ", \"error\": \"no legal moves\"}";
+		} else {
+			SearchInfo last{};
+			bot.set_info_callback([&](const SearchInfo &info) {
+				last = info;
+			});
+			bot.set_limits(request->limits);
+			bot.set_multipv(request->multipv);
+			bot.set_stop_flag(&request->stop);
+			bot.reset(request->situation);
+			Action action = bot.next_action();
+
+			answer += std::string(", \"status\": ") + (request->stop ? "\"cancelled\"" : "\"ok\"");
+			answer += ", \"bestmove\": " + quote(lan_string(action));
+			answer += ", \"depth\": " + std::to_string(last.depth);
+			answer += ", \"score\": " + score_json(last.score);
+			answer += ", \"pv\": " + pv_json(last.pv);
+			if (request->multipv > 1) {
+				answer += ", \"lines\": [";
+				for (size_t i = 0; i < last.lines.size(); ++i) {
+					const RootLine &line = last.lines[i];
+					answer += std::string(i ? ", " : "") + "{\"move\": " + quote(lan_string(line.action))
+							+ ", \"score\": " + score_json(line.score) + ", \"pv\": " + pv_json(line.pv) + "}";
+				}
+				answer += "]";
+			}
+			answer += ", \"nodes\": " + std::to_string(bot.stats().total_nodes());
+			char times[64];
+			snprintf(times, sizeof times, ", \"queue_ms\": %.1f, \"time_ms\": %.1f}",
+					queued, milliseconds(Clock::now() - request->received));
+			answer += times;
+		}
+		finish(*request, answer);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_running[worker].reset();
+		}
+		_idle_signal.notify_all();
+	}
+}
+
+static bool read_line(FILE *in, std::string &line) {
+	line.clear();
+	char buffer[4096];
+	while (fgets(buffer, sizeof buffer, in)) {
+		line += buffer;
+		if (line.back() == '\n') {
+			line.pop_back();
+			return true;
+		}
+	}
+	return !line.empty();
+}
+
+static void serve(Service &service, std::shared_ptr<Connection> connection) {
+	std::string line;
+	while (read_line(connection->in, line))
+		service.command(connection, line);
+}
+
+int main(int argc, char **argv) {
+	const char *socket_path = nullptr;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	int capacity = DEFAULT_QUEUE;
+	int backlog = DEFAULT_BACKLOG;
+	int hash = DEFAULT_HASH;
+	bool reject = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-socket") && i + 1 < argc)
+			socket_path = argv[++i];
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-queue") && i + 1 < argc)
+			capacity = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-backlog") && i + 1 < argc)
+			backlog = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-reject"))
+			reject = true;
+		else if (!strcmp(argv[i], "-hash") && i + 1 < argc)
+			hash = std::max(1, atoi(argv[++i]));
+		else {
+			fprintf(stderr, "usage: %s [-socket <path>] [-t <threads>] [-queue <requests>]\n"
+					"                     [-backlog <requests>] [-reject] [-hash <MB>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Service service(threads, capacity, backlog, ((size_t)hash << 20) / TranspositionTable::SLOT_SIZE, reject);
+
+	if (!socket_path) {
+		// answers go to stdout, everything asked is answered before the end
+		auto connection = std::make_shared<Connection>(stdin, stdout);
+		serve(service, connection);
+		service.drain();
+		fprintf(stderr, "%s\n", service.stats().c_str());
+		return 0;
+	}
+
+#if defined(_WIN32)
+	fprintf(stderr, "Unix domain sockets are not supported here, use stdin\n");
+	return 1;
+#else
+	// writing to a client that went away must not end the service
+	signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un address = sockaddr_un();
+	address.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof address.sun_path) {
+		fprintf(stderr, "socket path too long: %s\n", socket_path);
+		return 1;
+	}
+	strcpy(address.sun_path, socket_path);
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path);
+	if (server < 0 || bind(server, (sockaddr *)&address, sizeof address) < 0 || listen(server, 16) < 0) {
+		fprintf(stderr, "can't listen on %s: %s\n", socket_path, strerror(errno));
+		return 1;
+	}
+
+	while (true) {
+		int client = accept(server, nullptr, nullptr);
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "accept: %s\n", strerror(errno));
+			break;
+		}
+		FILE *in = fdopen(client, "r");
+		FILE *out = fdopen(dup(client), "w");
+		if (!in || !out) {
+			fprintf(stderr, "fdopen: %s\n", strerror(errno));
+			close(client);
+			continue;
+		}
+		auto connection = std::make_shared<Connection>(in, out);
+		std::thread([&service, connection]() {
+			serve(service, connection);
+			service.disconnect(connection);
+		}).detach();
+	}
+	close(server);
+	unlink(socket_path);
+	return 1;
+#endif
+}
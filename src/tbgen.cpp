@@ -0,0 +1,45 @@
+/* Generates endgame tablebases.
+ *
+ * Every material given, e.g. KQK, KRK, KPK, KBNK or KQKR, is generated
+ * together with the smaller tables it depends on, and written into the
+ * directory as <material>.tb.  Tables that are already there are reused.
+ *
+ * usage: tbgen <material>... [-d <directory>] [-t <threads>]
+ */
+
+#include "TablebaseGenerator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+	const char *directory = ".";
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<const char *> materials;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			directory = argv[++i];
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else
+			materials.push_back(argv[i]);
+	}
+	if (materials.empty()) {
+		fprintf(stderr, "usage: %s <material>... [-d <directory>] [-t <threads>]\n", argv[0]);
+		return 1;
+	}
+
+	TablebaseGenerator generator(directory, threads);
+	for (const char *material : materials) {
+		if (!generator.generate(material)) {
+			fprintf(stderr, "can't generate %s\n", material);
+			return 1;
+		}
+	}
+	return 0;
+}
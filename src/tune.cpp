@@ -0,0 +1,433 @@
+/* Texel-style tuner for the evaluation parameters.
+ *
+ * Reads a file of labelled positions, one per line:
+ *
+ *     <fen> ... <result>
+ *
+ * or a PositionDataset, of which the records with a result are used.
+ *
+ * The move counters of the fen may be left out, as in EPD records, and
+ * anything between the fen and the result is ignored.  The result is the game
+ * outcome from white's point of view, either as "1-0", "0-1", "1/2-1/2"
+ * or as a number in brackets, e.g. "[0.5]".
+ *
+ * The rating of every position is squashed by a sigmoid and compared with
+ * the result.  The scaling constant of the sigmoid is fitted first, then
+ * the parameters are optimized with Adam on the mean squared error.  Each
+ * pass over the positions is split across all cores.  The result is written
+ * as a replacement for eval_tables.hpp.
+ *
+ * usage: tune <positions> [-o <header>] [-i <iterations>] [-t <threads>]
+ */
+
+#include "Evaluator.hpp"
+#include "PositionDataset.hpp"
+#include "fen.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const int NUM_PARAMS = 6 + 6 * 64;
+static const size_t CHUNK_SIZE = 32 << 20;
+
+/** One piece of a sample: bit 15 is set for black pieces, bits 12 to 14 hold
+ * the type and bits 0 to 5 the tile as x * 8 + y, y relative to the owner.
+ */
+typedef uint16 Feature;
+
+struct Sample {
+	/// index of the first feature
+	uint32 first;
+	/// number of features (pieces on the board)
+	uint8 count;
+	/// 0 = black won, 1 = draw, 2 = white won
+	uint8 result;
+};
+
+struct TrainingSet {
+	std::vector<Sample> samples;
+	std::vector<Feature> features;
+};
+
+static int placement_index(int type, int tile) {
+	return 6 + type * 64 + tile;
+}
+
+// PARSING
+
+/** Finds the result in the rest of a line.  Returns 0, 1 or 2 for a black
+ * win, a draw and a white win, or -1 if there is none.
+ */
+static int parse_result(const char *s, const char *end) {
+	for (; s < end; ++s) {
+		size_t left = end - s;
+		if (left >= 7 && !memcmp(s, "1/2-1/2", 7))
+			return 1;
+		if (left >= 3 && !memcmp(s, "1-0", 3))
+			return 2;
+		if (left >= 3 && !memcmp(s, "0-1", 3))
+			return 0;
+		if (*s == '[') {
+			float r = strtof(s + 1, nullptr);
+			return r < 0.25f ? 0 : r > 0.75f ? 2 : 1;
+		}
+	}
+	return -1;
+}
+
+static void extract_features(const Position &position, TrainingSet &set) {
+	Sample sample = {(uint32)set.features.size(), 0, 0};
+	for (Coord y = 0; y < 8; ++y)
+	for (Coord x = 0; x < 8; ++x) {
+		Piece p = position[Tile(x, y)];
+		if (p.type == TYPE_NONE)
+			continue;
+		int relative_y = p.player == PLAYER_BLACK ? 7 - y : y;
+		Feature f = (p.player == PLAYER_BLACK ? 0x8000 : 0) | (p.type << 12) | (x * 8 + relative_y);
+		set.features.push_back(f);
+		++sample.count;
+	}
+	set.samples.push_back(sample);
+}
+
+/** Parses all complete lines in [begin, end) into part.  Returns the number
+ * of lines that could not be parsed.
+ */
+static size_t parse_lines(const char *begin, const char *end, TrainingSet &part) {
+	Situation situation;
+	size_t errors = 0;
+	while (begin < end) {
+		const char *eol = (const char *)memchr(begin, '\n', end - begin);
+		if (!eol)
+			eol = end;
+		const char *rest = fen_parse(begin, eol, situation);
+		int result = rest ? parse_result(rest, eol) : -1;
+		if (result >= 0) {
+			extract_features(situation, part);
+			part.samples.back().result = result;
+		} else if (eol - begin > 1) {
+			++errors;
+		}
+		begin = eol + 1;
+	}
+	return errors;
+}
+
+/// appends the parts to set, in order
+static void merge(const std::vector<TrainingSet> &parts, TrainingSet &set) {
+	for (auto &part : parts) {
+		uint32 offset = set.features.size();
+		for (Sample sample : part.samples) {
+			sample.first += offset;
+			set.samples.push_back(sample);
+		}
+		set.features.insert(set.features.end(), part.features.begin(), part.features.end());
+	}
+}
+
+/// reads the labelled records of a dataset, returns false if it isn't one
+static bool load_dataset(const char *path, int threads, TrainingSet &set) {
+	PositionDataset dataset;
+	if (!dataset.open(path, MappedFile::SEQUENTIAL))
+		return false;
+
+	std::vector<TrainingSet> parts(threads);
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i) {
+		workers.emplace_back([&, i] {
+			Situation situation;
+			size_t end = dataset.size() * (i + 1) / threads;
+			for (size_t r = dataset.size() * i / threads; r < end; ++r) {
+				const PackedPosition &record = dataset[r];
+				if (record.result < -1 || record.result > 1 || !record.unpack(situation))
+					continue;
+				extract_features(situation, parts[i]);
+				parts[i].samples.back().result = record.result + 1;
+			}
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	merge(parts, set);
+	return true;
+}
+
+static bool load(const char *path, int threads, TrainingSet &set) {
+	if (load_dataset(path, threads, set))
+		return true;
+
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "cannot open %s\n", path);
+		return false;
+	}
+
+	std::vector<char> buffer(CHUNK_SIZE);
+	size_t carry = 0;
+	size_t errors = 0;
+	bool eof = false;
+	while (!eof) {
+		size_t n = fread(buffer.data() + carry, 1, buffer.size() - carry, file);
+		eof = n == 0 || feof(file);
+		size_t filled = carry + n;
+		if (filled == 0)
+			break;
+
+		// only parse complete lines, keep the tail for the next chunk
+		size_t usable = filled;
+		if (!eof) {
+			while (usable > 0 && buffer[usable - 1] != '\n')
+				--usable;
+			if (usable == 0) {
+				fprintf(stderr, "line too long in %s\n", path);
+				fclose(file);
+				return false;
+			}
+		}
+
+		// split the chunk at line boundaries, one slice per thread
+		std::vector<const char *> cuts;
+		cuts.push_back(buffer.data());
+		for (int i = 1; i < threads; ++i) {
+			const char *cut = buffer.data() + usable * i / threads;
+			cut = std::max(cut, cuts.back());
+			const char *eol = (const char *)memchr(cut, '\n', buffer.data() + usable - cut);
+			cuts.push_back(eol ? eol + 1 : buffer.data() + usable);
+		}
+		cuts.push_back(buffer.data() + usable);
+
+		std::vector<TrainingSet> parts(threads);
+		std::vector<size_t> part_errors(threads, 0);
+		std::vector<std::thread> workers;
+		for (int i = 0; i < threads; ++i) {
+			workers.emplace_back([&, i] {
+				part_errors[i] = parse_lines(cuts[i], cuts[i + 1], parts[i]);
+			});
+		}
+		for (auto &worker : workers)
+			worker.join();
+
+		merge(parts, set);
+		for (int i = 0; i < threads; ++i)
+			errors += part_errors[i];
+
+		carry = filled - usable;
+		memmove(buffer.data(), buffer.data() + usable, carry);
+	}
+	fclose(file);
+
+	if (errors)
+		fprintf(stderr, "skipped %llu lines without position or result\n", (unsigned long long)errors);
+	return true;
+}
+
+// MODEL
+
+/// rating from white's point of view, exactly like Evaluator::rate_material
+static double rate(const float *params, const Feature *f, int count) {
+	double material = 0;
+	double placement = 0;
+	for (int i = 0; i < count; ++i) {
+		double sign = f[i] & 0x8000 ? -1.0 : 1.0;
+		int type = (f[i] >> 12) & 7;
+		material += sign * params[type];
+		placement += sign * params[placement_index(type, f[i] & 63)];
+	}
+	return material + placement / count;
+}
+
+static double sigmoid(double k, double rating) {
+	return 1.0 / (1.0 + exp(-k * rating));
+}
+
+/** Computes the mean squared error over all samples.  If gradient is not
+ * null, it receives the derivative of the error by every parameter.
+ */
+static double evaluate(const TrainingSet &set, const float *params, double k,
+		int threads, double *gradient) {
+	size_t n = set.samples.size();
+	std::vector<double> errors(threads, 0.0);
+	std::vector<std::vector<double>> gradients(threads);
+
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			size_t begin = n * t / threads;
+			size_t end = n * (t + 1) / threads;
+			double error = 0;
+			std::vector<double> &g = gradients[t];
+			if (gradient)
+				g.assign(NUM_PARAMS, 0.0);
+			for (size_t i = begin; i < end; ++i) {
+				const Sample &s = set.samples[i];
+				const Feature *f = &set.features[s.first];
+				double target = s.result * 0.5;
+				double predicted = sigmoid(k, rate(params, f, s.count));
+				double diff = target - predicted;
+				error += diff * diff;
+				if (!gradient)
+					continue;
+				double d = -2.0 * diff * predicted * (1.0 - predicted) * k;
+				for (int j = 0; j < s.count; ++j) {
+					double sign = f[j] & 0x8000 ? -d : d;
+					int type = (f[j] >> 12) & 7;
+					g[type] += sign;
+					g[placement_index(type, f[j] & 63)] += sign / s.count;
+				}
+			}
+			errors[t] = error;
+		});
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	double error = 0;
+	for (int t = 0; t < threads; ++t)
+		error += errors[t];
+	if (gradient) {
+		for (int i = 0; i < NUM_PARAMS; ++i) {
+			gradient[i] = 0;
+			for (int t = 0; t < threads; ++t)
+				gradient[i] += gradients[t][i];
+			gradient[i] /= n;
+		}
+	}
+	return error / n;
+}
+
+/// golden section search for the sigmoid scale with the lowest error
+static double fit_scale(const TrainingSet &set, const float *params, int threads) {
+	const double phi = (sqrt(5.0) - 1) / 2;
+	double a = 0.01, b = 10.0;
+	double c = b - phi * (b - a);
+	double d = a + phi * (b - a);
+	double fc = evaluate(set, params, c, threads, nullptr);
+	double fd = evaluate(set, params, d, threads, nullptr);
+	while (b - a > 1e-3) {
+		if (fc < fd) {
+			b = d; d = c; fd = fc;
+			c = b - phi * (b - a);
+			fc = evaluate(set, params, c, threads, nullptr);
+		} else {
+			a = c; c = d; fc = fd;
+			d = a + phi * (b - a);
+			fd = evaluate(set, params, d, threads, nullptr);
+		}
+	}
+	return (a + b) / 2;
+}
+
+// OUTPUT
+
+static bool write_header(const char *path, const float *params) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		fprintf(stderr, "cannot write %s\n", path);
+		return false;
+	}
+
+	fprintf(file, "#ifndef EVAL_TABLES_HPP\n#define EVAL_TABLES_HPP\n\n");
+	fprintf(file, "/* Material values and placement ratings used by the Evaluator.\n");
+	fprintf(file, " *\n");
+	fprintf(file, " * PIECE_VALUES is indexed by Type, PIECE_POS_RATINGS by [Type][x][y] with y\n");
+	fprintf(file, " * counted from the owner's home row.  This file can be regenerated from a\n");
+	fprintf(file, " * set of labelled positions with the tuner (tune.cpp).\n");
+	fprintf(file, " */\n\n");
+
+	fprintf(file, "static const float PIECE_VALUES[6] = { ");
+	for (int type = 0; type < 6; ++type)
+		fprintf(file, "%s%.3f", type ? ", " : "", params[type]);
+	fprintf(file, " };\n");
+
+	fprintf(file, "static const float PIECE_POS_RATINGS[6][8][8] = {\n");
+	for (int type = 0; type < 6; ++type) {
+		fprintf(file, type == 0 ? "\t\t{\n" : "\t\t}, {\n");
+		for (int x = 0; x < 8; ++x) {
+			fprintf(file, "\t\t\t\t{");
+			for (int y = 0; y < 8; ++y)
+				fprintf(file, "%s%.3f", y ? ", " : "", params[placement_index(type, x * 8 + y)]);
+			fprintf(file, "},\n");
+		}
+	}
+	fprintf(file, "\t\t}\n};\n\n#endif // EVAL_TABLES_HPP\n");
+
+	return fclose(file) == 0;
+}
+
+// MAIN
+
+int main(int argc, char **argv) {
+	const char *input = nullptr;
+	const char *output = "eval_tables.hpp";
+	int iterations = 500;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			output = argv[++i];
+		else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!input)
+			input = argv[i];
+		else
+			input = nullptr, i = argc;
+	}
+	if (!input) {
+		fprintf(stderr, "usage: %s <positions> [-o <header>] [-i <iterations>] [-t <threads>]\n", argv[0]);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	TrainingSet set;
+	if (!load(input, threads, set))
+		return 1;
+	if (set.samples.empty()) {
+		fprintf(stderr, "no labelled positions in %s\n", input);
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("loaded %llu positions in %.1f s\n", (unsigned long long)set.samples.size(), seconds);
+
+	float params[NUM_PARAMS];
+	EvalParams initial = EvalParams::standard();
+	for (int type = 0; type < 6; ++type) {
+		params[type] = initial.piece_values[type];
+		for (int x = 0; x < 8; ++x)
+		for (int y = 0; y < 8; ++y)
+			params[placement_index(type, x * 8 + y)] = initial.piece_pos_ratings[type][x][y];
+	}
+
+	double k = fit_scale(set, params, threads);
+	printf("sigmoid scale: %.4f, initial error: %.6f\n", k, evaluate(set, params, k, threads, nullptr));
+
+	// Adam, the king's material value stays fixed because it always cancels out
+	const double rate = 0.01, beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+	std::vector<double> gradient(NUM_PARAMS), m(NUM_PARAMS, 0.0), v(NUM_PARAMS, 0.0);
+	for (int it = 1; it <= iterations; ++it) {
+		double error = evaluate(set, params, k, threads, gradient.data());
+		for (int i = TYPE_KING + 1; i < NUM_PARAMS; ++i) {
+			m[i] = beta1 * m[i] + (1 - beta1) * gradient[i];
+			v[i] = beta2 * v[i] + (1 - beta2) * gradient[i] * gradient[i];
+			double m_hat = m[i] / (1 - pow(beta1, it));
+			double v_hat = v[i] / (1 - pow(beta2, it));
+			params[i] -= rate * m_hat / (sqrt(v_hat) + epsilon);
+		}
+		if (it % 10 == 0 || it == iterations)
+			printf("iteration %4d, error: %.6f\n", it, error);
+	}
+
+	printf("final error: %.6f\n", evaluate(set, params, k, threads, nullptr));
+	if (!write_header(output, params))
+		return 1;
+	printf("written %s\n", output);
+	return 0;
+}
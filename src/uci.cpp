@@ -0,0 +1,372 @@
+/* A UCI engine around SpeedyBot, for tournament managers and headless
+ * servers.  Commands are read from stdin, one per line, and the search
+ * runs in a thread of its own, so "stop" and "isready" are answered while
+ * it thinks.
+ *
+ * Supported are uci, isready, ucinewgame, setoption (Hash, Threads,
+ * MultiPV, SyzygyPath and SyzygyProbe), position [startpos | fen <fen>]
+ * [moves <move>...], go [depth | nodes | movetime | wtime | btime | winc |
+ * binc | movestogo | infinite], stop and quit.  With more than one thread,
+ * helper bots search the same position and share the transposition table
+ * with the main one.  The tables of SyzygyPath are only probed once
+ * SyzygyProbe is set, see SpeedyBot::set_syzygy_probing.
+ *
+ * usage: chess-uci
+ */
+
+#include "Rules.hpp"
+#include "SpeedyBot.hpp"
+#include "fen.hpp"
+#include "lan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int DEFAULT_HASH = 16;
+static const int MAX_HASH = 4096;
+static const int MAX_THREADS = 64;
+static const int MAX_MULTIPV = 64;
+static const int MAX_PLIES = 64;
+/// kept back from the clock for the communication with the GUI
+static const int MOVE_OVERHEAD = 30;
+/// the number of moves the clock is split over without movestogo
+static const int DEFAULT_MOVES_TO_GO = 30;
+
+static std::mutex output_mutex;
+
+static void send(const std::string &line) {
+	std::lock_guard<std::mutex> lock(output_mutex);
+	fputs(line.c_str(), stdout);
+	fputc('\n', stdout);
+	fflush(stdout);
+}
+
+static std::string lower(std::string s) {
+	std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+	return s;
+}
+
+static std::string score_string(float rating) {
+	ReportedScore score = ReportedScore::from_rating(rating);
+	return (score.mate ? "mate " : "cp ") + std::to_string(score.value);
+}
+
+class Engine {
+public:
+	Engine();
+	~Engine();
+
+	/// handles one line, returns false on quit
+	bool command(const std::string &line);
+
+private:
+	void set_option(const std::string &name, const std::string &value);
+	void position(std::istringstream &);
+	void go(std::istringstream &);
+
+	void search(SearchLimits, bool infinite);
+	void stop();
+
+	/// brings a bot to the position of the last position command
+	void setup(SpeedyBot &);
+	void resize_bots(int count);
+
+	Situation _start;
+	std::vector<Action> _moves;
+	Game _game;
+
+	std::shared_ptr<TranspositionTable> _tt;
+	std::shared_ptr<SyzygyTablebase> _syzygy;
+	bool _syzygy_probing = false;
+	/// the first one is the main bot, the others help
+	std::vector<std::unique_ptr<SpeedyBot>> _bots;
+
+	std::thread _search_thread;
+	std::atomic<bool> _stop{false};
+	std::atomic<bool> _helpers_stop{false};
+	/// an infinite search waits for stop before it answers
+	std::mutex _stop_mutex;
+	std::condition_variable _stop_signal;
+};
+
+Engine::Engine() :
+	_tt(std::make_shared<TranspositionTable>(((size_t)DEFAULT_HASH << 20) / TranspositionTable::SLOT_SIZE))
+{
+	fen_parse(FEN_STANDARD, _start);
+	_game.reset(_start);
+	resize_bots(1);
+}
+
+Engine::~Engine() {
+	stop();
+}
+
+void Engine::resize_bots(int count) {
+	while ((int)_bots.size() > count)
+		_bots.pop_back();
+	while ((int)_bots.size() < count) {
+		std::unique_ptr<SpeedyBot> bot(new SpeedyBot());
+		bot->set_verbose(false);
+		bot->set_transposition_table(_tt);
+		bot->set_syzygy(_syzygy);
+		bot->set_syzygy_probing(_syzygy_probing);
+		bot->set_stop_flag(_bots.empty() ? &_stop : &_helpers_stop);
+		_bots.push_back(std::move(bot));
+	}
+}
+
+void Engine::setup(SpeedyBot &bot) {
+	bot.reset(_start);
+	for (auto &action : _moves)
+		bot.update(action);
+}
+
+bool Engine::command(const std::string &line) {
+	std::istringstream in(line);
+	std::string token;
+	in >> token;
+
+	if (token == "uci") {
+		send("id name SpeedyBot");
+		send("id author the chess authors");
+		send("option name Hash type spin default " + std::to_string(DEFAULT_HASH)
+				+ " min 1 max " + std::to_string(MAX_HASH));
+		send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+		send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTIPV));
+		send("option name SyzygyPath type string default <empty>");
+		send("option name SyzygyProbe type check default false");
+		send("uciok");
+	} else if (token == "isready") {
+		send("readyok");
+	} else if (token == "setoption") {
+		// setoption name <name> [value <value>], names may have spaces
+		std::string name, value, word;
+		std::string *field = nullptr;
+		while (in >> word) {
+			if (word == "name")
+				field = &name;
+			else if (word == "value")
+				field = &value;
+			else if (field)
+				*field += (field->empty() ? "" : " ") + word;
+		}
+		stop();
+		set_option(lower(name), value);
+	} else if (token == "ucinewgame") {
+		stop();
+		_tt->clear();
+	} else if (token == "position") {
+		stop();
+		position(in);
+	} else if (token == "go") {
+		stop();
+		go(in);
+	} else if (token == "stop") {
+		stop();
+	} else if (token == "quit") {
+		stop();
+		return false;
+	}
+	return true;
+}
+
+void Engine::set_option(const std::string &name, const std::string &value) {
+	if (name == "hash") {
+		int megabytes = std::min(std::max(atoi(value.c_str()), 1), MAX_HASH);
+		_tt->resize(((size_t)megabytes << 20) / TranspositionTable::SLOT_SIZE);
+	} else if (name == "threads") {
+		resize_bots(std::min(std::max(atoi(value.c_str()), 1), MAX_THREADS));
+	} else if (name == "multipv") {
+		// the helpers only fill the table, one line is enough for them
+		_bots[0]->set_multipv(std::min(std::max(atoi(value.c_str()), 1), MAX_MULTIPV));
+	} else if (name == "syzygypath") {
+		_syzygy.reset();
+		if (!value.empty() && value != "<empty>") {
+			_syzygy = std::make_shared<SyzygyTablebase>();
+			int found = _syzygy->open(value.c_str());
+			send("info string " + std::to_string(found) + " Syzygy tables found");
+		}
+		for (auto &bot : _bots)
+			bot->set_syzygy(_syzygy);
+	} else if (name == "syzygyprobe") {
+		_syzygy_probing = lower(value) == "true";
+		for (auto &bot : _bots)
+			bot->set_syzygy_probing(_syzygy_probing);
+	} else {
+		send("info string unknown option " + name);
+	}
+}
+
+void Engine::position(std::istringstream &in) {
+	std::string token;
+	in >> token;
+	Situation start;
+	if (token == "startpos") {
+		fen_parse(FEN_STANDARD, start);
+		in >> token;
+	} else if (token == "fen") {
+		std::string fen, field;
+		while (in >> field && field != "moves")
+			fen += (fen.empty() ? "" : " ") + field;
+		if (!fen_parse(fen.c_str(), start)) {
+			send("info string invalid fen " + fen);
+			return;
+		}
+		token = field;
+	} else {
+		return;
+	}
+
+	// the moves are checked before anything is replaced
+	Game game(start);
+	std::vector<Action> moves;
+	if (token == "moves") {
+		while (in >> token) {
+			Action action;
+			const char *message = lan_parse(game.current_situation(), token.data(), token.data() + token.size(), action);
+			if (message) {
+				send("info string " + token + ": " + message);
+				return;
+			}
+			game.action(action);
+			moves.push_back(action);
+		}
+	}
+	_start = start;
+	_moves = moves;
+	_game.reset(start);
+	for (auto &action : moves)
+		_game.action(action);
+}
+
+void Engine::go(std::istringstream &in) {
+	SearchLimits limits;
+	bool infinite = false;
+	int time = -1, increment = 0, moves_to_go = 0;
+	Player player = _game.current_situation().active_player();
+	std::string token;
+	while (in >> token) {
+		long long value = 0;
+		if (token != "infinite" && token != "ponder")
+			in >> value;
+		if (token == "depth")
+			limits.depth = std::min(std::max((int)value, 1), MAX_PLIES);
+		else if (token == "nodes")
+			limits.nodes = std::max(value, 1LL);
+		else if (token == "movetime")
+			limits.movetime = std::max((int)value - MOVE_OVERHEAD, 1);
+		else if ((token == "wtime" && player == PLAYER_WHITE) || (token == "btime" && player == PLAYER_BLACK))
+			time = (int)value;
+		else if ((token == "winc" && player == PLAYER_WHITE) || (token == "binc" && player == PLAYER_BLACK))
+			increment = (int)value;
+		else if (token == "movestogo")
+			moves_to_go = (int)value;
+		else if (token == "infinite")
+			infinite = true;
+	}
+
+	if (time >= 0 && limits.movetime == 0) {
+		// an even share of the clock plus most of the increment, but never
+		// more than half of what is left
+		int share = time / (moves_to_go > 0 ? moves_to_go : DEFAULT_MOVES_TO_GO) + increment * 3 / 4;
+		limits.movetime = std::max(std::min(share, time / 2) - MOVE_OVERHEAD, 1);
+	}
+	if (limits.depth == 0 && limits.nodes == 0 && limits.movetime == 0)
+		infinite = true;
+	if (limits.depth == 0)
+		limits.depth = MAX_PLIES;
+
+	_stop = false;
+	_helpers_stop = false;
+	_search_thread = std::thread(&Engine::search, this, limits, infinite);
+}
+
+void Engine::search(SearchLimits limits, bool infinite) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> helpers;
+	for (size_t i = 1; i < _bots.size(); ++i) {
+		SpeedyBot *bot = _bots[i].get();
+		setup(*bot);
+		bot->set_limits(limits);
+		bot->set_info_callback(nullptr);
+		helpers.emplace_back([bot]() {
+			bot->next_action();
+		});
+	}
+
+	SpeedyBot &bot = *_bots[0];
+	setup(bot);
+	bot.set_limits(limits);
+	std::vector<Action> pv;
+	bot.set_info_callback([&](const SearchInfo &info) {
+		pv = info.pv;
+		uint64 nodes = info.nodes;
+		for (size_t i = 0; i < info.lines.size(); ++i) {
+			std::ostringstream line;
+			line << "info depth " << info.depth << " multipv " << i + 1 << " score " << score_string(info.lines[i].score)
+					<< " nodes " << nodes << " nps " << (uint64)(nodes / std::max(info.seconds, 1e-3))
+					<< " time " << (int)(info.seconds * 1000) << " hashfull " << _tt->hashfull() << " pv";
+			for (auto &action : info.lines[i].pv)
+				line << " " << lan_string(action);
+			send(line.str());
+		}
+	});
+
+	Action best;
+	bool has_move = !Rules().getAllLegalMoves(_game.current_situation()).empty();
+	if (has_move)
+		best = bot.next_action();
+
+	_helpers_stop = true;
+	for (auto &helper : helpers)
+		helper.join();
+
+	// an infinite search must not answer before it is told to stop
+	if (infinite) {
+		std::unique_lock<std::mutex> lock(_stop_mutex);
+		_stop_signal.wait(lock, [this]() { return _stop.load(); });
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint64 nodes = bot.stats().total_nodes();
+	send("info nodes " + std::to_string(nodes) + " time " + std::to_string((int)(seconds * 1000)));
+	if (!has_move)
+		send("bestmove 0000");
+	else if (pv.size() >= 2 && pv[0] == best)
+		send("bestmove " + lan_string(best) + " ponder " + lan_string(pv[1]));
+	else
+		send("bestmove " + lan_string(best));
+}
+
+void Engine::stop() {
+	{
+		std::lock_guard<std::mutex> lock(_stop_mutex);
+		_stop = true;
+	}
+	_stop_signal.notify_all();
+	if (_search_thread.joinable())
+		_search_thread.join();
+}
+
+int main() {
+	Engine engine;
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!engine.command(line))
+			break;
+	}
+	return 0;
+}
@@ -1,213 +1,215 @@
 #include "zobrist.hpp"
 #include "Board.hpp"
 
-static const uint32 zobrist_constants_piece_tile[] = {
-	0x6D54A9CB, 0xEA86D7AB, 0x9C8FAB29, 0x55BC8535,
-	0x297D5234, 0xBBE88EC0, 0x2AB9BE56, 0xBE97B0AE,
-	0x6706BBAF, 0xF2306604, 0x41589F40, 0xEA5C55DC,
-	0x78B0D844, 0x2B814A8A, 0xAEAAEABC, 0x6A349465,
-	0xAE1A7442, 0x8DE72270, 0xC1C3145F, 0x662C9E9B,
-	0x91A0637E, 0x3D409559, 0x109D8CB9, 0x0690A394,
-	0x42E31338, 0x0F0111D1, 0x01E69BBC, 0xB2DDF925,
-	0x323C2FB4, 0x2F53BA7A, 0xDBF1BA7B, 0x5F7F0B6F,
-	0x1BE69CE6, 0x67460175, 0xC140D9CB, 0x8784F04B,
-	0x3769598A, 0x1E66AF95, 0xAAD2A288, 0x4060A851,
-	0x7B93279E, 0x7EECF217, 0x7A55CDB0, 0x32A5DDC2,
-	0x9F065233, 0xADA13A72, 0xC2F6F885, 0x0307DCCC,
-	0xD46AB0E3, 0x36232C5D, 0x81DCB29E, 0x3E6631BB,
-	0x47EAA372, 0x486A7DD9, 0x8FC259B6, 0x6850B5D6,
-	0x3F1DBD76, 0x5DD497FF, 0x6140AF0F, 0x868619A8,
-	0x8C2B0B56, 0xB828E6A4, 0xC5DF7E54, 0xF7E7B513,
-	0x97CD107A, 0x111D5A88, 0x5D020A28, 0x4C5DACAB,
-	0x11443A16, 0x5874AE87, 0xD2BC7584, 0x110D2733,
-	0xA5E088F7, 0xC6B3D4B3, 0xD879007D, 0xA0AEE837,
-	0xDF2E2D67, 0xFBCF3897, 0x217B7530, 0x0DAA8BE5,
-	0x4EA0C2A5, 0x7740C936, 0x58BA2B4C, 0x8D198599,
-	0x92AB84D0, 0x6155EFFA, 0xD115095E, 0xBCBB13CA,
-	0xF75FF149, 0x4C10F2A5, 0x121CFD35, 0x1A843BA5,
-	0x2F1D23A7, 0xC1542638, 0x6E768362, 0xC443A19D,
-	0xBAE9F8DF, 0xD3E702BA, 0x753C7C5E, 0x511B3D90,
-	0x25E6B00F, 0x48AC7C1A, 0xC3406B7C, 0x2B6D5CF9,
-	0x0CEB9D51, 0x15247382, 0xF1039104, 0xBEF2600A,
-	0x581F838B, 0xB0FED6E4, 0xBB2B912B, 0x42396861,
-	0x239AEC3F, 0xE3ED8051, 0x0AFE9E39, 0xDE23E61A,
-	0x3E1E10AF, 0x0A341DA7, 0x1B909D9D, 0x92B2CCCE,
-	0x89C845AA, 0x1CD64D72, 0x85B70E53, 0x8C4C2BDB,
-	0xEDF4995F, 0x63C79DD4, 0x13A8539D, 0xE3F69056,
-	0x8058BF26, 0xB5F5E7C7, 0xCB7D7C5C, 0x6A43277D,
-	0x194E2E7D, 0x357E8B54, 0x04FD7A6C, 0xD8665A39,
-	0xE77D53AA, 0x2B3891AF, 0xC3C428F7, 0xD79A81A4,
-	0xE2A19883, 0xA2818C44, 0x24EA2F5E, 0xA61EEE50,
-	0x73B5E557, 0x2816C83D, 0x0C3D1535, 0xF2F01F49,
-	0x6C17B1AD, 0xD005957F, 0xE4E37084, 0x60BD7479,
-	0x294E0478, 0x7DBC60F7, 0x1D8CA50D, 0x466745B3,
-	0xE60019C9, 0x059AC0C7, 0xBC13D8BF, 0xDEBB9D49,
-	0xD9A8B189, 0x80F714F1, 0x9B06A926, 0xF912A10A,
-	0x270E59BB, 0x34D41D31, 0x0F54F374, 0x29F0DDA9,
-	0x9F8AF060, 0x3C571F74, 0x77F39359, 0xD0E3363C,
-	0x062C661F, 0x6DE9C404, 0x107581FD, 0x306F1C81,
-	0xCD105279, 0x8AA1ACC7, 0xFE7F2472, 0xF06090E7,
-	0x6B2041CE, 0x1DB89B2F, 0x874253C6, 0x58DF2AF5,
-	0xCBE81489, 0x255233A9, 0x2B9A018C, 0xDB51B892,
-	0xA1BD0D11, 0x05DC108B, 0x17C1CD15, 0xBDCE132C,
-	0x9E50CC1F, 0x49519ABB, 0x82593306, 0xEF803AD6,
-	0xFCE7E12D, 0x686A0662, 0x153CD6F0, 0xA6B35CF3,
-	0x1C98F61D, 0x6887BA47, 0x4985E3AD, 0x88F23226,
-	0xF111AD27, 0xDFCF856B, 0xBC86AAC8, 0x2CBBE1BF,
-	0x110D8FEC, 0xC881EB4F, 0x0C2602A2, 0xF78D9430,
-	0x3D3713BA, 0x3396206A, 0x52765BD0, 0x1556BB7B,
-	0x3E3BE1DF, 0xD131732A, 0x3FDC3E62, 0x6F2E4A79,
-	0x0C17A5FA, 0xC6C1A938, 0x52AA0014, 0x3047CB12,
-	0x6DA90BDC, 0x37CAE109, 0x9AEF6683, 0xD1F8469A,
-	0x6E3D8246, 0x88D33DB1, 0x9C8A6FD5, 0xBFE0BC4D,
-	0x76D60E21, 0xF9E37420, 0x6C5F9E9A, 0xC75DD9AC,
-	0x86E56E12, 0x15805293, 0x5039BCB3, 0xDFD18154,
-	0x5178DFDA, 0x332D557A, 0x0645A239, 0xE005DF33,
-	0xBE0EA7E0, 0xD3C122AF, 0xEDE1A3CE, 0x85A0E7DA,
-	0x59F72862, 0x99CA5C27, 0x883847D4, 0x187B5DE8,
-	0xB61C7AC0, 0x87EFD4D9, 0x1DF0F789, 0x7D30FC62,
-	0xED096493, 0xDC39112A, 0x2E1FE988, 0xA4D966DB,
-	0xD9570B56, 0x303F240F, 0x14153B94, 0xC442AB1A,
-	0xFA9EDE78, 0x1507A9DE, 0xDF19EE4E, 0xF590EB7E,
-	0xC37FCC44, 0x2D507397, 0x57DB5C6E, 0x8B86C73B,
-	0x28ABD43F, 0xEAE2CB68, 0x3E455987, 0x0798FA2B,
-	0x19E89C05, 0xAB2814D5, 0xF9EAA07E, 0x403B9CD8,
-	0xB29831C2, 0x685EA58F, 0xEFCB0407, 0x9D8000BB,
-	0xE6A37070, 0x904EA5D1, 0x68F91E20, 0xF7DBBEAC,
-	0xB0838FB2, 0x0D6D5705, 0xAC15CD43, 0x85CFB5CE,
-	0xC5F239DD, 0x443D68AC, 0xC227E4CB, 0x7D99AD63,
-	0xBA20E768, 0x2FA9AEF7, 0xF622636C, 0xBBEF0897,
-	0x0CC5DE25, 0xF7971397, 0xE252B040, 0x954F1A7B,
-	0xA20198E0, 0x001D9AC0, 0xDE215E2C, 0x2893ED18,
-	0xD3933B17, 0xEE1CAB68, 0x52D9FBC3, 0xC77E2EA0,
-	0x5FB2DECC, 0x7E0E4FA2, 0x0A269723, 0xD2E6C7AF,
-	0x32D887D7, 0xF82C0AF8, 0x835ACDE0, 0xA2C97D38,
-	0xCB8A8D9A, 0xD82D8124, 0xCB978C0D, 0x64EF21E7,
-	0x9855C82E, 0x798EE8A8, 0xF14D2EC8, 0xA833736E,
-	0x3D56A09C, 0xBD26E212, 0x10A1D2F6, 0x831C2F3F,
-	0x322E9F2A, 0x4F522C8A, 0xEF6CF793, 0xFE8B494D,
-	0x5785E574, 0x94EC755F, 0x221A043B, 0xF4FAFD51,
-	0x882B75DA, 0x6C6561CA, 0x562B589B, 0xE20F4DB1,
-	0xD6CB5E4A, 0x1500A1A5, 0xD5F10036, 0xC9C63FEE,
-	0xE2E5AF45, 0x89077760, 0xFA0E02F6, 0x6E6DAB3F,
-	0x005FFB44, 0xC535A996, 0xF2708E62, 0xE2A97A26,
-	0x56F6B6C6, 0x08882CEA, 0x392C6130, 0xD385A39D,
-	0xAB0A729A, 0x9345E9E4, 0x7D76A7D0, 0xCD9BC927,
-	0x295138D9, 0xDF28CC39, 0x0CFF73E1, 0xEE6ED032,
-	0x3EA3C916, 0x07FFEE4C, 0x07A8F6C1, 0x8327A7D3,
-	0x2F14D9B4, 0x8FE8F8BE, 0xCEF0DBCD, 0x56BDD88D,
-	0x24C3CCBC, 0xB13BDC6E, 0x5ADAF971, 0xDD666275,
-	0xB61EA412, 0x4EF0A732, 0xDD54AC15, 0x83D5EE46,
-	0xC3500B1A, 0xD60256D0, 0x50F29722, 0xD52F70C8,
-	0xFC66262A, 0x7554C7C0, 0x2376D47F, 0x1E0B03AE,
-	0x1268FBF9, 0x1A2CC007, 0x807B396B, 0xDE97A0CB,
-	0xEB884A69, 0x96DEA2E7, 0x08A4390C, 0x8DD71421,
-	0xB4727098, 0xE8CA87B2, 0x9F5F8DD8, 0x2A51E1ED,
-	0xBBD4959E, 0xE78B655F, 0xC0C10370, 0x4B4661DF,
-	0x5D89533D, 0x3D005254, 0xCBAA5D51, 0x5B1E1C0E,
-	0x1919173A, 0x483E2A1F, 0xBC6A87A6, 0x91EB7734,
-	0x44CB93E2, 0x4A2169AB, 0x4DEF70D9, 0x196E1E7A,
-	0x261BC3FC, 0x81602AFA, 0x18E27FCD, 0x9DD13423,
-	0xB7DF48FD, 0x735A4DA2, 0x2FBFB29B, 0x223A05C8,
-	0xDF597C5B, 0xF7C2C976, 0x86D115C0, 0x3AFC6E5B,
-	0x46949FEF, 0x8962C8E0, 0x6D56566A, 0x87F0E119,
-	0xB75D18D2, 0x785B323C, 0xB7E5C822, 0x849810E3,
-	0xE7FA7E83, 0x64DD2DD1, 0x3EAE2687, 0x53159A99,
-	0x9D768BA2, 0xDE2BBBE0, 0xFF7D392A, 0x8C9169A0,
-	0x3E4E27A3, 0x253D1EA2, 0x64B9D504, 0x62AA24ED,
-	0x386F263F, 0xA7DED9D6, 0xA7368AE7, 0xD51261BA,
-	0xEB4E68BE, 0x1FABEF23, 0x991FC73A, 0xC6F2E4A8,
-	0xF333F0E2, 0xBD65CDC2, 0x5E92F528, 0x5123F8A9,
-	0x5EC4D595, 0x5D4B6D21, 0xD933DA1B, 0x402AEFEE,
-	0x10A5321B, 0x789DE1F6, 0xF6493808, 0x4495D77F,
-	0x5EDD8777, 0x0174865B, 0x71A257D2, 0x9FABB6B1,
-	0x28C3ACE2, 0xC526E6F4, 0x3B96F664, 0x51FE71C4,
-	0xE64669C4, 0xF0ACA70A, 0x9CE080F9, 0x1638378E,
-	0x0D4BBBB5, 0x6C566B73, 0x2AEBE6A1, 0x31E14D60,
-	0x5F9D820E, 0x067CF4D8, 0xC658BDAB, 0xA67EC064,
-	0x8BB15F80, 0x902A4A80, 0x1C532DD8, 0x6A7DE6F6,
-	0x46DCE802, 0x2DED2077, 0x8470ABED, 0x4FF3815D,
-	0x60E590BA, 0x72F1F4CA, 0x7981E858, 0xC3ECF6CA,
-	0x69A0D52B, 0x83F4965C, 0x2B781953, 0xCE765686,
-	0xE38DE5D6, 0xDEAB95EB, 0x06962231, 0x777DBBF8,
-	0x8CBA4BC0, 0x651D614C, 0x0E2F82A6, 0x5F081433,
-	0xE9B952E7, 0x9DDEB0B1, 0xF8B9A780, 0xB7A603F9,
-	0x5582F31A, 0x3CD46135, 0x5BB25410, 0xB1CB836B,
-	0x8CD79783, 0x0D281F8F, 0x94A88375, 0x96793874,
-	0x63E3FCBC, 0x244578AE, 0x7C306D01, 0x0B2052FE,
-	0x31E8FEAE, 0xE154A977, 0x9BDD8D27, 0x3403E0DB,
-	0x261E7A7F, 0x6BB6E07D, 0xC14A599D, 0xAC289F4B,
-	0x628510EC, 0xD56DE318, 0x718701CE, 0x62FBD3FE,
-	0x64EF12EA, 0x4C72999D, 0xA0752595, 0x48DC1C33,
-	0x1A8F4E97, 0xE5D181BC, 0xCBC7E40F, 0x701BE484,
-	0x9EC323DD, 0xA2D0DE99, 0x5A2F6238, 0x4A53C997,
-	0x4EB15879, 0x6A997D5D, 0xD6895C31, 0x2DF02CE7,
-	0xE0303BE9, 0x8B26ECC6, 0x51CCD4D9, 0x6CC937D9,
-	0x3F58051E, 0xE6ECC894, 0xB6F5A24C, 0x9E93827F,
-	0x4D6AE59F, 0x0BE8D544, 0x9882D3F9, 0x69D7AB88,
-	0x128F7107, 0x1B2CA610, 0x010E8EEF, 0x6A26E2E2,
-	0xD6261488, 0xDF4A0118, 0x4DA0E351, 0x9AE169A4,
-	0x332DF809, 0x3ADAFA47, 0x667BC6CC, 0x89076F3C,
-	0xB2C1BC19, 0x08BF6ED4, 0xBE0EC948, 0x471135D7,
-	0x5755E0D8, 0x409E09E7, 0x87F27EF4, 0xC3513ECB,
-	0xA35E3DE8, 0x38701C3F, 0x9D52EC09, 0xE8E4D87B,
-	0xBA114979, 0x2EF01F18, 0x60DFFAC4, 0x39033D1A,
-	0x01EFD316, 0x8DFDBA24, 0x6C0971A8, 0xECAB33E7,
-	0xA5F20F52, 0xDD259F4C, 0x464E834C, 0x932D5508,
-	0x755EC76B, 0xAB9ECD9E, 0x1EB1E804, 0x0EFA4D25,
-	0x09BC2482, 0x6BA6EC50, 0x37161E85, 0x18016DA3,
-	0x2983624A, 0x70C913B7, 0xE5A584F3, 0x52D26268,
-	0xB478DFE1, 0x6C623ABD, 0xE8327EAE, 0x790BE9A8,
-	0x6BB87760, 0x7B2B1C0A, 0x3BCC55CA, 0x375B7B0C,
-	0x322E5456, 0xC26C68A5, 0x6C72EF39, 0x8A5E8054,
-	0xE6D35BCA, 0x25A60C71, 0x6C7F07D9, 0x09403372,
-	0x3C0D61C7, 0x73FF2AF1, 0x2DAA33B3, 0x953A90EA,
-	0xAB5E2742, 0xE8A53BC6, 0xEA4A5853, 0x74978806,
-	0x917F1E33, 0x953FFF97, 0xAD9635AE, 0xB7AB47C5,
-	0x3789FED8, 0x4F5B79DB, 0xBFC5669A, 0x8D59E990,
-	0x0E9E518F, 0x894EB51D, 0xF739B982, 0x08BF4B6B,
-	0xC5D16929, 0x4957B9F0, 0x140C8049, 0x256F982E,
-	0xA7FA24F2, 0xB0EC99C6, 0x32CB77A1, 0x4BA310EE,
-	0x67857FBE, 0x75EB4C58, 0x04079043, 0x836A0BB6,
-	0x56398670, 0x98331150, 0xB3302FA7, 0xF67CFF5B,
-	0xBB8B8265, 0x2B2FCBB6, 0xC9E5509F, 0xF93043CF,
-	0x7418D8C5, 0xF945C532, 0x399165AD, 0xC4BAAC26,
-	0x2554C97E, 0x42E158F4, 0x7614CF70, 0x2A1F044D,
-	0x6BB53DD8, 0xDE436095, 0xCEB4B279, 0x9D539B25,
-	0x0600CEE7, 0xCD8EFA04, 0xAD603F3B, 0x858BDA93,
-	0x3EC5A464, 0x2DA53EC1, 0xF2262268, 0x5026F49E,
-	0x68D6C82A, 0x337523F6, 0x9B457F5F, 0xD405319E,
-	0x9778A751, 0x6BBD28AA, 0x1F38BBB5, 0x004309EA,
-	0xBC9E7F76, 0xAFAB53D2, 0xFB8193CD, 0x7044AD56,
-	0x05521F5E, 0x34295F55, 0x025A4362, 0x1A5F055F,
-	0x784F6FC9, 0x61AE3C3C, 0x3DAA0B27, 0x8184B112,
-	0xC99D38D2, 0xB421E1A9, 0x15947EE7, 0xE09CF015,
-	0x61DD2BA5, 0x0F865F0A, 0x1E89BA34, 0xEF69B266,
-	0x1D4FAE86, 0x0A9EE1F4, 0x545AE17C, 0x0609F98B,
-	0x0742448E, 0x9E464F6C, 0xEDFD1767, 0xAFB8F0C1,
-	0xFF4EF546, 0x1BDF79AE, 0x57314DD1, 0x8FA55041,
-	0x61BA7E9F, 0xF47C95FA, 0x65E9C630, 0xC9193ABA,
-	0x3B52737B, 0x758DCD86, 0x2CB76992, 0xF11F41A3,
-	0xEACB9B68, 0x2025429C, 0x95164A80, 0x6D0BB54F,
-	0x26C8F99F, 0xC842A2C2, 0xAF3812A6, 0xFD7B9A97,
-	0xD7B03E8C, 0xB10D3C39, 0xE7F31F63, 0x8C57F97A,
-	0x169482AD, 0xA16AD3EF, 0x6CA95606, 0x8C93D772,
-	0xC6314981, 0x7C4A332E, 0x6E1B7A30, 0x6B8794BD
+// one entry per piece (12) and tile (64)
+static const uint64 zobrist_constants_piece_tile[12 * 64] = {
+	0x559F73996D54A9CB, 0xBFD5496FEA86D7AB, 0x8F9846729C8FAB29, 0x1439702255BC8535,
+	0xB0DC0083297D5234, 0x9F7DEA79BBE88EC0, 0x280450C32AB9BE56, 0xD884CC54BE97B0AE,
+	0x348DD30D6706BBAF, 0xB395975EF2306604, 0x65795FE241589F40, 0xCC6F4D6EEA5C55DC,
+	0xF7FDAF7B78B0D844, 0xFCFD76892B814A8A, 0xB23E918AAEAAEABC, 0x5FB9C6E46A349465,
+	0xC5CC6C17AE1A7442, 0xC5347B128DE72270, 0xB97BED08C1C3145F, 0xD8BC4CFE662C9E9B,
+	0x66AA1CE691A0637E, 0x74F5FAA73D409559, 0xDFF8E57F109D8CB9, 0xABEEEAD00690A394,
+	0xACEDBD2E42E31338, 0xBD78CCD90F0111D1, 0x1FCF684301E69BBC, 0xDB299FF3B2DDF925,
+	0xCB75894F323C2FB4, 0xB6B91F9C2F53BA7A, 0xA4B3D67ADBF1BA7B, 0xFE3FE6B45F7F0B6F,
+	0x6182994A1BE69CE6, 0xCE3D0E6B67460175, 0x7C7773C0C140D9CB, 0xB7918B418784F04B,
+	0xFE1C46843769598A, 0x002B09231E66AF95, 0xECAE3E21AAD2A288, 0x1B18FC934060A851,
+	0x02E625F17B93279E, 0xE5D79C517EECF217, 0x23B2A0DE7A55CDB0, 0x78483DB532A5DDC2,
+	0x1BEA46009F065233, 0xC98FE5DAADA13A72, 0x14EE6439C2F6F885, 0x01D7C8DC0307DCCC,
+	0x0F1BC00CD46AB0E3, 0x3763A7E236232C5D, 0x8B08F81A81DCB29E, 0xDA72D7F93E6631BB,
+	0xB2E3949447EAA372, 0x2B89050B486A7DD9, 0x0A7F820E8FC259B6, 0x8DBC1ADF6850B5D6,
+	0xABB388333F1DBD76, 0x727E69765DD497FF, 0x8BCC52506140AF0F, 0x4D4D9978868619A8,
+	0xB63345378C2B0B56, 0x5A668718B828E6A4, 0x1E92BF8CC5DF7E54, 0x6FED5AFCF7E7B513,
+	0xDC3886C497CD107A, 0xE34B7891111D5A88, 0x49D8C8255D020A28, 0x5C300ADD4C5DACAB,
+	0xEDDC253011443A16, 0x52CEB4515874AE87, 0x75DD4F37D2BC7584, 0xDF9AFE0D110D2733,
+	0x60AFEA26A5E088F7, 0x8C77FAE6C6B3D4B3, 0x2E258F85D879007D, 0x46662CF2A0AEE837,
+	0x71D097B0DF2E2D67, 0xFD497F46FBCF3897, 0xBFE6ABA5217B7530, 0x13A75BE10DAA8BE5,
+	0x9CD118A24EA0C2A5, 0x460BB2657740C936, 0x09405F0258BA2B4C, 0xF789644D8D198599,
+	0x3BF326E492AB84D0, 0xED049B1C6155EFFA, 0x8A812F81D115095E, 0x165297F2BCBB13CA,
+	0x35ED1EF5F75FF149, 0x4A7EC5224C10F2A5, 0x2BBF4F65121CFD35, 0xBDC2DCDB1A843BA5,
+	0x0BAF5EDE2F1D23A7, 0x6521D354C1542638, 0x224E45E86E768362, 0x3E5B5DE8C443A19D,
+	0x94D3BF55BAE9F8DF, 0xFDFC98E6D3E702BA, 0x378F0ED1753C7C5E, 0xA53B0008511B3D90,
+	0x93B5643125E6B00F, 0x14B33D6F48AC7C1A, 0xD1FF0128C3406B7C, 0x11D2FE8D2B6D5CF9,
+	0xBF00C61F0CEB9D51, 0x8E5B1B5115247382, 0xFF16613EF1039104, 0xD32E7953BEF2600A,
+	0xAD619ECF581F838B, 0xE4A3DEAEB0FED6E4, 0x461C6E59BB2B912B, 0x116C5FED42396861,
+	0xC6DEA054239AEC3F, 0x7A51C272E3ED8051, 0x5F8860760AFE9E39, 0xAC1F705CDE23E61A,
+	0xD10433D23E1E10AF, 0x641DD8600A341DA7, 0xF4CA4E301B909D9D, 0x8B039D7092B2CCCE,
+	0xF54F026289C845AA, 0x7A8867A81CD64D72, 0xC0B190EF85B70E53, 0x08AD3CB98C4C2BDB,
+	0x16ADDA8EEDF4995F, 0x056D42A363C79DD4, 0x03041B7D13A8539D, 0x00488873E3F69056,
+	0x8951A5F18058BF26, 0x8F10CE79B5F5E7C7, 0x51C5E555CB7D7C5C, 0x360E8FEB6A43277D,
+	0x805F16BB194E2E7D, 0x37420A1E357E8B54, 0xD41C5AE304FD7A6C, 0xDEE11C5CD8665A39,
+	0x5C32C26DE77D53AA, 0xDDD98F422B3891AF, 0x99621C3AC3C428F7, 0xF98C13B6D79A81A4,
+	0x109C999FE2A19883, 0x519F1DEEA2818C44, 0x8623D8DA24EA2F5E, 0x552D84BEA61EEE50,
+	0x152E14B873B5E557, 0x570DFE422816C83D, 0x0FE5AFDE0C3D1535, 0xA54CB686F2F01F49,
+	0x5B256BA16C17B1AD, 0x9CAFE199D005957F, 0xD7653AF9E4E37084, 0x148B7ECE60BD7479,
+	0x7BEB32BA294E0478, 0xB49AAF3A7DBC60F7, 0x76D6E7611D8CA50D, 0xBCA11C17466745B3,
+	0x79CFF170E60019C9, 0xDE8C32AD059AC0C7, 0x5FDA49B8BC13D8BF, 0x7CC5FD14DEBB9D49,
+	0xA549CAC6D9A8B189, 0x0B5483CD80F714F1, 0xB34FBF759B06A926, 0x792C160FF912A10A,
+	0xD9CDE4D5270E59BB, 0xDE58E85034D41D31, 0xF28B33650F54F374, 0x41FFE74429F0DDA9,
+	0x8AA7A3E39F8AF060, 0x1B1F16023C571F74, 0x2852773E77F39359, 0x22C76EF7D0E3363C,
+	0xF05DDA7B062C661F, 0x5F5F8A1B6DE9C404, 0x45C4DD3F107581FD, 0x3EFDDAF0306F1C81,
+	0x49C1E579CD105279, 0x832F22728AA1ACC7, 0xCF3FD0C5FE7F2472, 0x01C86080F06090E7,
+	0xB74A4EA76B2041CE, 0xF651B4DD1DB89B2F, 0xDD318B57874253C6, 0x9077CE1258DF2AF5,
+	0x5112D9D6CBE81489, 0xE8CEAE61255233A9, 0x4858357D2B9A018C, 0xED043D1CDB51B892,
+	0x88B1E2C0A1BD0D11, 0xC0C832F205DC108B, 0x3593A7D617C1CD15, 0x57654DE3BDCE132C,
+	0xDCA36CC79E50CC1F, 0x91DE9DAB49519ABB, 0x6AD5BFE782593306, 0x7A1126C0EF803AD6,
+	0x13707B51FCE7E12D, 0x439B8C59686A0662, 0xB2D017F7153CD6F0, 0x11E0E0E1A6B35CF3,
+	0xEE62F7131C98F61D, 0x54D736A56887BA47, 0xCA9A01FC4985E3AD, 0x1E509F0E88F23226,
+	0x43132756F111AD27, 0x5F3C731BDFCF856B, 0xDA7EC8E7BC86AAC8, 0xAB2DA87E2CBBE1BF,
+	0x00A1C327110D8FEC, 0x11C46747C881EB4F, 0xFAAB39220C2602A2, 0x276202D0F78D9430,
+	0xF9F20E443D3713BA, 0x1DC1C8AD3396206A, 0x767D7B7F52765BD0, 0x7CB958C61556BB7B,
+	0x559DC52D3E3BE1DF, 0x4C3995F5D131732A, 0x025B50FF3FDC3E62, 0x8BE082BE6F2E4A79,
+	0x6420C98F0C17A5FA, 0x8F6A4CC8C6C1A938, 0xA0AEECBD52AA0014, 0x5252AC503047CB12,
+	0x1DCE97D36DA90BDC, 0x09495E7837CAE109, 0x75711CFD9AEF6683, 0xFEC279C6D1F8469A,
+	0xD9D685336E3D8246, 0xB7ABE91D88D33DB1, 0xADEFA9BE9C8A6FD5, 0xB4104B5CBFE0BC4D,
+	0x088D62FD76D60E21, 0xF7F7E655F9E37420, 0x892E38056C5F9E9A, 0x142CCAFFC75DD9AC,
+	0x51D0544C86E56E12, 0xC52269ED15805293, 0x980331F15039BCB3, 0xDF4EA396DFD18154,
+	0xD3E6768F5178DFDA, 0xECA21308332D557A, 0xDACFF08A0645A239, 0x33D71569E005DF33,
+	0xD52AF334BE0EA7E0, 0x43B13178D3C122AF, 0x7F4066F5EDE1A3CE, 0xE7BDF64B85A0E7DA,
+	0x6105C71759F72862, 0x7C29285C99CA5C27, 0x052B0FDE883847D4, 0x7A707F99187B5DE8,
+	0x143C9D45B61C7AC0, 0x9666C49287EFD4D9, 0x0B0E1C861DF0F789, 0xE39497A57D30FC62,
+	0x15FECAE9ED096493, 0xAC7429A8DC39112A, 0x2D93B76D2E1FE988, 0x6FFF41ACA4D966DB,
+	0x5B37E580D9570B56, 0x3E94543B303F240F, 0xA2E1D8ED14153B94, 0x643E79CDC442AB1A,
+	0x396BCE8DFA9EDE78, 0x24EB087A1507A9DE, 0xDC82F04ADF19EE4E, 0x0E3D9A65F590EB7E,
+	0xF74BEFC5C37FCC44, 0x1F48343E2D507397, 0x1A5DD04057DB5C6E, 0x9E1FCCBC8B86C73B,
+	0xC35EA6BF28ABD43F, 0x65547718EAE2CB68, 0x036ED2013E455987, 0x30D020E40798FA2B,
+	0xB1CE243019E89C05, 0x84A110A6AB2814D5, 0xFD43DA93F9EAA07E, 0x7882BE69403B9CD8,
+	0x6960791EB29831C2, 0x0A17713E685EA58F, 0xAC367891EFCB0407, 0xB63AD8439D8000BB,
+	0x3258D9A7E6A37070, 0xE7458B3C904EA5D1, 0x73882D8668F91E20, 0xE968FA12F7DBBEAC,
+	0x26D8BE54B0838FB2, 0x088A7A2F0D6D5705, 0x33A36BF7AC15CD43, 0x770879D085CFB5CE,
+	0x80591A89C5F239DD, 0x467F64E8443D68AC, 0xC31DAF8BC227E4CB, 0x2CC0AB3A7D99AD63,
+	0x0663A818BA20E768, 0xF79EAA622FA9AEF7, 0x92E750DBF622636C, 0xE842002ABBEF0897,
+	0xA09EC3250CC5DE25, 0x90BF214CF7971397, 0x1EE2652DE252B040, 0x44B6F853954F1A7B,
+	0x29636395A20198E0, 0x88B6BEA9001D9AC0, 0x13F59667DE215E2C, 0x33E5B5DF2893ED18,
+	0xCEC11498D3933B17, 0xF8F73B81EE1CAB68, 0xAA9C377F52D9FBC3, 0x10BBE328C77E2EA0,
+	0xEAA146C15FB2DECC, 0x1E0877727E0E4FA2, 0x0A1D91CE0A269723, 0x382D9CEBD2E6C7AF,
+	0x3FC638F332D887D7, 0xE29B1434F82C0AF8, 0x8E2AB41C835ACDE0, 0xF7631084A2C97D38,
+	0x8CE42019CB8A8D9A, 0x18F4BE5AD82D8124, 0x0691EA9CCB978C0D, 0x6D6DE33664EF21E7,
+	0xACAB00829855C82E, 0xECFA4C6E798EE8A8, 0x57FB81DBF14D2EC8, 0xFB55619EA833736E,
+	0xF98DFD993D56A09C, 0xFAE001B3BD26E212, 0x43C8835610A1D2F6, 0x531AF54A831C2F3F,
+	0xD46BE11A322E9F2A, 0x9B5545A14F522C8A, 0x12F388F6EF6CF793, 0x84734E52FE8B494D,
+	0x88A774D55785E574, 0x5C26534F94EC755F, 0xFA56833F221A043B, 0xC1039791F4FAFD51,
+	0xF98264C0882B75DA, 0x5B6A806D6C6561CA, 0x866CBD9A562B589B, 0x3F2F8976E20F4DB1,
+	0x48B518ABD6CB5E4A, 0xD8E1CC881500A1A5, 0xF3B78238D5F10036, 0xF6145638C9C63FEE,
+	0x26556DC3E2E5AF45, 0x65969DBD89077760, 0x0BE9E951FA0E02F6, 0x0D5123266E6DAB3F,
+	0xC9CC85F4005FFB44, 0x985DE727C535A996, 0xD990628DF2708E62, 0xF316C255E2A97A26,
+	0xAAEFFCDE56F6B6C6, 0x1CCDDC9508882CEA, 0x7C59027C392C6130, 0x9AB3ACBCD385A39D,
+	0x26537AEAAB0A729A, 0x9A5BA6879345E9E4, 0xBC98A1E37D76A7D0, 0x576B23EECD9BC927,
+	0x59FF7BA6295138D9, 0xC10097F2DF28CC39, 0x1728F1780CFF73E1, 0x0310B00EEE6ED032,
+	0xFA5438913EA3C916, 0x91B12BE307FFEE4C, 0xCE706C5A07A8F6C1, 0x94E42C1A8327A7D3,
+	0xFC77A49C2F14D9B4, 0x83A5571E8FE8F8BE, 0xE2F8B96DCEF0DBCD, 0x53B9CC8056BDD88D,
+	0x7C41A4AF24C3CCBC, 0x5A51677CB13BDC6E, 0xA18E1CEF5ADAF971, 0xDCE062CEDD666275,
+	0x62DC5E20B61EA412, 0xE86F52FE4EF0A732, 0x4AAE24E7DD54AC15, 0xBABE887683D5EE46,
+	0x74CF021EC3500B1A, 0x2F02CC4CD60256D0, 0x6DDA04C550F29722, 0x1D483AFDD52F70C8,
+	0x67C7A802FC66262A, 0xB3DC2E4F7554C7C0, 0x5DFDD4BF2376D47F, 0x23444F3C1E0B03AE,
+	0xA03FD8D91268FBF9, 0xDF2FAE931A2CC007, 0x378D00D9807B396B, 0x3D295A23DE97A0CB,
+	0x3EEDE43DEB884A69, 0xDD45811396DEA2E7, 0xA206615508A4390C, 0x0558411B8DD71421,
+	0x6907BC02B4727098, 0x3DE8DDD1E8CA87B2, 0x39C17C9A9F5F8DD8, 0x0CADDECD2A51E1ED,
+	0x6697DF67BBD4959E, 0x938DD182E78B655F, 0x0F969C32C0C10370, 0xB23D073B4B4661DF,
+	0xF99964505D89533D, 0x46242DEF3D005254, 0x8684F0B9CBAA5D51, 0x6364E21C5B1E1C0E,
+	0xEA76BEC21919173A, 0x47403D0B483E2A1F, 0x83D322E5BC6A87A6, 0x37CFB9DC91EB7734,
+	0xF6D2930F44CB93E2, 0x4EF18EF04A2169AB, 0x7844FE614DEF70D9, 0x0997C12C196E1E7A,
+	0xDC3E173D261BC3FC, 0xE0C1AABD81602AFA, 0x39D76D8618E27FCD, 0xB985DA509DD13423,
+	0xAE7E7A2DB7DF48FD, 0x8B37BD58735A4DA2, 0xD8C514532FBFB29B, 0x27C4A49D223A05C8,
+	0x7B7240B5DF597C5B, 0x5DE099B7F7C2C976, 0xA54C3A8286D115C0, 0x13D63E913AFC6E5B,
+	0xA071531A46949FEF, 0xD9FA75A08962C8E0, 0x07AD06BE6D56566A, 0x3528FE9987F0E119,
+	0x9C890322B75D18D2, 0x93FDB7B8785B323C, 0x1BA862F8B7E5C822, 0xAAE5C88B849810E3,
+	0x13C93C06E7FA7E83, 0x5574E7E064DD2DD1, 0x8A99FE763EAE2687, 0x30A1C03253159A99,
+	0xF6855A6D9D768BA2, 0x4A5FE96CDE2BBBE0, 0x6119A519FF7D392A, 0x02C676238C9169A0,
+	0xF3129A8C3E4E27A3, 0x61BE9519253D1EA2, 0xBA6F885864B9D504, 0xD5A301F262AA24ED,
+	0xBDB83510386F263F, 0x5DDA5C36A7DED9D6, 0x0F5AE910A7368AE7, 0xF5A6C0EFD51261BA,
+	0x56F274C0EB4E68BE, 0x234FF4BC1FABEF23, 0x4CAF8790991FC73A, 0xF4B5C0F5C6F2E4A8,
+	0xBCC53840F333F0E2, 0x105695DEBD65CDC2, 0x8B7CA8B85E92F528, 0xEA70B5D15123F8A9,
+	0x39DC39FD5EC4D595, 0x4F3B7F115D4B6D21, 0x5389B24ED933DA1B, 0xF4E0191A402AEFEE,
+	0x2F79BBE510A5321B, 0xF59B3104789DE1F6, 0x79EFB3BCF6493808, 0x07D058C14495D77F,
+	0xF3B609DD5EDD8777, 0xD07095D10174865B, 0x23550F9271A257D2, 0xA158A15B9FABB6B1,
+	0xE616026028C3ACE2, 0xCC7C97EEC526E6F4, 0xBADE69EF3B96F664, 0x1506683351FE71C4,
+	0x0AFB5A1EE64669C4, 0xD8C76D02F0ACA70A, 0x452A7B8A9CE080F9, 0xBAE290E71638378E,
+	0xDA4581E30D4BBBB5, 0xDBDB5E676C566B73, 0x9255923D2AEBE6A1, 0x8F65BC4531E14D60,
+	0x066A3BCF5F9D820E, 0xA8C66FED067CF4D8, 0x50BCC168C658BDAB, 0x3EB3D2DFA67EC064,
+	0x18DD69E68BB15F80, 0x2752BBAB902A4A80, 0xCAA2CD7C1C532DD8, 0x701D95D26A7DE6F6,
+	0xF0F9602C46DCE802, 0x1099D55F2DED2077, 0xFC2B44128470ABED, 0x5C9EDA484FF3815D,
+	0x068B924D60E590BA, 0x4D42718D72F1F4CA, 0xD8EFDBC97981E858, 0x51DE5224C3ECF6CA,
+	0xE4C13B5869A0D52B, 0xA3323BB083F4965C, 0x095804942B781953, 0x00B11F02CE765686,
+	0xC7B25F1EE38DE5D6, 0x7F05DB5EDEAB95EB, 0x9E586B2006962231, 0xAFB9D917777DBBF8,
+	0x50460BD38CBA4BC0, 0xC5949FD5651D614C, 0xC19AF6110E2F82A6, 0x9491F07C5F081433,
+	0x2FBB3A1BE9B952E7, 0x12F533789DDEB0B1, 0x80E89A0CF8B9A780, 0xAB14EECCB7A603F9,
+	0xF35F09175582F31A, 0x7C8242673CD46135, 0x70F3955E5BB25410, 0x70EA2CAFB1CB836B,
+	0x0AAE72AF8CD79783, 0xA5BCD31A0D281F8F, 0xC80CAB9D94A88375, 0xEF119EDE96793874,
+	0x6F5400DC63E3FCBC, 0x2CBE4355244578AE, 0xD555EBED7C306D01, 0x16F1C7910B2052FE,
+	0x40C4BFE031E8FEAE, 0xB5307A82E154A977, 0xEDE7B9029BDD8D27, 0xA1E186DD3403E0DB,
+	0xBABF052F261E7A7F, 0xB6A6FF856BB6E07D, 0xCBBFB469C14A599D, 0x8A03F17DAC289F4B,
+	0x27390A7A628510EC, 0x45864037D56DE318, 0xB732BBF5718701CE, 0x3CD4B2A462FBD3FE,
+	0x58D3EFBC64EF12EA, 0x933FB1DD4C72999D, 0x6998668EA0752595, 0xDC955A8448DC1C33,
+	0x595478A51A8F4E97, 0xA6AF1F35E5D181BC, 0xE0797134CBC7E40F, 0x0623D2B5701BE484,
+	0x671331AB9EC323DD, 0x34D3CDAAA2D0DE99, 0xD1C1655A5A2F6238, 0xA74E6F974A53C997,
+	0x3657D5FF4EB15879, 0x6F7489596A997D5D, 0x142DC193D6895C31, 0x97A45F362DF02CE7,
+	0x258AF52AE0303BE9, 0x7C20EEE08B26ECC6, 0xAB22F86551CCD4D9, 0x36C5DA3C6CC937D9,
+	0x539947D53F58051E, 0xA29496B8E6ECC894, 0xA05310A9B6F5A24C, 0xCC38FB939E93827F,
+	0x334B91094D6AE59F, 0x1C6E99D80BE8D544, 0x9737631D9882D3F9, 0x7270673469D7AB88,
+	0xC5F92506128F7107, 0xE7D3F6FF1B2CA610, 0x8A9B52E2010E8EEF, 0x45A342D76A26E2E2,
+	0x95A32DE3D6261488, 0xEF6A491DDF4A0118, 0x2C9EACA34DA0E351, 0x62C7FEF09AE169A4,
+	0x860E1252332DF809, 0x0E02B67E3ADAFA47, 0x339A7064667BC6CC, 0xAF983A6689076F3C,
+	0x9DA27FE6B2C1BC19, 0x5133632408BF6ED4, 0x96F84F13BE0EC948, 0xE5ACD86F471135D7,
+	0xF07067815755E0D8, 0xC730A764409E09E7, 0x575B525187F27EF4, 0x0C9A288CC3513ECB,
+	0x56D16513A35E3DE8, 0x5F42710D38701C3F, 0xDE021D7C9D52EC09, 0x7C7D5A88E8E4D87B,
+	0x17891AB2BA114979, 0x10E606A62EF01F18, 0x3E4274A260DFFAC4, 0xDE98887339033D1A,
+	0x05DC954C01EFD316, 0x69C698078DFDBA24, 0x160E5C5A6C0971A8, 0x27DFC94AECAB33E7,
+	0x533A7D92A5F20F52, 0x6089DF10DD259F4C, 0xD66AF8FC464E834C, 0x19BA9E55932D5508,
+	0x7B601F4B755EC76B, 0xF26611E3AB9ECD9E, 0x63ED9D331EB1E804, 0xEC9677EE0EFA4D25,
+	0x9833957F09BC2482, 0x293AE3056BA6EC50, 0x10D9A77437161E85, 0xB6349BA118016DA3,
+	0xB8F22D6D2983624A, 0x204CD56270C913B7, 0x54597490E5A584F3, 0x5032C0A152D26268,
+	0x0BE8AD0BB478DFE1, 0x8C00AC906C623ABD, 0x60E12301E8327EAE, 0x4B545F3E790BE9A8,
+	0xA22B8A4B6BB87760, 0xD7DBEACB7B2B1C0A, 0xAD37BCBD3BCC55CA, 0xB70A8AA7375B7B0C,
+	0x4B23C723322E5456, 0x8CC8A3BDC26C68A5, 0xF598073A6C72EF39, 0x24F757828A5E8054,
+	0xF52E2920E6D35BCA, 0x02F65C8325A60C71, 0x550D599D6C7F07D9, 0x66A5A22E09403372,
+	0xDCB2C8FF3C0D61C7, 0xAB2FEAF773FF2AF1, 0x61751FEF2DAA33B3, 0x42C3DA74953A90EA,
+	0x2A316948AB5E2742, 0x86957537E8A53BC6, 0x4AD726ACEA4A5853, 0x8C15AAEB74978806,
+	0x12961D97917F1E33, 0xD2DCFB9D953FFF97, 0x84EDB219AD9635AE, 0x8F8A2278B7AB47C5,
+	0xEED659443789FED8, 0xB5C8FC4A4F5B79DB, 0x851C5236BFC5669A, 0x262C34878D59E990,
+	0xF280B6260E9E518F, 0xDF2C32EB894EB51D, 0x3D66584DF739B982, 0xE2C55A1C08BF4B6B,
+	0xCD4959BCC5D16929, 0xA6849CA64957B9F0, 0x4C4F9F9E140C8049, 0xD36CE362256F982E,
+	0xC240A8C9A7FA24F2, 0x0FBA7FE9B0EC99C6, 0x7F4B364632CB77A1, 0xB89A2EB44BA310EE,
+	0x1CFF74FA67857FBE, 0x7937AF2175EB4C58, 0x3E8A527D04079043, 0x69F91B6A836A0BB6,
+	0x58631E6E56398670, 0xCB3F531F98331150, 0x2A970D4DB3302FA7, 0xD081A879F67CFF5B,
+	0x1D62082FBB8B8265, 0x3AA102472B2FCBB6, 0x63730A5CC9E5509F, 0xAEDB1B21F93043CF,
+	0x41193B987418D8C5, 0xFFC93B79F945C532, 0x0A5CFB52399165AD, 0xF9AA6A5FC4BAAC26,
+	0x91E161D22554C97E, 0xD378349F42E158F4, 0x33FDF3FF7614CF70, 0x4CE94DC62A1F044D,
+	0x26374DAA6BB53DD8, 0x0874DAF8DE436095, 0xE388A719CEB4B279, 0x9777C29F9D539B25,
+	0x51BF6E9E0600CEE7, 0xDD572FDECD8EFA04, 0xB5BB7207AD603F3B, 0xA813EFBD858BDA93,
+	0x08F5E1283EC5A464, 0x7BAE7DF02DA53EC1, 0x49A808E4F2262268, 0x17B49FB25026F49E,
+	0x05937DD268D6C82A, 0xDCEF9953337523F6, 0x1D7AF8DB9B457F5F, 0xA8ED5E2BD405319E,
+	0x6C77CCCF9778A751, 0x20BE0B116BBD28AA, 0xE07E6DAE1F38BBB5, 0xEA92EDF0004309EA,
+	0x782E455DBC9E7F76, 0x22A4EE16AFAB53D2, 0x0EC567EAFB8193CD, 0xD00BC18C7044AD56,
+	0xA9BC084805521F5E, 0xF606364F34295F55, 0x047E3989025A4362, 0xCBA61B051A5F055F,
+	0xA2DD05ED784F6FC9, 0x73DB236061AE3C3C, 0xEC9811B53DAA0B27, 0xEA15CBAF8184B112,
+	0xCDB4D0F8C99D38D2, 0x44DE7D95B421E1A9, 0xE2B30D9815947EE7, 0xDE8FDE31E09CF015,
+	0x077B9AF961DD2BA5, 0xA6F898FD0F865F0A, 0xD9A709FD1E89BA34, 0x3A930E98EF69B266,
+	0xD3A41BB31D4FAE86, 0xDBB246710A9EE1F4, 0xF2C93C9E545AE17C, 0x67B2D8280609F98B,
+	0xA6D187730742448E, 0x0B2B4A809E464F6C, 0xF2096153EDFD1767, 0x465F1908AFB8F0C1,
+	0x4954D11EFF4EF546, 0x00E530EC1BDF79AE, 0x61D3B6DF57314DD1, 0x2EB15A858FA55041,
+	0x037B2F7161BA7E9F, 0x7218117EF47C95FA, 0xC15CBF1A65E9C630, 0x2F251E87C9193ABA,
+	0x5FED26A93B52737B, 0xAC118D82758DCD86, 0x33680E932CB76992, 0xFB6BA4B0F11F41A3,
+	0x2A3BD444EACB9B68, 0x7EC96ABD2025429C, 0x5F5FE93C95164A80, 0xA96BC8FB6D0BB54F,
+	0xF93802D826C8F99F, 0x7FFD5516C842A2C2, 0xAA5B1C58AF3812A6, 0x11976A44FD7B9A97,
+	0x25FAC28DD7B03E8C, 0x4D3A14B8B10D3C39, 0x3AE8505BE7F31F63, 0x17BFDD198C57F97A,
+	0xBD8F8E78169482AD, 0xD8E9C051A16AD3EF, 0x30182CBB6CA95606, 0x036C02D78C93D772,
+	0xB7DF18A6C6314981, 0xDFAFBC3E7C4A332E, 0xE8080EDA6E1B7A30, 0xE62A53936B8794BD,
+	0xA00BD7B8DF0344B1, 0x3173DBA78AFA2E21, 0x4F84DEA8D7F89E48, 0x7573B8C785923401
 };
 
-static const uint32 zobrist_constants_player = 0xf8bc7af8;
+static const uint64 zobrist_constants_player = 0x727F78D7F8BC7AF8;
 
-static const uint32 zobrist_constants_file[] = {
-	0x0ca9f308, 0xbd7edd5b, 0x6d107429, 0xa7bc360f,
-	0x9f1d0893, 0x148c1bac, 0xcf36d09a, 0x56e16ec1,
-	0xcb3c7e1a
+static const uint64 zobrist_constants_file[] = {
+	0xDE0EAB910CA9F308, 0x16BD95A5BD7EDD5B, 0xCA5EB98D6D107429, 0x0079C0F0A7BC360F,
+	0x71CAD6B69F1D0893, 0x7DC9AD0C148C1BAC, 0x5F2D4A1BCF36D09A, 0xF9926D8556E16EC1,
+	0xBAFF6B45CB3C7E1A
 };
 
-static const uint32 zobrist_constants_castling[] = {
-		0xcb3c7e1a, 0x79e87439, 0x53acfada, 0xc5edd270
+static const uint64 zobrist_constants_castling[] = {
+		0x73285E0BCB3C7E1A, 0x63802A7D79E87439, 0x19201C7F53ACFADA, 0x92FD21A5C5EDD270
 };
 
-uint32 zobrist_piece_tile(Piece piece, Tile tile, int width) {
+uint64 zobrist_piece_tile(Piece piece, Tile tile, int width) {
 	if (piece == Piece::NONE)
 		return 0;
 
@@ -216,14 +218,14 @@ uint32 zobrist_piece_tile(Piece piece, Tile tile, int width) {
 	return zobrist_constants_piece_tile[index];
 }
 
-uint32 zobrist_player() {
+uint64 zobrist_player() {
 	return zobrist_constants_player;
 }
 
-uint32 zobrist_file(int file) {
+uint64 zobrist_file(int file) {
 	return zobrist_constants_file[file];
 }
 
-uint32 zobrist_castling(Player player, CastlingType type) {
+uint64 zobrist_castling(Player player, CastlingType type) {
 	return zobrist_constants_castling[player * 2 + type];
 }
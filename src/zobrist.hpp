@@ -4,12 +4,12 @@
 #include "stdtypes.hpp"
 #include "Action.hpp"
 
-uint32 zobrist_piece_tile(Piece piece, Tile tile, int width);
+uint64 zobrist_piece_tile(Piece piece, Tile tile, int width);
 
-uint32 zobrist_player();
+uint64 zobrist_player();
 
-uint32 zobrist_file(int file);
+uint64 zobrist_file(int file);
 
-uint32 zobrist_castling(Player player, CastlingType type);
+uint64 zobrist_castling(Player player, CastlingType type);
 
 #endif // ZOBRIST_HPP